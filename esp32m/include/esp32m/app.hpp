@@ -23,10 +23,42 @@ namespace esp32m {
     static bool is(Event &ev, int level) {
       return ev.is(Type) && ((EventInit &)ev)._level == level;
     }
+    static bool is(Event &ev, int level, EventInit **init) {
+      if (!is(ev, level))
+        return false;
+      if (init)
+        *init = (EventInit *)&ev;
+      return true;
+    }
+    /**
+     * @brief Moves a slow initializer off the serial init path
+     * Deferred initializers of the same level run on a pool of
+     * CONFIG_ESP32M_INIT_WORKERS init workers once the event has been
+     * delivered to all subscribers, and the level completes only when all of
+     * them are done. Must be called from the event handler.
+     * @param name Name of the initializer, used for logging and in @p after
+     * @param fn Initialization function
+     * @param after Names of the initializers deferred at this level that
+     * must complete before this one starts, other names are ignored
+     */
+    void defer(const char *name, std::function<void()> fn,
+               std::initializer_list<const char *> after = {}) {
+      _deferred.push_back({name, fn, after});
+    }
 
    private:
+    struct Deferred {
+      const char *name;
+      std::function<void()> fn;
+      std::vector<const char *> after;
+      bool started = false;
+      bool done = false;
+    };
     EventInit(int level) : Event(Type), _level(level) {}
     int _level;
+    std::vector<Deferred> _deferred;
+    class Pool;
+    void runDeferred();
     constexpr static const char *Type = "init";
     friend class App;
   };
@@ -142,6 +174,12 @@ namespace esp32m {
     virtual JsonDocument *getState(RequestContext &ctx) {
       return nullptr;
     }
+    /** Objects with large states may return a producer that writes the state
+     * piece by piece instead of building it in getState(), state-get
+     * responses are then streamed */
+    virtual json::Producer stateProducer(RequestContext &ctx) {
+      return nullptr;
+    }
 
     bool handleConfigRequest(Request &req);
     virtual bool setConfig(RequestContext &ctx) {
@@ -247,7 +285,7 @@ namespace esp32m {
     std::string _defaultHostname;
     const char *_version;
     Props _props;
-    uint32_t _sketchSize, _wdtTimeout = 30;
+    uint32_t _sketchSize = 0, _wdtTimeout = 30;
     uint8_t _maxInitLevel = 0;
     uint8_t _curInitLevel = 0;
     std::unique_ptr<Config> _config;
@@ -257,6 +295,7 @@ namespace esp32m {
     App(const char *name, const char *verson);
     void init();
     void run();
+    uint32_t sketchSize();
   };
 
 }  // namespace esp32m
\ No newline at end of file
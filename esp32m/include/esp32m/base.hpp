@@ -4,6 +4,7 @@
 #include <driver/gpio.h>
 #include <esp_err.h>
 #include <hal/uart_types.h>
+#include <sdkconfig.h>
 #include <string.h>
 #include <cstdarg>
 #include <cstddef>
@@ -50,6 +51,19 @@ namespace esp32m {
       virtual ~Reader() = default;
       virtual size_t read(uint8_t* buf, size_t size) = 0;
     };
+    class Writer {
+     public:
+      virtual ~Writer() = default;
+      /**
+       * @brief Called once before the first @c write()
+       * @param offset Position in the source stream the data starts at,
+       * non-zero when resuming an interrupted transfer
+       */
+      virtual esp_err_t begin(size_t offset) {
+        return offset ? ESP_ERR_NOT_SUPPORTED : ESP_OK;
+      }
+      virtual size_t write(const uint8_t* buf, size_t size) = 0;
+    };
   }  // namespace stream
 
   template <typename F>
@@ -85,22 +99,110 @@ namespace esp32m {
     }*/
 
   namespace locks {
+    /**
+     * Index of a named lock in the registry. Ids are assigned on first use of
+     * a name and never change, resolve them once and keep them rather than
+     * looking locks up by name on every use.
+     */
+    typedef uint16_t Id;
+
+    /**
+     * Named mutex shared by independent objects that use the same bus or
+     * resource. Meets the Lockable requirements, so it can be used with
+     * std::lock_guard and std::unique_lock.
+     */
+    class Lock {
+     public:
+#if CONFIG_ESP32M_LOCK_STATS
+      struct Stats {
+        uint32_t acquisitions;
+        uint32_t contended;
+        uint32_t maxWaitUs;
+        uint32_t maxHoldUs;
+        // task that held the lock for maxHoldUs
+        char holder[CONFIG_FREERTOS_MAX_TASK_NAME_LEN];
+        // task that waited for maxWaitUs and the one that kept it waiting
+        char waiter[CONFIG_FREERTOS_MAX_TASK_NAME_LEN];
+        char blocker[CONFIG_FREERTOS_MAX_TASK_NAME_LEN];
+      };
+#endif
+      Lock(Id id, const char* name) : _id(id), _name(name) {}
+      Lock(const Lock&) = delete;
+      Id id() const {
+        return _id;
+      }
+      const char* name() const {
+        return _name.c_str();
+      }
+#if CONFIG_ESP32M_LOCK_STATS
+      void lock();
+      bool try_lock();
+      void unlock();
+      /**
+       * @brief Snapshot of the statistics. It is taken without acquiring the
+       * lock, so that a lock held for long (e.g. during OTA) does not stall the
+       * caller
+       */
+      Stats stats() const;
+      void resetStats();
+      /**
+       * @return Name of the task currently holding the lock, or @c nullptr
+       */
+      const char* owner() const;
+#else
+      void lock() {
+        _mutex.lock();
+      }
+      bool try_lock() {
+        return _mutex.try_lock();
+      }
+      void unlock() {
+        _mutex.unlock();
+      }
+#endif
+
+     private:
+      std::mutex _mutex;
+      const Id _id;
+      const std::string _name;
+#if CONFIG_ESP32M_LOCK_STATS
+      // updated by the holder only
+      Stats _stats = {};
+      char _owner[CONFIG_FREERTOS_MAX_TASK_NAME_LEN] = {};
+      int64_t _acquiredAt = 0;
+      void acquired();
+#endif
+    };
+
     class Guard {
      public:
       Guard(const char* name);
       Guard(gpio_num_t pin);
+      Guard(Id id);
       ~Guard();
 
      private:
-      std::mutex* _lock;
+      Lock* _lock;
     };
-    std::mutex& get(const char* name);
-    std::mutex* find(const char* name);
 
-    std::mutex& get(gpio_num_t pin);
-    std::mutex* find(gpio_num_t pin);
+    /**
+     * @brief Returns id of the lock with the given name, registering it if
+     * needed
+     */
+    Id id(const char* name);
+    /**
+     * @return Number of registered locks, ids are in [0, count())
+     */
+    Id count();
+    Lock& get(Id id);
+
+    Lock& get(const char* name);
+    Lock* find(const char* name);
+
+    Lock& get(gpio_num_t pin);
+    Lock* find(gpio_num_t pin);
 
-    std::mutex& uart(uart_port_t pin);
+    Lock& uart(uart_port_t pin);
   }  // namespace locks
 
   enum Endian { Little, Big };
@@ -6,6 +6,7 @@
 #include <driver/i2c_master.h>
 
 #include "esp32m/base.hpp"
+#include "esp32m/debug/trace.hpp"
 #include "esp32m/defs.hpp"
 #include "esp32m/logging.hpp"
 
@@ -68,11 +69,29 @@ namespace esp32m {
 
      private:
       MasterBus(i2c_master_bus_handle_t handle, i2c_master_bus_config_t& config)
-          : _handle(handle), _config(config) {
+          : _handle(handle),
+            _config(config),
+            _lock(locks::get(lockName(handle, config.i2c_port).c_str())) {
         _buses[handle] = this;
       }
+      static std::string lockName(i2c_master_bus_handle_t handle, int port) {
+        // with I2C_NUM_AUTO the driver picks the port, buses on different
+        // ports must not end up sharing the lock of port -1
+        for (int p = 0; port < 0 && p < I2C_NUM_MAX; p++) {
+          i2c_master_bus_handle_t h;
+          if (i2c_master_get_bus_handle((i2c_port_num_t)p, &h) == ESP_OK &&
+              h == handle)
+            port = p;
+        }
+        if (port < 0)
+          return string_printf("i2c@%p", handle);
+        return string_printf("i2c%d", port);
+      }
       i2c_master_bus_handle_t _handle;
       i2c_master_bus_config_t _config;
+      // held for a whole transaction including retries, the driver only
+      // serializes single transfers
+      locks::Lock& _lock;
       std::map<i2c_master_dev_handle_t, MasterDev*> _devices;
       std::mutex _devicesMutex;
       static std::map<i2c_master_bus_handle_t, MasterBus*> _buses;
@@ -106,6 +125,9 @@ namespace esp32m {
       i2c_master_dev_handle_t handle() const {
         return _handle;
       }
+      MasterBus* bus() const {
+        return _bus;
+      }
       uint16_t address() const {
         return _config.device_address;
       }
@@ -135,6 +157,8 @@ namespace esp32m {
                      size_t in_size)
 
       {
+        debug::trace::Span span("i2c-read");
+        std::lock_guard guard(_bus->_lock);
         esp_err_t res = withRetries([&]() {
           if (out_data && out_size)
             return i2c_master_transmit_receive(
@@ -147,6 +171,8 @@ namespace esp32m {
       }
       esp_err_t write(const void* out_reg, size_t out_reg_size,
                       const void* out_data, size_t out_size) {
+        debug::trace::Span span("i2c-write");
+        std::lock_guard guard(_bus->_lock);
         esp_err_t res = withRetries([&]() {
           esp_err_t local = ESP_ERR_INVALID_ARG;
           if (out_reg && out_reg_size && out_data && out_size) {
@@ -40,7 +40,7 @@ namespace esp32m {
       }
 
      protected:
-      std::mutex* _mutex;
+      locks::Lock* _mutex;
       void* _handle = nullptr;
       mb_communication_info_t _config = {};
       bool _configured = false, _running = false;
@@ -57,10 +57,19 @@ namespace esp32m {
                            bool ascii = false, uint8_t uartRxTimeout = 3,
                            uint32_t responseTimeoutMs = 3000);
 
+      uint8_t uartRxTimeout() const {
+        return _uartRxTimeout;
+      }
+      uint32_t responseTimeout() const {
+        return _responseTimeoutMs;
+      }
+
       esp_err_t start() override;
       esp_err_t stop() override;
+      /** With recover set, a timeout restarts the stack and repeats the
+       * request once. Probes leave it unset to fail fast on absent slaves */
       esp_err_t request(uint8_t addr, Command command, uint16_t reg_start,
-                        uint16_t reg_size, void* data);
+                        uint16_t reg_size, void* data, bool recover = true);
 
      private:
       Master() {}
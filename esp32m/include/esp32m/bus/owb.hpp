@@ -5,6 +5,7 @@
 #include <esp_err.h>
 #include <hal/gpio_types.h>
 
+#include "esp32m/base.hpp"
 #include "esp32m/defs.hpp"
 
 namespace esp32m {
@@ -83,7 +84,7 @@ namespace esp32m {
     Owb(gpio_num_t pin);
     Owb(const Owb &) = delete;
     ~Owb();
-    std::mutex &mutex() {
+    locks::Lock &mutex() {
       return _mutex;
     }
     esp_err_t reset(bool &present);
@@ -97,7 +98,7 @@ namespace esp32m {
 
    private:
     owb::IDriver *_driver;
-    std::mutex &_mutex;
+    locks::Lock &_mutex;
     friend class owb::Search;
   };
 
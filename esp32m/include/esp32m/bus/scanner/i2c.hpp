@@ -31,9 +31,13 @@ namespace esp32m {
         int _startId = 3, _endId = 120;
         uint8_t _ids[16];
         uint32_t _freq = 100000;
+        volatile bool _cancel = false;
+        // the bus timed out or could not be set up, the ids are incomplete
+        bool _aborted = false;
         I2C() {};
         void run();
-        void scan();
+        bool scan();
+        void publishScan(int progress, bool partial, bool cancelled = false);
       };
 
       I2C *useI2C();
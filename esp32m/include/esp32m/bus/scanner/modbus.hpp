@@ -4,6 +4,8 @@
 #include "esp32m/bus/modbus.hpp"
 #include "sdkconfig.h"
 
+#include <vector>
+
 namespace esp32m {
   namespace bus {
     namespace scanner {
@@ -23,6 +25,14 @@ namespace esp32m {
         void handleEvent(Event &ev) override;
 
        private:
+        struct Serial {
+          uint32_t baud;
+          uart_parity_t parity;
+        };
+        struct Found {
+          uint8_t addr;
+          Serial serial;
+        };
         TaskHandle_t _task = nullptr;
         Response *_pendingResponse = nullptr;
         int _startAddr = 1, _endAddr = 247, _addr = 1;
@@ -38,8 +48,23 @@ namespace esp32m {
         bool _ascii = false;
         uint8_t _addrs[32];
         void *_data = nullptr;
+        // also sweep the most common serial settings after the configured one
+        bool _auto = false;
+        // response timeout until a slave reply could be timed, ms
+        uint32_t _timeout = 500;
+        volatile bool _cancel = false;
+        bool _resume = false;
+        // where a cancelled scan resumes
+        int _serialIdx = 0, _nextAddr = 0;
+        // slave turnaround measured on the first reply, ms
+        int _turnaround = -1;
+        std::vector<Found> _found;
         Modbus();
         void run();
+        std::vector<Serial> serials();
+        uint32_t responseTimeout(uint32_t baud);
+        bool scan();
+        void publishScan(int progress, bool partial, bool cancelled = false);
       };
 
       Modbus *useModbus();
@@ -3,27 +3,39 @@
 #include <esp_twai.h>
 #include <esp_twai_onchip.h>
 
+#include <atomic>
 #include <functional>
 #include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
 #include <freertos/task.h>
 
+#include "esp32m/bus/twai/router.hpp"
 #include "esp32m/logging.hpp"
 
 namespace esp32m {
 
-  class TWAI {
+  class TWAI : public twai::Node {
    public:
     using RxCallback = std::function<void(twai_frame_t*)>;
+    // Called from the RX task with the number of frames the node finished
+    // transmitting since the last call
+    using TxDoneCallback = std::function<void(int)>;
+    struct Stats {
+      uint32_t rx, drops, busErrors, txDone, transitions;
+      twai_error_state_t state;
+    };
 
     // If rxCallback is non-null the RX pipeline is set up: native event
     // callbacks are registered, a pool of poolDepth frame slots is allocated,
-    // and a dedicated task is spawned to dispatch received frames to rxCallback.
+    // and a dedicated task is spawned to dispatch received frames to rxCallback,
+    // all the frames that are ready at once.
     // If rxCallback is null none of that happens (TX-only or externally managed
     // receive).
     TWAI(twai_node_handle_t handle, RxCallback rxCallback = nullptr,
          int poolDepth = 32);
     virtual ~TWAI();
+    // Deletes the node and waits for the RX task to finish the callback it
+    // may be running, neither callback is called afterwards
+    void stop();
 
     esp_err_t enable(bool en) {
       return en ? twai_node_enable(_handle) : twai_node_disable(_handle);
@@ -38,6 +50,16 @@ namespace esp32m {
     esp_err_t transmit(const twai_frame_t* frame, int timeout_ms) {
       return twai_node_transmit(_handle, frame, timeout_ms);
     }
+    esp_err_t transmit(const twai_frame_t* frame) override {
+      return twai_node_transmit(_handle, frame, 0);
+    }
+    // Must be set before the node is enabled
+    void onTxDone(TxDoneCallback cb) {
+      _txDoneCallback = std::move(cb);
+    }
+    Stats stats() const {
+      return {_rx, _drops, _busErrors, _txDone, _transitions, _state};
+    }
     esp_err_t waitTxDone(int timeout_ms) {
       return twai_node_transmit_wait_all_done(_handle, timeout_ms);
     }
@@ -49,6 +71,7 @@ namespace esp32m {
    protected:
     twai_node_handle_t _handle;
     RxCallback _rxCallback;
+    TxDoneCallback _txDoneCallback;
 
    private:
     // One pool slot holds a twai_frame_t together with its inline data buffer
@@ -59,18 +82,32 @@ namespace esp32m {
       uint8_t data[TWAI_FRAME_MAX_LEN];
     };
 
+    // Notification bits the ISRs wake the task with
+    static const uint32_t NotifyRx = 1;
+    static const uint32_t NotifyTx = 2;
+    static const uint32_t NotifyStop = 4;
+
+    // The pool is a single-producer single-consumer ring: the ISR advances
+    // _writeIdx, the task advances _readIdx, one slot is always left empty.
     int _poolDepth = 0;
     PoolSlot* _pool = nullptr;
-    SemaphoreHandle_t _freeSem = nullptr;   // counts free (writable) slots
-    SemaphoreHandle_t _readySem = nullptr;  // counts ready (readable) slots
     TaskHandle_t _task = nullptr;
-    int _writeIdx = 0;
-    int _readIdx = 0;
+    std::atomic<bool> _exited = false;
+    std::atomic<int> _writeIdx = 0;
+    std::atomic<int> _readIdx = 0;
+
+    std::atomic<uint32_t> _rx = 0, _drops = 0, _busErrors = 0, _txDone = 0,
+                          _transitions = 0;
+    std::atomic<twai_error_state_t> _state = TWAI_ERROR_ACTIVE;
+    uint32_t _txReported = 0;
 
     // ISR-context callbacks registered with twai_node_register_event_callbacks
     static bool IRAM_ATTR rxIsr(twai_node_handle_t handle,
                                 const twai_rx_done_event_data_t* edata,
                                 void* ctx);
+    static bool IRAM_ATTR txIsr(twai_node_handle_t handle,
+                                const twai_tx_done_event_data_t* edata,
+                                void* ctx);
     static bool IRAM_ATTR errorIsr(twai_node_handle_t handle,
                                    const twai_error_event_data_t* edata,
                                    void* ctx);
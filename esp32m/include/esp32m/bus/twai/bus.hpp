@@ -0,0 +1,49 @@
+#pragma once
+
+#include "esp32m/app.hpp"
+#include "esp32m/bus/twai.hpp"
+#include "esp32m/bus/twai/router.hpp"
+
+namespace esp32m {
+  namespace twai {
+
+    /**
+     * A TWAI node with a Router on top: received frames go to the handlers
+     * registered with router().on(), send() queues frames for a task that
+     * feeds the node. Traffic and error counters are reported as state.
+     */
+    class Bus : public AppObject {
+     public:
+      Bus(const char *name, twai_node_handle_t handle, int poolDepth = 32,
+          int txDepth = 32);
+      Bus(const Bus &) = delete;
+      ~Bus() override;
+      const char *name() const override {
+        return _name;
+      }
+      TWAI &node() {
+        return _twai;
+      }
+      Router &router() {
+        return _router;
+      }
+      esp_err_t send(const twai_frame_t &frame, uint8_t priority = 0);
+
+     protected:
+      JsonDocument *getState(RequestContext &ctx) override;
+
+     private:
+      const char *_name;
+      Router _router;
+      TWAI _twai;
+      TaskHandle_t _task = nullptr;
+      volatile bool _stopped = false, _exited = false;
+      uint32_t _lastRx = 0, _lastTx = 0;
+      int64_t _lastStamp = 0;
+      void run();
+    };
+
+    Bus *useBus(const char *name, twai_node_handle_t handle);
+
+  }  // namespace twai
+}  // namespace esp32m
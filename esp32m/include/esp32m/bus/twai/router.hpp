@@ -0,0 +1,96 @@
+#pragma once
+
+#include <esp_err.h>
+#include <esp_twai_types.h>
+
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace esp32m {
+  namespace twai {
+
+    /**
+     * Transmit side of a TWAI node as seen by the Router. transmit() must
+     * not block, the frame and its buffer stay valid until the node reports
+     * completion via Router::txDone()
+     */
+    class Node {
+     public:
+      virtual ~Node() = default;
+      virtual esp_err_t transmit(const twai_frame_t *frame) = 0;
+    };
+
+    /**
+     * Dispatches received frames to handlers registered per ID or ID/mask
+     * pair, and queues outgoing frames by priority with optional per-ID
+     * rate limits. Exact IDs are looked up in a hash table, masked handlers
+     * are tried in the order they were added, after the exact ones.
+     * Handlers run in the receiving task and must not register or remove
+     * handlers themselves.
+     */
+    class Router {
+     public:
+      typedef std::function<void(const twai_frame_t &)> Handler;
+      struct Stats {
+        uint32_t rx, unhandled, tx, txDropped, txLimited;
+      };
+      static const uint32_t ExactMask = 0x1FFFFFFF;
+
+      Router(Node *node, int txDepth = 32, int inFlight = 4);
+      Router(const Router &) = delete;
+      int on(uint32_t id, Handler handler) {
+        return on(id, ExactMask, handler);
+      }
+      int on(uint32_t id, uint32_t mask, Handler handler);
+      void off(int handle);
+      void dispatch(const twai_frame_t &frame);
+
+      /** Queues a copy of the frame. Lower priority values go first, then
+       * lower IDs, then the order of sending */
+      esp_err_t send(const twai_frame_t &frame, uint8_t priority = 0);
+      /** Frames with this ID leave at most once per interval, 0 removes the
+       * limit */
+      void setRateLimit(uint32_t id, uint32_t intervalUs);
+      /** Hands due frames to the node. Returns microseconds until the next
+       * rate limited frame is due, or -1 if nothing is waiting for time */
+      int64_t pump(int64_t now);
+      int64_t pump();
+      /** Releases frames the node has finished with, oldest first */
+      void txDone(int count = 1);
+      size_t queued();
+      Stats stats();
+
+     private:
+      struct Route {
+        int handle;
+        uint32_t id, mask;
+        Handler handler;
+      };
+      struct Slot {
+        twai_frame_t frame;
+        uint8_t data[TWAI_FRAME_MAX_LEN];
+        uint8_t priority;
+        bool limited;
+        uint32_t seq;
+      };
+      Node *_node;
+      int _inFlightMax;
+      std::mutex _rxMutex, _txMutex;
+      std::unordered_map<uint32_t, std::vector<Route> > _exact;
+      std::vector<Route> _masked;
+      int _nextHandle = 0;
+      std::vector<Slot> _slots;
+      std::vector<int> _free, _queue;
+      std::deque<int> _inFlight;
+      std::map<uint32_t, std::pair<uint32_t, int64_t> > _limits;
+      uint32_t _seq = 0;
+      Stats _stats = {};
+      bool before(int a, int b) const;
+    };
+
+  }  // namespace twai
+}  // namespace esp32m
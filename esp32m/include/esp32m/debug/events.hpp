@@ -0,0 +1,36 @@
+#pragma once
+
+#include "esp32m/app.hpp"
+
+namespace esp32m {
+
+  namespace debug {
+    /*
+     * CONFIG_ESP32M_EVENTS_PROFILE=y must be set in sdkconfig to use this
+     * class. The state lists, for every event type, the number of dispatches,
+     * total and max dispatch time and the histogram of dispatch times, and for
+     * every subscriber the number of calls, total and max time spent in its
+     * callback. All times are in microseconds. Nested publishing is included
+     * in the time of the outer event and handler.
+     */
+    class Events : public AppObject {
+     public:
+      Events(const Events &) = delete;
+      static Events &instance();
+      const char *name() const override {
+        return "events";
+      }
+
+     protected:
+      bool handleRequest(Request &req) override;
+      JsonDocument *getState(RequestContext &ctx) override;
+
+     private:
+      Events() {}
+    };
+
+    Events *useEvents();
+
+  }  // namespace debug
+
+}  // namespace esp32m
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+#include "esp32m/app.hpp"
+
+namespace esp32m {
+
+  namespace debug {
+
+    namespace heap {
+      /**
+       * Hot allocation sites of the library. Allocations made there are
+       * counted when CONFIG_ESP32M_HEAP_SITES=y, otherwise track() compiles
+       * to nothing.
+       */
+      enum class Site : uint8_t {
+        LogMessage,
+        JsonParse,
+        HttpdSend,
+        MqttIncoming,
+        MAX
+      };
+
+#if CONFIG_ESP32M_HEAP_SITES
+      void track(Site site, size_t bytes);
+      /**
+       * ArduinoJson allocator that attributes the memory of the documents it
+       * backs to the given site
+       */
+      ArduinoJson::Allocator *allocator(Site site);
+#else
+      inline void track(Site site, size_t bytes) {}
+#endif
+    }  // namespace heap
+
+    /**
+     * Records free, minimum free and largest free block of the internal, DMA
+     * and SPIRAM heaps every `interval` seconds into a ring of `depth`
+     * samples, available via the `history` request. The state reports the
+     * latest sample with fragmentation (percentage of free memory outside of
+     * the largest block) and, if enabled, the allocation site counters.
+     */
+    class Heap : public AppObject {
+     public:
+      Heap(const Heap &) = delete;
+      static Heap &instance();
+      const char *name() const override {
+        return "heap";
+      }
+
+     protected:
+      bool handleRequest(Request &req) override;
+      void handleEvent(Event &ev) override;
+      JsonDocument *getState(RequestContext &ctx) override;
+      bool setConfig(RequestContext &ctx) override;
+      JsonDocument *getConfig(RequestContext &ctx) override;
+
+     private:
+      struct Sample {
+        uint32_t free;
+        uint32_t min;
+        uint32_t largest;
+      };
+      static constexpr int Caps = 3;
+      // Caps * sizeof(Sample) bytes per sample
+      static constexpr uint16_t MaxDepth = 360;
+      std::mutex _mutex;
+      // sampling period in seconds, 0 disables the sampler
+      uint16_t _interval = 10;
+      uint16_t _depth = 60;
+      std::unique_ptr<Sample[]> _samples;
+      uint32_t _seq = 0;
+      unsigned long _stamp = 0;
+      Heap() {}
+      void sample();
+      JsonDocument *history(size_t last);
+    };
+
+    Heap *useHeap();
+
+  }  // namespace debug
+
+}  // namespace esp32m
\ No newline at end of file
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "esp32m/app.hpp"
+
+namespace esp32m {
+
+  namespace debug {
+    /*
+     * Lists the named locks from locks::get(). With CONFIG_ESP32M_LOCK_STATS=y
+     * every entry also has the number of acquisitions and contended
+     * acquisitions, the longest wait and hold times in microseconds, the tasks
+     * involved in them and the current owner.
+     */
+    class Locks : public AppObject {
+     public:
+      Locks(const Locks &) = delete;
+      static Locks &instance();
+      const char *name() const override {
+        return "locks";
+      }
+
+     protected:
+      bool handleRequest(Request &req) override;
+      JsonDocument *getState(RequestContext &ctx) override;
+
+     private:
+      Locks() {}
+    };
+
+    Locks *useLocks();
+
+  }  // namespace debug
+
+}  // namespace esp32m
\ No newline at end of file
@@ -15,7 +15,7 @@ namespace esp32m {
       }
 
      protected:
-      JsonDocument *getState(RequestContext &ctx) override;
+      json::Producer stateProducer(RequestContext &ctx) override;
 
      private:
       Partitions() {}
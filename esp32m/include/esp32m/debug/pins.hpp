@@ -50,6 +50,26 @@ namespace esp32m {
           delete doc;
           return true;
         }
+        if (req.is("pwm")) {
+          // which backend every allocated PWM channel ended up with
+          auto doc = new JsonDocument();
+          auto root = doc->to<JsonObject>();
+          for (auto const& [name, pins] : pins::getProviders())
+            for (int i = 0; i < pins->count(); i++) {
+              auto pin = pins->pin(i);
+              if (!pin || pin->featureStatus(pin::Type::PWM) !=
+                              pin::FeatureStatus::Enabled)
+                continue;
+              auto pwm = pin->pwm();
+              auto entry = root[name][pin->name()].to<JsonObject>();
+              entry["backend"] = pwm->backend();
+              entry["freq"] = pwm->getFreq();
+              entry["enabled"] = pwm->isEnabled();
+            }
+          req.respond(root, false);
+          delete doc;
+          return true;
+        }
         if (req.is("feature")) {
           auto data = req.data().as<JsonArrayConst>();
           auto pin = toPin(data[0]);
@@ -220,6 +240,7 @@ namespace esp32m {
                   state["enabled"] = pwm->isEnabled();
                   state["freq"] = pwm->getFreq();
                   state["duty"] = pwm->getDuty();
+                  state["backend"] = pwm->backend();
                 }
               } break;
               case pin::Type::Pcnt: {
@@ -232,6 +253,7 @@ namespace esp32m {
                   auto sampler = pcnt->getSampler();
                   if (sampler) {
                     state["freq"] = sampler->getFreq();
+                    state["reciprocal"] = sampler->isReciprocal();
                   }
                   pcnt_channel_edge_action_t pea, nea;
                   if (pcnt->getEdgeAction(pea, nea) == ESP_OK) {
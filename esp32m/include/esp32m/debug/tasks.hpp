@@ -1,5 +1,12 @@
 #pragma once
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "esp32m/app.hpp"
 
 namespace esp32m {
@@ -9,9 +16,24 @@ namespace esp32m {
      * CONFIG_FREERTOS_USE_TRACE_FACILITY=y must be set in sdkconfig to use this
      * class. Additionally, CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS=y provides
      * CPU usage info
+     *
+     * Besides the one-shot snapshot in the state, every `interval` seconds the
+     * load of each task and core is recorded into a ring of `depth` samples,
+     * available via the `history` request. Tasks whose load exceeds
+     * `loadAlarm` percent or whose stack margin drops below `stackAlarm` bytes
+     * are flagged and reported to the log.
      */
     class Tasks : public AppObject {
      public:
+      enum Flags : uint8_t {
+        None = 0,
+        // load of the last sample is above the threshold
+        LoadAlarm = 1 << 0,
+        // stack high water mark is below the threshold
+        StackAlarm = 1 << 1,
+        // task no longer exists, kept until its samples roll out
+        Gone = 1 << 2,
+      };
       Tasks(const Tasks &) = delete;
       static Tasks &instance();
       const char *name() const override {
@@ -19,10 +41,48 @@ namespace esp32m {
       }
 
      protected:
-      JsonDocument *getState(RequestContext &ctx) override;
+      bool handleRequest(Request &req) override;
+      void handleEvent(Event &ev) override;
+      json::Producer stateProducer(RequestContext &ctx) override;
+      bool setConfig(RequestContext &ctx) override;
+      JsonDocument *getConfig(RequestContext &ctx) override;
 
      private:
+      struct Track {
+        TaskHandle_t handle;
+        UBaseType_t number;
+        char name[configMAX_TASK_NAME_LEN];
+        uint32_t counter;
+        // lowest stack high water mark seen so far, and when it last dropped
+        uint32_t stackMin;
+        unsigned long stackDropped;
+        // number of samples above the load threshold, and the last one
+        uint32_t spikes;
+        unsigned long spiked;
+        // sequence number of the last sample this task was present in
+        uint32_t seen;
+        uint8_t flags;
+        // load in percent of a single core, one byte per sample
+        std::unique_ptr<uint8_t[]> load;
+      };
+      // one byte per sample for every task and core
+      static constexpr uint16_t MaxDepth = 600;
+      std::mutex _mutex;
+      // sampling period in seconds, 0 disables the sampler
+      uint16_t _interval = 1;
+      uint16_t _depth = 120;
+      uint8_t _loadAlarm = 90;
+      uint16_t _stackAlarm = 512;
+      std::vector<TaskStatus_t> _status;
+      std::vector<Track> _tracks;
+      std::unique_ptr<uint8_t[]> _cores;
+      uint32_t _total = 0;
+      uint32_t _seq = 0;
+      unsigned long _stamp = 0;
       Tasks() {}
+      void sample();
+      void reset();
+      JsonDocument *history(size_t last);
     };
 
     Tasks *useTasks();
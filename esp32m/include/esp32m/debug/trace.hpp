@@ -0,0 +1,82 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <memory>
+
+#include "esp32m/base.hpp"
+#include "esp32m/ui/asset.hpp"
+
+namespace esp32m {
+
+  namespace debug {
+
+    namespace trace {
+      enum class Phase : uint8_t {
+        Begin = 'B',
+        End = 'E',
+        Instant = 'i',
+      };
+
+#if CONFIG_ESP32M_TRACE
+      /**
+       * Appends a record to the trace ring, overwriting the oldest one.
+       * Lock-free, may be called from any task or ISR. @p name is stored by
+       * pointer and must outlive the record: string literals, event types and
+       * object names are fine.
+       */
+      void record(Phase phase, const char *name);
+#else
+      inline void record(Phase phase, const char *name) {}
+#endif
+
+      inline void begin(const char *name) {
+        record(Phase::Begin, name);
+      }
+      inline void end(const char *name) {
+        record(Phase::End, name);
+      }
+      inline void instant(const char *name) {
+        record(Phase::Instant, name);
+      }
+
+      /**
+       * Records a span covering the lifetime of this object
+       */
+      class Span {
+       public:
+        Span(const char *name) : _name(name) {
+          begin(name);
+        }
+        Span(const Span &) = delete;
+        ~Span() {
+          end(_name);
+        }
+
+       private:
+        const char *_name;
+      };
+    }  // namespace trace
+
+    /**
+     * Serves a snapshot of the trace ring at /debug/trace.json in Chrome trace
+     * event format, ready to be opened in chrome://tracing or Perfetto UI.
+     * CONFIG_ESP32M_TRACE=y must be set in sdkconfig for the asset to be
+     * registered.
+     */
+    class Trace : public ui::ReadableAsset {
+     public:
+      Trace(const Trace &) = delete;
+      static Trace &instance();
+      std::unique_ptr<stream::Reader> createReader() const override;
+
+     private:
+      Trace();
+    };
+
+    Trace *useTrace();
+
+  }  // namespace debug
+
+}  // namespace esp32m
\ No newline at end of file
@@ -33,12 +33,14 @@ namespace esp32m {
       JsonDocument *getConfig(RequestContext &ctx) override;
       JsonDocument *getState(RequestContext &ctx) override;
       virtual float compute(int pcnt, int ms);
+      virtual float fromFreq(float hz);
 
      private:
       const char *_name;
       io::IPin *_pin;
       float _value = NAN;
       float _consumption = 0, _dumpedConsumption = 0;
+      int _count = 0;
       unsigned long _stamp = 0, _lastDump = 0;
       Sensor _sensorFlow, _sensorConsumption;
     };
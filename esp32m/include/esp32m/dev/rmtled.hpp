@@ -7,34 +7,102 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #include "esp32m/defs.hpp"
 
 #include "led_strip.h"
 
 namespace esp32m {
   namespace dev {
+    /**
+     * Addressable LED strip. Frames are rendered at a fixed rate into a
+     * back buffer and only pushed to the strip when they differ from the one
+     * on display.
+     */
     class Rmtled : public Device {
      public:
-      Rmtled(gpio_num_t pin);
+      enum class Effect {
+        Diag,    // blink diagnostic codes on the first pixel
+        Solid,   // whole strip in one color
+        Fade,    // whole strip breathing in one color
+        Chase,   // a dot with a fading tail running along the strip
+        Status,  // segments showing the state of subsystems
+      };
+      enum class Status { Off, Ok, Busy, Warning, Error };
+      struct Color {
+        uint8_t r, g, b;
+        bool operator==(const Color &) const = default;
+      };
+      Rmtled(gpio_num_t pin, int count = 1);
       Rmtled(const Rmtled &) = delete;
+      ~Rmtled();
       const char *name() const override {
         return "rmtled";
       }
+      int count() const {
+        return _count;
+      }
+      void setEffect(Effect effect);
+      Effect getEffect() const {
+        return _effect;
+      }
+      void setColor(Color color);
+      // duration of one fade or chase cycle, ms
+      void setPeriod(uint32_t ms);
+      void setBrightness(uint8_t brightness);
+      void setFps(int fps);
+      /**
+       * Maps pixels [first, first+count) to a subsystem shown by the Status
+       * effect, returns the segment index or -1
+       */
+      int addSegment(const char *name, int first, int count);
+      void setStatus(int segment, Status status);
+
      protected:
-      bool handleRequest(Request &req) override; 
+      bool handleRequest(Request &req) override;
+      JsonDocument *getState(RequestContext &ctx) override;
+      void setState(RequestContext &ctx) override;
+      JsonDocument *getConfig(RequestContext &ctx) override;
+      bool setConfig(RequestContext &ctx) override;
 
      private:
+      struct Segment {
+        const char *name;
+        int first, count;
+        Status status;
+      };
+      struct Diag {
+        uint8_t codes[10];
+        int count, pos, blinks;
+        bool on;
+        uint32_t until;
+      };
       gpio_num_t _pin;
-      uint32_t _led_color[3] = { 0, 0, 16 };  // Red, Green, Blue  (0-255) 
+      int _count;
+      std::mutex _mutex;
+      Effect _effect = Effect::Diag;
+      Color _color = {0, 0, 16};
+      uint32_t _period = 2000;
+      uint8_t _brightness = 255;
+      int _fps = 30;
+      std::vector<Segment> _segments;
+      std::unique_ptr<Color[]> _front, _back;
+      bool _pushed = false;
+      Diag _diag = {};
       TaskHandle_t _task = nullptr;
-      led_strip_handle_t led_strip;
+      led_strip_handle_t led_strip = nullptr;
       void configure_led();
       void init();
       void run();
-      void blink(int count);
+      void render(uint32_t now);
+      bool diagLit(uint32_t now);
+      esp_err_t push();
     };
 
-    Rmtled *useRmtled(gpio_num_t pin);
+    Rmtled *useRmtled(gpio_num_t pin, int count = 1);
 
   }  // namespace dev
-}  // namespace esp32m
\ No newline at end of file
+}  // namespace esp32m
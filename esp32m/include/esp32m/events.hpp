@@ -5,8 +5,49 @@
 #include <mutex>
 #include <vector>
 
+#include <sdkconfig.h>
+
+#if CONFIG_ESP32M_EVENTS_PROFILE
+#include <map>
+#include <string>
+#endif
+
 namespace esp32m {
 
+#if CONFIG_ESP32M_EVENTS_PROFILE
+  namespace debug {
+    class Events;
+  }
+
+  namespace events {
+    /**
+     * @brief Cumulative timing of event callbacks, in microseconds
+     */
+    struct Timing {
+      uint32_t calls = 0;
+      uint32_t max = 0;
+      uint64_t total = 0;
+      void add(uint32_t us) {
+        calls++;
+        total += us;
+        if (us > max)
+          max = us;
+      }
+    };
+
+    /**
+     * @brief Timing of the complete dispatch of one event type, with a
+     * histogram of dispatch durations. Bucket @c i counts dispatches that took
+     * less than 4^(i+1) us, the last bucket collects everything above.
+     */
+    struct Dispatch : Timing {
+      static constexpr int Buckets = 8;
+      uint32_t histogram[Buckets] = {};
+      void add(uint32_t us);
+    };
+  }  // namespace events
+#endif
+
   /**
    * @brief Base class for events. May be subclassed to add custom properties
    * and logic to custom events
@@ -56,10 +97,27 @@ namespace esp32m {
      * @brief delete this subscription to un-subscribe
      */
     ~Subscription();
+#if CONFIG_ESP32M_EVENTS_PROFILE
+    /**
+     * @brief Sets the name this subscriber is reported under in the event
+     * timing statistics
+     */
+    void setName(const char *name) {
+      _name = name;
+    }
+    const char *name() const {
+      return _name;
+    }
+#endif
 
    private:
     Callback _cb;
     uint8_t _refcnt;
+#if CONFIG_ESP32M_EVENTS_PROFILE
+    const char *_name = nullptr;
+    events::Timing _timing;
+    friend class debug::Events;
+#endif
     Subscription(Callback cb) : _cb(cb), _refcnt(0) {}
     void ref() {
       _refcnt++;
@@ -94,6 +152,12 @@ namespace esp32m {
     EventManager() {}
     std::vector<Subscription *> _subscriptions;
     std::mutex _mutex;
+#if CONFIG_ESP32M_EVENTS_PROFILE
+    std::map<std::string, events::Dispatch, std::less<>> _dispatches;
+    void dispatched(Event &event, int64_t started);
+    friend class debug::Events;
+#endif
+    void dispatch(Subscription *sub, Event &event);
     void unsubscribe(const Subscription *sub);
     friend class Subscription;
   };
@@ -49,6 +49,13 @@ namespace esp32m {
     void respond();
     void respondError(esp_err_t error, const char *msg);
     void respondError(const char *code);
+    /**
+     * Responds with data that @p producer writes piece by piece rather than
+     * builds as a document, meant for large responses. Transports that can
+     * stream send the data out as it is written, for others it is collected
+     * into a document first.
+     */
+    void respondStream(const char *source, const json::Producer &producer);
     Response *makeResponse();
 
     bool is(const char *name) const;
@@ -72,6 +79,12 @@ namespace esp32m {
     virtual Response *makeResponseImpl() {
       assert(false);
     }
+    /** Returns false without calling @p producer if the response can't be
+     * streamed */
+    virtual bool respondStreamImpl(const char *source,
+                                   const json::Producer &producer) {
+      return false;
+    }
     constexpr static const char *Type = "request";
 
    private:
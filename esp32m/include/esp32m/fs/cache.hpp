@@ -1,19 +1,31 @@
 #pragma once
 
 #include <stdio.h>
+#include <sys/stat.h>
 
 #include "esp32m/fs/files.hpp"
+#include "esp32m/json.hpp"
 #include "esp32m/logging.hpp"
 #include "esp32m/resources.hpp"
 
 namespace esp32m {
   namespace fs {
 
+    /**
+     * @brief Keeps a local copy of the resource obtained from one of the
+     * requestors. Requestors that support streaming (e.g. @c http::Client)
+     * download straight into a @c .part file next to the cache, so the body
+     * is never held in memory; the cache is then refreshed with conditional
+     * requests and interrupted downloads are resumed.
+     */
     class CachedResource : public log::Loggable, public ResourceRequestor {
      public:
-      CachedResource(const char* localPath) : _localPath(localPath){};
+      CachedResource(const char* localPath)
+          : _localPath(localPath),
+            _partPath(std::string(localPath) + ".part"),
+            _metaPath(std::string(localPath) + ".meta") {};
       CachedResource(const char* localPath, ResourceRequestor& requestor)
-          : _localPath(localPath) {
+          : CachedResource(localPath) {
         addRequestor(requestor);
       };
       CachedResource(const CachedResource&) = delete;
@@ -28,37 +40,148 @@ namespace esp32m {
       Resource* obtain(ResourceRequest& request) override {
         Resource* res = nullptr;
         if (!request.options.bypassCache) {
-          FileResourceRequest frr(_localPath);
-          frr.options = request.options;
-          res = FileResourceRequestor::instance().obtain(frr);
-          request.errors().copyFrom(frr.errors());
+          res = load(request);
+          if (res && res->size() > 0)
+            return res;
         }
-        if (!res || res->size() == 0) {
-          for (auto requestor : _requestors) {
+        if (res) {
+          delete res;
+          res = nullptr;
+        }
+        for (auto requestor : _requestors) {
+          auto err = refresh(requestor.get(), request);
+          if (err == ESP_OK)
+            res = load(request);
+          else if (err == ESP_ERR_NOT_SUPPORTED) {
             res = requestor.get().obtain(request);
-            if (res && res->size() > 0) {
+            if (res && res->size() > 0)
               save(*res, request);
-              break;
-            }
-            if (res) {
-              delete res;
-              res = nullptr;
-            }
+          }
+          if (res && res->size() > 0)
+            break;
+          if (res) {
+            delete res;
+            res = nullptr;
           }
         }
         return res;
       }
 
+      /**
+       * @brief Brings the local copy up to date without loading it into
+       * memory
+       * @return @c ESP_OK if the local copy is current, error code otherwise
+       */
+      esp_err_t refresh(ResourceRequest& request) {
+        esp_err_t err = ESP_ERR_NOT_FOUND;
+        for (auto requestor : _requestors) {
+          err = refresh(requestor.get(), request);
+          if (err == ESP_OK)
+            break;
+        }
+        return err;
+      }
+
       void clear() {
         if (unlink(_localPath))
           logW("could not remove: %d", errno);
         else
           logD("wiped successfully");
+        unlink(_partPath.c_str());
+        unlink(_metaPath.c_str());
       }
 
      private:
       const char* _localPath;
+      std::string _partPath, _metaPath;
       std::vector<std::reference_wrapper<ResourceRequestor> > _requestors;
+      Resource* load(ResourceRequest& request) {
+        FileResourceRequest frr(_localPath);
+        frr.options = request.options;
+        auto res = FileResourceRequestor::instance().obtain(frr);
+        request.errors().copyFrom(frr.errors());
+        return res;
+      }
+      esp_err_t refresh(ResourceRequestor& requestor,
+                        ResourceRequest& request) {
+        ResourceStreamOptions options;
+        std::unique_ptr<JsonDocument> meta;
+        struct stat st;
+        if (stat(_metaPath.c_str(), &st) == 0)
+          meta = json::loadFromFile(_metaPath.c_str());
+        if (meta) {
+          auto root = meta->as<JsonObjectConst>();
+          if (stat(_localPath, &st) == 0 && st.st_size > 0) {
+            json::from(root["etag"], options.etag);
+            json::from(root["modified"], options.lastModified);
+          }
+          if (stat(_partPath.c_str(), &st) == 0 && st.st_size > 0) {
+            auto part = root["part"];
+            json::from(part["etag"], options.ifRange);
+            if (options.ifRange.empty())
+              json::from(part["modified"], options.ifRange);
+            // without a validator we can't tell if the part is still valid
+            if (!options.ifRange.empty())
+              options.offset = st.st_size;
+          }
+        }
+        ResourceStreamResult result;
+        FileWriter sink(_partPath.c_str());
+        auto err = requestor.stream(request, sink, options, result);
+        auto cerr = sink.close();
+        if (err == ESP_OK)
+          err = cerr;
+        if (err == ESP_ERR_NOT_SUPPORTED)
+          return err;
+        if (result.notModified) {
+          logD("not modified");
+          return ESP_OK;
+        }
+        if (err != ESP_OK) {
+          if (result.received > 0) {
+            logD("keeping %d bytes for resume",
+                 result.offset + result.received);
+            saveMeta(result, true);
+          } else if (result.restarted)
+            // the source refused to resume, start over next time; other
+            // errors (e.g. no connection) leave the part for a retry
+            unlink(_partPath.c_str());
+          return err;
+        }
+        unlink(_localPath);
+        if (rename(_partPath.c_str(), _localPath)) {
+          logW("could not rename %s: %d", _partPath.c_str(), errno);
+          return ESP_FAIL;
+        }
+        logD("updated, %d bytes (%d resumed)", result.offset + result.received,
+             result.offset);
+        saveMeta(result, false);
+        return ESP_OK;
+      }
+      void saveMeta(const ResourceStreamResult& result, bool partial) {
+        JsonDocument doc;
+        auto root = doc.to<JsonObject>();
+        if (partial) {
+          // keep validators of the complete copy, if any
+          struct stat st;
+          std::unique_ptr<JsonDocument> prev;
+          if (stat(_metaPath.c_str(), &st) == 0)
+            prev = json::loadFromFile(_metaPath.c_str());
+          if (prev) {
+            auto proot = prev->as<JsonObjectConst>();
+            if (proot["etag"])
+              root["etag"] = proot["etag"];
+            if (proot["modified"])
+              root["modified"] = proot["modified"];
+          }
+          root = root["part"].to<JsonObject>();
+        }
+        if (!result.etag.empty())
+          root["etag"] = result.etag;
+        if (!result.lastModified.empty())
+          root["modified"] = result.lastModified;
+        json::saveToFile(_metaPath.c_str(), doc.as<JsonVariantConst>());
+      }
       void save(Resource& res, ResourceRequest& request) {
         auto& errors = request.errors();
         void* buf;
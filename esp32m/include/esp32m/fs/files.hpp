@@ -30,6 +30,48 @@ namespace esp32m {
       static constexpr const char* const TYPE = "file";
     };
 
+    /**
+     * @brief Sink that writes streamed data to a file. When the transfer is
+     * resumed at a non-zero offset, data is appended to the existing file,
+     * which must be exactly @p offset bytes long.
+     */
+    class FileWriter : public stream::Writer {
+     public:
+      FileWriter(const char* path) : _path(path) {}
+      FileWriter(const FileWriter&) = delete;
+      FileWriter& operator=(FileWriter&) = delete;
+      ~FileWriter() {
+        close();
+      }
+      esp_err_t begin(size_t offset) override {
+        close();
+        if (offset) {
+          struct stat st;
+          if (stat(_path, &st) != 0 || st.st_size != offset)
+            return ESP_ERR_INVALID_SIZE;
+          _file = fopen(_path, "a");
+        } else
+          _file = fopen(_path, "w");
+        return _file ? ESP_OK : ESP_FAIL;
+      }
+      size_t write(const uint8_t* buf, size_t size) override {
+        if (!_file)
+          return 0;
+        return fwrite(buf, 1, size, _file);
+      }
+      esp_err_t close() {
+        if (!_file)
+          return ESP_OK;
+        auto result = fclose(_file) ? ESP_FAIL : ESP_OK;
+        _file = nullptr;
+        return result;
+      }
+
+     private:
+      const char* _path;
+      FILE* _file = nullptr;
+    };
+
     class FileResourceRequestor : public ResourceRequestor {
      public:
       FileResourceRequestor(const FileResourceRequestor&) = delete;
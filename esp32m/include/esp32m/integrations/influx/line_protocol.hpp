@@ -0,0 +1,19 @@
+#pragma once
+
+#include <string>
+
+namespace esp32m {
+  namespace integrations {
+    namespace influx {
+
+      /**
+       * @brief Escapes backslashes, spaces, commas and equals signs, so that
+       * @p src can be used as a tag key, tag value or field name in the
+       * InfluxDB line protocol
+       */
+      std::string escapeLineProtocolValue(const char *src);
+
+
+    }  // namespace influx
+  }  // namespace integrations
+}  // namespace esp32m
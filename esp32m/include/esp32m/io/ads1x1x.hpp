@@ -1,5 +1,12 @@
 #pragma once
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <memory>
+#include <mutex>
+
 #include "esp32m/bus/i2c/master.hpp"
 #include "esp32m/io/pins.hpp"
 #include "esp32m/logging.hpp"
@@ -11,6 +18,7 @@ namespace esp32m {
     namespace ads1x1x {
 
       const uint8_t DefaultAddress = 0x48;
+      const uint8_t MaxAveraging = 16;
 
       enum Variant {
         Ads111x,
@@ -64,6 +72,7 @@ namespace esp32m {
      public:
       Ads1x1x(i2c::MasterDev *i2c, ads1x1x::Variant v);
       Ads1x1x(const Ads1x1x &) = delete;
+      ~Ads1x1x();
       const char *name() const override {
         switch (_variant) {
           case ads1x1x::Variant::Ads101x:
@@ -92,16 +101,46 @@ namespace esp32m {
       ads1x1x::Rate getRate() {
         return _rate;
       }
+      /**
+       * Converts in the background, paced by the ALERT/RDY pin. Channels
+       * with an ADC feature are sampled round robin, or continuously if
+       * there is only one, and IADC::read returns the average of the last
+       * samples of the channel without touching the bus
+       */
+      esp_err_t setRdy(IPin *pin);
+      bool isSampling() const {
+        return _task != nullptr;
+      }
+      /** Number of samples IADC::read averages, up to MaxAveraging */
+      void setAveraging(uint8_t samples);
+      esp_err_t latest(int id, int16_t &value);
 
      protected:
       std::unique_ptr<i2c::MasterDev> _i2c;
       IPin *newPin(int id) override;
 
      private:
+      struct Channel {
+        int16_t samples[ads1x1x::MaxAveraging];
+        uint8_t count, pos;
+      };
       ads1x1x::Variant _variant;
       ads1x1x::Gain _gain;
       ads1x1x::Rate _rate;
       uint8_t _bitShift;
+      std::mutex _mutex;
+      pin::IDigital *_rdy = nullptr;
+      QueueHandle_t _ready = nullptr;
+      TaskHandle_t _task = nullptr;
+      volatile bool _stopped = false, _exited = false;
+      std::unique_ptr<Channel[]> _channels;
+      uint8_t _enabled = 0, _averaging = 4;
+      esp_err_t writeConfig(ads1x1x::Mux mux, bool continuous);
+      esp_err_t average(int id, int &value);
+      void enable(int id);
+      int next(int id);
+      TickType_t timeout();
+      void run();
       friend class ads1x1x::ADC;
     };
   }  // namespace io
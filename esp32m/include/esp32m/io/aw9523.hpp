@@ -2,6 +2,7 @@
 
 #include "esp32m/bus/i2c/master.hpp"
 #include "esp32m/io/pins.hpp"
+#include "esp32m/io/portmonitor.hpp"
 
 namespace esp32m {
   namespace io {
@@ -17,6 +18,14 @@ namespace esp32m {
       }
 
       esp_err_t setRst(io::IPin *pin);
+      /** Connects the INT output, inputs are then read only when they
+       * change and can be attached to a queue */
+      esp_err_t setInt(io::IPin *pin) {
+        return _monitor.setInt(pin);
+      }
+      PortMonitor &monitor() {
+        return _monitor;
+      }
 
       esp_err_t reset(bool hard = false);
 
@@ -25,6 +34,9 @@ namespace esp32m {
       esp_err_t setPinMode(int pin, aw9523::PinMode mode);
       esp_err_t analogWrite(int pin, float value);
       esp_err_t commit() override;
+      const void *txGroup() const override {
+        return _i2c->bus();
+      }
       esp_err_t setP0PushPull(bool enable);
 
      protected:
@@ -34,6 +46,7 @@ namespace esp32m {
       std::unique_ptr<i2c::MasterDev> _i2c;
       io::pin::IDigital *_rst = nullptr;
       uint16_t _out, _cfg, _int, _mode, _input, _gcr;
+      PortMonitor _monitor;
       esp_err_t init();
       esp_err_t readInput();
       esp_err_t writeOutput();
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <map>
+#include <mutex>
+
+#include "esp32m/events.hpp"
+#include "esp32m/io/pins.hpp"
+
+namespace esp32m {
+  namespace dev {
+    class Component;
+  }
+
+  namespace io {
+    class Inputs;
+
+    namespace input {
+      enum class Edge { Rising = 1, Falling = 2, Both = 3 };
+
+      struct Options {
+        // the level must hold this long before a transition is accepted
+        uint32_t debounceMs = 20;
+        // which of the debounced transitions are published, after inversion
+        Edge edges = Edge::Both;
+        // report the inverse of the pin level, e.g. for active-low contacts
+        bool inverted = false;
+        // if set, receives the debounced level as its state
+        dev::Component *component = nullptr;
+      };
+
+      /**
+       * Published from the input task after a debounced transition, the
+       * subscribers should return quickly
+       */
+      class Changed : public Event {
+       public:
+        Changed(const Changed &) = delete;
+        IPin *pin() const {
+          return _pin;
+        }
+        bool level() const {
+          return _level;
+        }
+        // how long the previous level lasted, ms
+        unsigned long held() const {
+          return _held;
+        }
+        static bool is(Event &ev, Changed **changed) {
+          if (ev.is(Type)) {
+            if (changed)
+              *changed = (Changed *)&ev;
+            return true;
+          }
+          return false;
+        }
+        static bool is(Event &ev, IPin *pin) {
+          return ev.is(Type) && ((Changed &)ev)._pin == pin;
+        }
+
+       private:
+        Changed(IPin *pin, bool level, unsigned long held)
+            : Event(Type), _pin(pin), _level(level), _held(held) {}
+        IPin *_pin;
+        bool _level;
+        unsigned long _held;
+        constexpr static const char *Type = "input-changed";
+        friend class io::Inputs;
+      };
+    }  // namespace input
+
+    /**
+     * Debounced digital inputs.
+     *
+     * Each registered pin is attached to its own interrupt queue, all of them
+     * are members of one queue set served by a single task. An edge arms a
+     * deadline, the pin is read once the deadline passes with no further
+     * edges, and a level that differs from the last accepted one is published
+     * as input::Changed. Works with GPIOs as well as with expander pins whose
+     * port monitor has an INT line.
+     */
+    class Inputs {
+     public:
+      static constexpr int MaxInputs = 32;
+      Inputs(const Inputs &) = delete;
+      static Inputs &instance();
+      esp_err_t add(IPin *pin, const input::Options &options = {});
+      esp_err_t remove(IPin *pin);
+      // last debounced level, inverted if so configured
+      esp_err_t read(IPin *pin, bool &level);
+
+     private:
+      static constexpr int QueueDepth = 4;
+      struct Input {
+        IPin *pin;
+        input::Options options;
+        bool level;
+        unsigned long since;
+        bool armed;
+        unsigned long deadline;
+      };
+      struct Change {
+        IPin *pin;
+        bool level;
+        unsigned long held;
+        bool report;
+        dev::Component *component;
+      };
+      std::mutex _mutex;
+      QueueSetHandle_t _set = nullptr;
+      TaskHandle_t _task = nullptr;
+      std::map<QueueHandle_t, Input> _inputs;
+      Inputs() {}
+      esp_err_t init();
+      bool settle(Input &input, unsigned long now, Change &change);
+      void run();
+    };
+
+    Inputs &useInputs();
+
+  }  // namespace io
+}  // namespace esp32m
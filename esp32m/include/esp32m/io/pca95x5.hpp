@@ -2,6 +2,7 @@
 
 #include "esp32m/bus/i2c/master.hpp"
 #include "esp32m/io/pins.hpp"
+#include "esp32m/io/portmonitor.hpp"
 
 namespace esp32m {
   namespace io {
@@ -32,8 +33,19 @@ namespace esp32m {
       esp_err_t readPin(int pin, bool &value);
       esp_err_t writePin(int pin, bool value);
       esp_err_t setPinMode(int pin, bool input);
+      /** Connects the INT output, inputs are then read only when they
+       * change and can be attached to a queue */
+      esp_err_t setInt(IPin *pin) {
+        return _monitor.setInt(pin);
+      }
+      PortMonitor &monitor() {
+        return _monitor;
+      }
 
       esp_err_t commit() override;
+      const void *txGroup() const override {
+        return _i2c->bus();
+      }
 
       esp_err_t read(pca95x5::Register reg, uint16_t &value);
       esp_err_t write(pca95x5::Register reg, uint16_t value);
@@ -45,6 +57,7 @@ namespace esp32m {
       std::unique_ptr<i2c::MasterDev> _i2c;
       pca95x5::Bits _bits;
       uint16_t _input = 0xFFFF, _output = 0x0, _config = 0xFFFF, _targetOutput=0;
+      PortMonitor _monitor;
       esp_err_t init();
     };
 
@@ -2,6 +2,7 @@
 
 #include "esp32m/bus/i2c/master.hpp"
 #include "esp32m/io/pins.hpp"
+#include "esp32m/io/portmonitor.hpp"
 
 namespace esp32m {
   namespace io {
@@ -22,10 +23,21 @@ namespace esp32m {
       esp_err_t readPin(int pin, bool &value);
       esp_err_t writePin(int pin, bool value);
       esp_err_t setPinMode(int pin, bool input);
+      /** Connects the INT output, inputs are then read only when they
+       * change and can be attached to a queue */
+      esp_err_t setInt(IPin *pin) {
+        return _monitor.setInt(pin);
+      }
+      PortMonitor &monitor() {
+        return _monitor;
+      }
 
       esp_err_t read(uint16_t &port);
       esp_err_t write(uint16_t port);
       esp_err_t commit() override;
+      const void *txGroup() const override {
+        return _i2c->bus();
+      }
 
      protected:
       IPin *newPin(int id) override;
@@ -34,7 +46,9 @@ namespace esp32m {
       Flavor _flavor;
       std::unique_ptr<i2c::MasterDev> _i2c;
       uint16_t _port = 0xFFFF, _inputMap = 0xFFFF;
+      PortMonitor _monitor;
       esp_err_t init();
+      esp_err_t readPort(uint16_t &port);
     };
 
     Pcf857x *usePcf8574(uint8_t addr = 0x21);
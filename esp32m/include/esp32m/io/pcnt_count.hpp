@@ -0,0 +1,30 @@
+#pragma once
+
+#include <climits>
+#include <cstdint>
+
+namespace esp32m {
+  namespace io {
+    namespace pcnt {
+
+      /**
+       * Limits of the hardware counter. Both are registered as watch points,
+       * the driver then adds the limit to its software accumulator whenever
+       * the counter reaches it and resets to 0, so readings keep growing
+       * past the 16-bit range.
+       */
+      const int LowLimit = SHRT_MIN;
+      const int HighLimit = SHRT_MAX;
+
+      /**
+       * @return Pulses counted between two readings of an accumulating unit,
+       * negative when counting down; also correct once the accumulated count
+       * wraps around the range of @c int
+       */
+      inline int countDelta(int from, int to) {
+        return (int)((uint32_t)to - (uint32_t)from);
+      }
+
+    }  // namespace pcnt
+  }  // namespace io
+}  // namespace esp32m
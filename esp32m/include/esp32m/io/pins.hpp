@@ -3,6 +3,7 @@
 #include "esp32m/defs.hpp"
 #include "esp32m/logging.hpp"
 
+#include <algorithm>
 #include <driver/ledc.h>
 #include <driver/pulse_cnt.h>
 #include <esp_bit_defs.h>
@@ -14,6 +15,7 @@
 #include <hal/gpio_types.h>
 #include <map>
 #include <mutex>
+#include <vector>
 
 namespace esp32m {
   namespace io {
@@ -166,12 +168,24 @@ namespace esp32m {
         virtual uint32_t getFreq() const = 0;
         virtual esp_err_t enable(bool on) = 0;
         virtual bool isEnabled() const = 0;
+        /** Peripheral generating the signal: "ledc", "mcpwm" or "soft" */
+        virtual const char *backend() const {
+          return nullptr;
+        }
       };
 
       class IPcnt;
 
+      /**
+       * Derives the input frequency from a pulse counter. Counting divides
+       * the edges seen by the sampling period, which quantizes slow signals
+       * badly. Reciprocal mode timestamps rising edges instead and divides
+       * the number of edges by the time between the first and the last of
+       * them. Auto mode counts fast signals and timestamps slow ones.
+       */
       class PcntSampler {
        public:
+        enum class Mode { Count, Reciprocal, Auto };
         PcntSampler(IPcnt *pcnt);
         ~PcntSampler();
         esp_err_t enable(bool on) {
@@ -189,15 +203,47 @@ namespace esp32m {
         float getFreq() const {
           return _freq;
         }
+        esp_err_t setMode(Mode mode);
+        Mode getMode() const {
+          return _mode;
+        }
+        /** Whether edges are being timestamped right now */
+        bool isReciprocal() const {
+          return _reciprocal;
+        }
+        /** Edges closer than this to the previous one are ignored when
+         * timestamping, microseconds */
+        esp_err_t setGlitchFilter(uint32_t us);
+        uint32_t getGlitchFilter() const {
+          return _glitchUs;
+        }
+        /** Minimum number of periods a reciprocal reading spans */
+        void setEdges(uint32_t edges) {
+          _minEdges = edges ? edges : 1;
+        }
+        /** Auto mode timestamps edges below this frequency and goes back to
+         * counting above twice of it */
+        void setCrossover(float hz) {
+          _crossover = hz;
+        }
 
        private:
         IPcnt *_pcnt;
+        std::mutex _mutex;
+        Mode _mode = Mode::Count;
+        bool _reciprocal = false;
         uint64_t _period = 0;
         uint64_t _ticks = 0;
         int _value = 0;
         float _freq = 0;
+        uint32_t _glitchUs = 0, _minEdges = 1, _edges = 0;
+        int64_t _lastEdge = 0, _captureStart = 0;
+        float _crossover = 200;
+        // whether a full counting period has been measured since enabling
+        bool _seeded = false;
         esp_timer_handle_t _timer = nullptr;
         void cb();
+        esp_err_t capture(bool on);
       };
 
       class IPcnt : public Feature {
@@ -218,6 +264,15 @@ namespace esp32m {
         virtual esp_err_t getFilter(uint32_t &glitchNs) = 0;
         virtual esp_err_t enable(bool on) = 0;
         virtual bool isEnabled() const = 0;
+        /** Starts or stops timestamping rising edges, ignoring those closer
+         * than glitchUs to the previous one */
+        virtual esp_err_t captureEdges(bool on, uint32_t glitchUs = 0) {
+          return ESP_ERR_NOT_SUPPORTED;
+        }
+        /** Number of edges timestamped so far and the time of the last one */
+        virtual esp_err_t readEdges(uint32_t &count, int64_t &last) {
+          return ESP_ERR_NOT_SUPPORTED;
+        }
         PcntSampler *getSampler() {
           if (!_sampler)
             _sampler.reset(new PcntSampler(this));
@@ -345,8 +400,21 @@ namespace esp32m {
       class ITxFinalizer {
        public:
         virtual esp_err_t commit() = 0;
+        /** Finalizers of the same group, typically devices sharing a bus,
+         * are committed one after another. This only orders the commits,
+         * it does not keep other users off the bus in between */
+        virtual const void *txGroup() const {
+          return nullptr;
+        }
       };
 
+      /**
+       * Batches pin access across any number of port expanders. Each device
+       * reads its port at most once and registers itself to commit its
+       * pending output state once, when the outermost transaction ends.
+       * Transactions are serialized between tasks and may be nested within
+       * one.
+       */
       class Tx {
        public:
         enum Type {
@@ -359,26 +427,27 @@ namespace esp32m {
         Type type() const {
           return _type;
         }
-        const ITxFinalizer *getFinalizer() const {
-          return _finalizer;
-        }
+        /** Adds a device to commit, devices added again are ignored */
         esp_err_t setFinalizer(ITxFinalizer *finalizer);
-        void setReadPerformed() {
-          _readPerformed = true;
+        void setReadPerformed(const void *device) {
+          if (!getReadPerformed(device))
+            _reads.push_back(device);
         }
-        bool getReadPerformed() const {
-          return _readPerformed;
+        bool getReadPerformed(const void *device) const {
+          return std::find(_reads.begin(), _reads.end(), device) !=
+                 _reads.end();
         }
+        /** Returns the outermost transaction */
         static Tx *current() {
           return _current;
         }
 
        private:
-        std::mutex _mutex;
         Type _type;
         esp_err_t *_errPtr;
-        ITxFinalizer *_finalizer = nullptr;
-        bool _readPerformed = false;
+        std::vector<ITxFinalizer *> _finalizers;
+        std::vector<const void *> _reads;
+        static std::recursive_mutex _mutex;
         static int _nesting;
         static Tx *_current;
       };
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/task.h>
+
+#include <functional>
+#include <map>
+#include <mutex>
+
+#include "esp32m/io/pins.hpp"
+
+namespace esp32m {
+  namespace io {
+
+    /**
+     * Input cache for port expanders with an interrupt output.
+     *
+     * Once the expander's INT line is connected to a GPIO via setInt(), the
+     * input port is read from the device only after INT went low, every
+     * other read() is served from the cache. Pins attached to a queue are
+     * watched by a task that refreshes the port on each interrupt and
+     * reports changes of these pins to the queue in the same format as GPIO
+     * interrupts: microseconds since the previous edge of the pin, negative
+     * if the pin went high.
+     */
+    class PortMonitor {
+     public:
+      typedef std::function<esp_err_t(uint16_t &)> Reader;
+      PortMonitor(Reader reader) : _reader(reader) {}
+      PortMonitor(const PortMonitor &) = delete;
+      ~PortMonitor();
+      esp_err_t setInt(IPin *pin);
+      bool isEnabled() const {
+        return _int != nullptr;
+      }
+      esp_err_t read(uint16_t &port);
+      /** Must be called when the port may have changed without INT going
+       * low, e.g. after the pin direction changed */
+      void invalidate() {
+        std::lock_guard guard(_mutex);
+        _valid = false;
+      }
+      esp_err_t attach(int pin, QueueHandle_t queue, gpio_int_type_t type);
+      esp_err_t detach(int pin);
+
+     private:
+      struct Watch {
+        QueueHandle_t queue;
+        gpio_int_type_t type;
+        bool level;
+        int64_t stamp;
+      };
+      Reader _reader;
+      pin::IDigital *_int = nullptr;
+      QueueHandle_t _edges = nullptr;
+      TaskHandle_t _task = nullptr;
+      std::mutex _mutex;
+      uint16_t _port = 0;
+      bool _valid = false;
+      std::map<int, Watch> _watches;
+      volatile bool _stopped = false, _exited = false;
+      bool drain();
+      esp_err_t refresh();
+      void run();
+    };
+
+  }  // namespace io
+}  // namespace esp32m
@@ -14,6 +14,13 @@ namespace esp32m {
     class SoftPwm {
      public:
       SoftPwm(pwm::Callback cb) : _cb(cb) {}
+      SoftPwm(const SoftPwm &) = delete;
+      ~SoftPwm() {
+        if (_timer) {
+          esp_timer_stop(_timer);
+          esp_timer_delete(_timer);
+        }
+      }
       esp_err_t setDuty(float value) {
         _duty = value;
         return ESP_OK;
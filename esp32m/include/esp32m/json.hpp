@@ -1,8 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include <ArduinoJson.h>
@@ -209,6 +211,75 @@ namespace esp32m {
       std::map<std::string, std::unique_ptr<JsonDocument> > _documents;
     };
 
+    /**
+     * Writes JSON text piece by piece into a stream, for documents too large
+     * to be built in memory first. Separators are inserted automatically.
+     * Also usable as an ArduinoJson writer, so whole variants can be mixed in
+     * with value(). Nesting is limited to 32 levels.
+     */
+    class Writer {
+     public:
+      Writer(stream::Writer &out) : _out(out) {}
+      Writer(const Writer &) = delete;
+      void beginObject();
+      void endObject();
+      void beginArray();
+      void endArray();
+      void key(const char *name);
+      void value(JsonVariantConst v);
+      void value(const char *v);
+      void value(const std::string &v) {
+        value(v.c_str());
+      }
+      void value(std::nullptr_t);
+      template <typename T>
+        requires std::is_arithmetic_v<T>
+      void value(T v) {
+        if constexpr (std::is_same_v<T, bool>)
+          literal(v ? "true" : "false");
+        else if constexpr (std::is_floating_point_v<T>)
+          number((double)v);
+        else if constexpr (std::is_signed_v<T>)
+          number((int64_t)v);
+        else
+          number((uint64_t)v);
+      }
+      template <typename T>
+      void member(const char *name, const T &v) {
+        key(name);
+        value(v);
+      }
+      /** false once the stream stopped accepting data, the rest is dropped */
+      bool ok() const {
+        return _ok;
+      }
+
+      size_t write(uint8_t c) {
+        return write(&c, 1);
+      }
+      size_t write(const uint8_t *buf, size_t size);
+
+     private:
+      stream::Writer &_out;
+      bool _ok = true;
+      // a key was just written, the next value belongs to it
+      bool _keyed = false;
+      uint8_t _depth = 0;
+      // bit per nesting level, set once the container has its first item
+      uint32_t _filled = 0;
+      void separate();
+      void open(char c);
+      void close(char c);
+      void literal(const char *s);
+      void string(const char *s);
+      void number(int64_t v);
+      void number(uint64_t v);
+      void number(double v);
+    };
+
+    /** Writes a value into the given writer, see Request::respondStream() */
+    typedef std::function<void(Writer &)> Producer;
+
   }  // namespace json
 
 }  // namespace esp32m
\ No newline at end of file
@@ -1,30 +1,100 @@
 #pragma once
 
 #include <stdio.h>
+#include <map>
 #include <mutex>
+#include <string>
+#include <string_view>
 
+#include "esp32m/events.hpp"
 #include "esp32m/logging.hpp"
 
 namespace esp32m {
   namespace log {
     /**
-     * Sends output to file system (SD, SPIFFS or other)
+     * Sends output to file system (SD, SPIFFS or other).
+     * Formatted messages are collected in a RAM buffer and written to the file
+     * in page-sized blocks when the buffer fills up, when the oldest buffered
+     * message is older than @c Options::flushInterval, or immediately for
+     * messages at @c Options::flushLevel or more severe. The size of the
+     * current file is tracked in memory, so rotation does not need to
+     * @c stat() the file for every message.
+     *
+     * With @c Format::Binary, messages are stored as compact records instead
+     * of text lines; @c scripts/decode-log.py turns such files back into
+     * text. Every file starts with the magic @c "m32L" and a version byte,
+     * followed by records that begin with a tag byte (all integers are
+     * LEB128 varints):
+     *  - @c RecName: id, length, bytes - defines a logger or task name;
+     *    ids are assigned per file, so every file can be decoded on its own
+     *  - @c RecStamp: zigzag-encoded absolute @c LogMessage::stamp()
+     *  - @c RecMessage: level byte, task id, name id, milliseconds since the
+     *    previous stamp, length, message bytes
+     *
+     * A file in the other format (e.g. after the format option was changed)
+     * is rotated rather than appended to.
      */
     class Vfs : public FormattingAppender {
      public:
-      Vfs(const char *name, uint8_t maxFiles = 1)
-          : _name(name), _maxFiles(maxFiles) {}
+      enum Format { Text, Binary };
+      enum Record : uint8_t { RecName = 1, RecStamp = 2, RecMessage = 3 };
+      static constexpr const char *BinaryMagic = "m32L";
+      static constexpr uint8_t BinaryVersion = 1;
+      struct Options {
+        // number of generations including the current file: name, name.1, ...
+        uint8_t maxFiles = 1;
+        // the current file is rotated when it would grow past this size
+        size_t maxFileSize = 8192;
+        // size of the RAM buffer, rounded up to BufAlign; 0 writes every line
+        size_t bufSize = 1024;
+        // buffered messages are written no later than this, in milliseconds
+        uint32_t flushInterval = 5000;
+        // messages at this level or more severe are written immediately
+        Level flushLevel = Level::Error;
+        Format format = Format::Text;
+      };
+      static constexpr size_t BufAlign = 256;
+      Vfs(const char *name, uint8_t maxFiles = 1);
+      Vfs(const char *name, const Options &options);
       Vfs(const Vfs &) = delete;
+      ~Vfs();
+      const Options &options() const {
+        return _options;
+      }
+      /**
+       * @brief Writes buffered messages to the file
+       */
+      void flush();
 
      protected:
-      virtual bool append(const char *message);
-      virtual bool shouldRotate();
+      bool append(const LogMessage *message) override;
+      bool append(const char *message) override;
+      virtual bool shouldRotate(size_t pending);
 
      private:
-      FILE *_file;
+      FILE *_file = nullptr;
       const char *_name;
-      uint8_t _maxFiles;
-      std::mutex _lock;
+      Options _options;
+      size_t _fileSize = 0;
+      char *_buf = nullptr;
+      size_t _bufUsed = 0;
+      unsigned long _bufStamp = 0;
+      bool _urgent = false;
+      std::recursive_mutex _lock;
+      Subscription *_sub = nullptr;
+      // binary format state, reset for every new file
+      std::map<std::string, uint32_t, std::less<>> _ids;
+      int64_t _lastStamp = 0;
+      bool _hasStamp = false;
+      bool open();
+      void rotate();
+      bool started();
+      bool formatMatches();
+      bool write(const char *data, size_t size);
+      bool flushLocked();
+      bool appendBinary(const LogMessage *message);
+      size_t encode(const LogMessage *message, uint8_t *out);
+      uint32_t intern(const char *name, size_t len, uint8_t *&out);
     };
   }  // namespace log
 }  // namespace esp32m
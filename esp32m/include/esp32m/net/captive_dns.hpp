@@ -4,9 +4,11 @@
 #include <lwip/sockets.h>
 
 #include "esp32m/logging.hpp"
+#include "esp32m/net/dns_responder.hpp"
 
 namespace esp32m {
   namespace net {
+
     class CaptiveDns : public log::SimpleLoggable {
      public:
       CaptiveDns(esp_ip4_addr_t ip);
@@ -15,12 +17,12 @@ namespace esp32m {
 
      private:
       esp_ip4_addr_t _ip;
+      DnsResponder _responder;
+      DnsRateLimiter _limiter;
       bool _enabled = false;
       int _sockFd = 0;
       TaskHandle_t _task;
       void run();
-      void recv(struct sockaddr_in *premote_addr, char *pusrdata,
-                unsigned short length);
     };
   }  // namespace net
 }  // namespace esp32m
\ No newline at end of file
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <esp_netif_types.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace esp32m {
+  namespace net {
+
+    /**
+     * Builds captive portal DNS replies without touching the heap.
+     * A queries are answered with a preassembled record pointing to the
+     * portal address, AAAA/SVCB/HTTPS queries get NXDOMAIN so that clients
+     * fall back to IPv4 right away, everything else gets an empty NOERROR.
+     * Only the header and the question are taken from the query, so the
+     * class has no dependencies on sockets and can be fed canned packets.
+     */
+    class DnsResponder {
+     public:
+      static constexpr size_t MaxPacket = 512;
+      DnsResponder(esp_ip4_addr_t ip, uint32_t ttl = 60);
+      void setAddress(esp_ip4_addr_t ip);
+      /**
+       * Writes reply to the @p query into @p reply, which must be at least
+       * @c MaxPacket bytes long.
+       * @return Size of the reply, or 0 if the query must be dropped
+       */
+      size_t respond(const uint8_t *query, size_t len, uint8_t *reply) const;
+
+     private:
+      uint8_t _answer[16];
+    };
+
+    /**
+     * Per-client token bucket limiter, tracks a fixed number of clients and
+     * recycles the least recently seen slot when a new client shows up.
+     */
+    class DnsRateLimiter {
+     public:
+      static constexpr size_t MaxClients = 8;
+      /**
+       * @param rate Sustained queries per second allowed for every client
+       * @param burst Number of queries a client may send at once
+       */
+      DnsRateLimiter(uint16_t rate = 20, uint16_t burst = 40)
+          : _rate(rate), _burst(burst) {}
+      /**
+       * @param addr Client address, any non-zero value
+       * @param now Current time in milliseconds
+       */
+      bool allow(uint32_t addr, uint32_t now);
+
+     private:
+      struct Client {
+        uint32_t addr;
+        uint32_t stamp;
+        uint32_t tokens;  // in 1/1000 of a query
+      };
+      Client _clients[MaxClients] = {};
+      uint16_t _rate, _burst;
+    };
+  }  // namespace net
+}  // namespace esp32m
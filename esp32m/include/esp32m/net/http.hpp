@@ -14,6 +14,16 @@ namespace esp32m {
         Client& operator=(Client&) = delete;
         Resource* describe(ResourceRequest& req);
         Resource* obtain(ResourceRequest& req) override;
+        /**
+         * @brief Download the resource into @p sink in chunks of
+         * @c options.chunkSize bytes. Sends @c If-None-Match /
+         * @c If-Modified-Since when validators are given, and a @c Range
+         * header when @c options.offset is non-zero. Works with chunked
+         * responses that have no @c Content-Length.
+         */
+        esp_err_t stream(ResourceRequest& req, stream::Writer& sink,
+                         const ResourceStreamOptions& options,
+                         ResourceStreamResult& result) override;
 
         static Client& instance() {
           static Client i;
@@ -3,6 +3,7 @@
 #include "esp32m/app.hpp"
 #include "esp32m/device.hpp"
 #include "esp32m/fs/cache.hpp"
+#include "esp32m/net/mqtt_topic.hpp"
 #include "esp32m/resources.hpp"
 #include "esp32m/sleep.hpp"
 
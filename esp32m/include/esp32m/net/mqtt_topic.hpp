@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+namespace esp32m {
+  namespace net {
+
+    /**
+     * @return @c true if @p topic matches subscription @p filter, which may
+     * contain @c + and @c # wildcards
+     */
+    bool mqttTopicMatchesFilter(const std::string &filter,
+                                const std::string &topic);
+
+  }  // namespace net
+}  // namespace esp32m
\ No newline at end of file
@@ -60,7 +60,7 @@ namespace esp32m {
       static const char *KeyOtaEnd;
 
      private:
-      std::mutex *_mutex;
+      locks::Lock *_mutex;
       std::string _savedUrl, _pendingUrl;
       TaskHandle_t _task;
       bool _updating = false;
@@ -3,12 +3,11 @@
 #include <cstddef>
 #include <cstdint>
 #include <mutex>
-#include <string>
+#include <string_view>
 #include <vector>
 
 #include <esp_err.h>
 #include <freertos/FreeRTOS.h>
-#include <freertos/queue.h>
 #include <freertos/task.h>
 
 #include "esp32m/logging.hpp"
@@ -20,9 +19,28 @@ namespace esp32m {
       class IConsumer {
        public:
         virtual ~IConsumer() = default;
-        virtual void consume(std::string line) = 0;
+        /**
+         * Called from the monitor's dispatch task for every complete line.
+         * @p line points to a copy of the record: it is followed by a null
+         * terminator, but is only valid during the call. The ring is not
+         * locked while this runs, a slow consumer just falls behind and gets
+         * @c gap(). Implementations must not call @c Monitor::add() /
+         * @c Monitor::remove().
+         */
+        virtual void consume(std::string_view line) = 0;
+        /**
+         * Called when this consumer fell behind and @p lost bytes were
+         * overwritten before it could read them (drop-oldest policy).
+         * By default, a marker line is passed to @c consume().
+         */
+        virtual void gap(size_t lost);
       };
 
+      /**
+       * Splits UART output into lines and fans them out to consumers.
+       * Lines are stored once in a fixed-size byte ring, every consumer has
+       * its own read cursor into it, so there are no per-line allocations.
+       */
       class Monitor : public log::Loggable {
        public:
         Monitor(const Monitor&) = delete;
@@ -42,29 +60,49 @@ namespace esp32m {
 
        private:
         class RxTap;
-        void ingest(const uint8_t *data, size_t len);
+        struct Reader {
+          IConsumer* consumer;
+          uint32_t cursor;
+        };
+        void ingest(const uint8_t* data, size_t len);
 
-        static void rxTaskThunk(void *param);
+        static void rxTaskThunk(void* param);
         void rxLoop();
 
-        static void dispatchTaskThunk(void *param);
+        static void dispatchTaskThunk(void* param);
         void dispatchLoop();
 
-        void enqueueLine(const char *data, size_t len);
-
-        std::vector<IConsumer *> _consumers;
-        std::mutex _consumersMutex;
-
-        std::string _buf;
-        std::mutex _bufMutex;
+        void commitLine();
+        bool next(Reader& reader, size_t& lost, uint16_t& len);
+        uint32_t skipPadding(uint32_t pos) const;
+        uint16_t recordLen(uint32_t pos) const;
+
+        std::vector<Reader> _readers;
+        std::mutex _mutex;
+        // held while a consumer runs, so remove() can't pull it from under us
+        std::mutex _dispatchMutex;
+        // the record being dispatched, only touched by the dispatch task
+        char* _scratch = nullptr;
+
+        // line under construction, only touched by the ingesting task
+        char* _line = nullptr;
+        size_t _lineLen = 0;
         bool _lastWasCr = false;
 
-        RxTap *_tap = nullptr;
+        // records are [u16 length][bytes][0], never split at the ring end;
+        // _head and _tail are free-running byte counters
+        uint8_t* _ring = nullptr;
+        uint32_t _head = 0;
+        uint32_t _tail = 0;
+
+        RxTap* _tap = nullptr;
 
-        QueueHandle_t _queue = nullptr;
         TaskHandle_t _rxTask = nullptr;
         TaskHandle_t _dispatchTask = nullptr;
 
+        // power of two, so offsets stay consistent when the counters wrap;
+        // must hold at least two records of _maxLineLen
+        size_t _ringSize = 8192;
         size_t _maxLineLen = 1024;
         uint32_t _idlePollMs = 25;
       };
@@ -8,13 +8,14 @@ namespace esp32m {
 
       class MqttConsumer : public IConsumer {
        public:
-        void consume(std::string line) override;
+        void consume(std::string_view line) override;
         static MqttConsumer& instance() {
           static MqttConsumer i;
           return i;
         }
 
        private:
+        std::string _hostname, _topic;
         MqttConsumer() {
           Monitor::instance().add(*this);
         }
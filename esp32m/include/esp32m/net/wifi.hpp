@@ -170,7 +170,8 @@ namespace esp32m {
       bool toJson(JsonArray& target, bool maskPassword);
       size_t jsonSize(bool maskPassword);
       void failed() {
-        _failcount++;
+        if (_failcount < UINT8_MAX)
+          _failcount++;
       }
       void succeeded() {
         _failcount = 0;
@@ -273,8 +274,12 @@ namespace esp32m {
       void checkScan();
       esp_err_t checkNameChanged();
       void run();
-      bool tryConnect(ApInfo* ap, bool noBssid);
+      bool tryConnect(ApInfo* ap, bool noBssid, bool fast = false);
       bool tryConnect();
+      bool waitConnected(uint32_t graceMs, uint32_t timeoutMs);
+      ApInfo* cachedAp();
+      void rememberAp(ApInfo* ap);
+      ApInfo* updateFailcount(ApInfo* ap, bool ok);
       ApInfo* addOrUpdateAp(ApInfo* ap);
       ApInfo* addOrUpdateAp(JsonArrayConst source, bool& changed);
       void ensureId(ApInfo* ap);
@@ -93,9 +93,53 @@ namespace esp32m {
     static constexpr const char* const TYPE = "url";
   };
 
+  /**
+   * @brief Validators and resume point for conditional / ranged transfers
+   */
+  struct ResourceStreamOptions {
+    // skip the transfer if the remote entity still has this ETag
+    std::string etag;
+    // skip the transfer if the remote entity was not modified since then
+    std::string lastModified;
+    // ask the source to resume from this offset
+    size_t offset = 0;
+    // resume only if the remote entity still matches this validator,
+    // otherwise the source sends the whole entity from offset 0
+    std::string ifRange;
+    // size of the buffer the data is passed to the sink in
+    size_t chunkSize = 1024;
+  };
+
+  struct ResourceStreamResult {
+    // the source reported that validators still match, no data was sent
+    bool notModified = false;
+    // offset the data actually started at (0 if the source ignored resume)
+    size_t offset = 0;
+    // resume was requested, but the source answered without honouring it or
+    // the sink could not continue at the offset; partial data kept for the
+    // resume is of no use anymore
+    bool restarted = false;
+    // number of bytes passed to the sink
+    size_t received = 0;
+    // total size as announced by the source, -1 if unknown
+    int64_t size = -1;
+    std::string etag;
+    std::string lastModified;
+  };
+
   class ResourceRequestor {
    public:
     virtual Resource* obtain(ResourceRequest& request) = 0;
+    /**
+     * @brief Pass the resource to @p sink in fixed-size chunks instead of
+     * holding it in memory as a whole
+     */
+    virtual esp_err_t stream(ResourceRequest& request, stream::Writer& sink,
+                             const ResourceStreamOptions& options,
+                             ResourceStreamResult& result) {
+      return request.errors().check(ESP_ERR_NOT_SUPPORTED, "streaming: %s",
+                                    request.type());
+    }
   };
 
 }  // namespace esp32m
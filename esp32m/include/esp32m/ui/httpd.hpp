@@ -4,8 +4,10 @@
 
 #include <list>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 #include "esp32m/ui/transport.hpp"
 
@@ -77,8 +79,10 @@ namespace esp32m {
      protected:
       void init(Ui *ui) override;
       esp_err_t sendTo(uint32_t cid, const char *text) override;
+      std::unique_ptr<Stream> openStream(uint32_t cid, size_t size) override;
 
      private:
+      class WsStream;
       Httpd();
       httpd_config_t _config;
       httpd_handle_t _server = nullptr;
@@ -86,6 +90,10 @@ namespace esp32m {
       std::list<IHttpHandler *> _httpHandlers;
       std::mutex _wsSessionMutex;
       std::map<int, IWSHandler *> _wsSessions;
+      // messages to clients with a stream in progress, sent once it ends
+      std::mutex _streamsMutex;
+      std::map<int, std::vector<std::string> > _held;
+      esp_err_t queueText(int fd, const char *text);
       esp_err_t incomingReq(httpd_req_t *req);
       esp_err_t incomingWs(httpd_req_t *req);
       esp_err_t authenticate(httpd_req_t *req, bool &result);
@@ -16,10 +16,33 @@ namespace esp32m {
 
   namespace ui {
 
+    /** Message sent to a client in pieces, see Transport::openStream() */
+    class Stream : public stream::Writer {
+     public:
+      /** Completes the message, call once after the last write() */
+      virtual esp_err_t end() = 0;
+      /** Drops the message. If parts of it went out already, the client's
+       * session is closed, as the message can't be completed any more */
+      virtual void abort() = 0;
+      /** Whether any part of the message went out to the client */
+      virtual bool sent() const = 0;
+    };
+
     class Transport : public log::Loggable {
      public:
       virtual ~Transport() = default;
       virtual esp_err_t sendTo(uint32_t cid, const char* text) = 0;
+      /**
+       * Opens a message to the client that is sent out in pieces as it is
+       * written, so it never has to be held in memory whole. Messages of
+       * other senders to this client are held back until it ends.
+       * @param size Expected size of the message, 0 if unknown. Transports
+       * may decline to stream messages small enough to be sent whole
+       * @return nullptr if the message should be sent with sendTo() instead
+       */
+      virtual std::unique_ptr<Stream> openStream(uint32_t cid, size_t size) {
+        return nullptr;
+      }
 
       void broadcast(const char* text) {
         auto ids = _clientIdsView.load(std::memory_order_acquire);
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+# Decodes log files written by esp32m::log::Vfs with Format::Binary into the
+# same text lines the on-device formatter produces.
+#
+#   python decode-log.py /path/to/log.bin [log.bin.1 ...]
+#
+# Several files may be given (e.g. all rotated generations, oldest first),
+# each of them is self-contained.
+
+import sys
+import argparse
+import datetime
+
+MAGIC = b"m32L"
+VERSION = 1
+
+REC_NAME = 1
+REC_STAMP = 2
+REC_MESSAGE = 3
+
+LEVELS = "??EWIDV"
+
+
+class DecodeError(Exception):
+    pass
+
+
+class Reader:
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def eof(self):
+        return self.pos >= len(self.data)
+
+    def byte(self):
+        if self.eof():
+            raise DecodeError("unexpected end of data")
+        b = self.data[self.pos]
+        self.pos += 1
+        return b
+
+    def varint(self):
+        result = 0
+        shift = 0
+        while True:
+            b = self.byte()
+            result |= (b & 0x7F) << shift
+            if not b & 0x80:
+                return result
+            shift += 7
+            if shift > 63:
+                raise DecodeError("varint is too long at %d" % self.pos)
+
+    def bytes(self, n):
+        if self.pos + n > len(self.data):
+            raise DecodeError("unexpected end of data")
+        b = self.data[self.pos:self.pos + n]
+        self.pos += n
+        return b
+
+
+def format_stamp(stamp):
+    if stamp < 0:
+        stamp = -stamp
+        t = datetime.datetime.fromtimestamp(stamp // 1000, datetime.timezone.utc)
+        return "%s.%03d" % (t.strftime("%Y-%m-%d %H:%M:%S"), stamp % 1000)
+    millis = stamp % 1000
+    stamp //= 1000
+    seconds = stamp % 60
+    stamp //= 60
+    minutes = stamp % 60
+    stamp //= 60
+    return "%d:%02d:%02d:%02d.%03d" % (stamp // 24, stamp % 24, minutes, seconds, millis)
+
+
+def decode(data, out):
+    if data[:4] != MAGIC:
+        raise DecodeError("not an esp32m binary log")
+    if data[4] != VERSION:
+        raise DecodeError("unsupported version %d" % data[4])
+    r = Reader(data)
+    r.pos = 5
+    names = {}
+    stamp = None
+    while not r.eof():
+        tag = r.byte()
+        if tag == REC_NAME:
+            id = r.varint()
+            names[id] = r.bytes(r.varint()).decode("utf-8", "replace")
+        elif tag == REC_STAMP:
+            z = r.varint()
+            stamp = (z >> 1) ^ -(z & 1)
+        elif tag == REC_MESSAGE:
+            level = r.byte()
+            task = names.get(r.varint(), "?")
+            name = names.get(r.varint(), "?")
+            delta = r.varint()
+            message = r.bytes(r.varint()).decode("utf-8", "replace")
+            if stamp is None:
+                raise DecodeError("message without a time stamp at %d" % r.pos)
+            stamp = stamp - delta if stamp < 0 else stamp + delta
+            l = LEVELS[level] if level < len(LEVELS) else "?"
+            out.write("%s %s [%s] %s  %s\n" % (format_stamp(stamp), l, task, name, message))
+        else:
+            raise DecodeError("unknown record 0x%02x at %d" % (tag, r.pos - 1))
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode esp32m binary log files")
+    parser.add_argument("files", nargs="+", help="binary log files, oldest first")
+    args = parser.parse_args()
+    status = 0
+    for path in args.files:
+        with open(path, "rb") as f:
+            data = f.read()
+        try:
+            decode(data, sys.stdout)
+        except DecodeError as e:
+            # a truncated last record is expected if power was lost mid-write
+            sys.stderr.write("%s: %s\n" % (path, e))
+            status = 1
+    return status
+
+
+if __name__ == "__main__":
+    sys.exit(main())
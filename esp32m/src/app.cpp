@@ -9,12 +9,14 @@
 #include <sdkconfig.h>
 
 #include <dirent.h>
+#include <condition_variable>
 
 #include "esp32m/app.hpp"
 #include "esp32m/base.hpp"
 #include "esp32m/config/vfs.hpp"
 #include "esp32m/debug/button.hpp"
 #include "esp32m/debug/crashguard.hpp"
+#include "esp32m/debug/trace.hpp"
 #include "esp32m/events/broadcast.hpp"
 #include "esp32m/fs/littlefs.hpp"
 #include "esp32m/fs/spiffs.hpp"
@@ -27,6 +29,99 @@ namespace esp32m {
 
   App* _appInstance = nullptr;
 
+  const uint32_t InitWorkerStackSize = 4096;
+
+  class EventInit::Pool {
+   public:
+    // owns the jobs, helpers may still look at them after runDeferred()
+    // returned
+    Pool(std::vector<Deferred>&& jobs) : _jobs(std::move(jobs)) {}
+    void work() {
+      std::unique_lock lock(_mutex);
+      for (;;) {
+        Deferred* job = nullptr;
+        bool pending = false;
+        for (auto& d : _jobs) {
+          if (d.started)
+            continue;
+          pending = true;
+          if (ready(d)) {
+            job = &d;
+            break;
+          }
+        }
+        if (!job) {
+          if (!pending)
+            return;
+          if (_running) {
+            _cv.wait(lock);
+            continue;
+          }
+          // nothing is running and nothing is ready: circular dependency
+          for (auto& d : _jobs)
+            if (!d.started) {
+              job = &d;
+              break;
+            }
+          logw("dependencies of %s can't be satisfied", job->name);
+        }
+        job->started = true;
+        _running++;
+        lock.unlock();
+        auto started = millis();
+        job->fn();
+        logi("%s initialized in %lums", job->name, millis() - started);
+        lock.lock();
+        job->done = true;
+        _running--;
+        _cv.notify_all();
+      }
+    }
+    void wait() {
+      std::unique_lock lock(_mutex);
+      _cv.wait(lock, [this] { return !_running; });
+    }
+
+   private:
+    std::vector<Deferred> _jobs;
+    std::mutex _mutex;
+    std::condition_variable _cv;
+    int _running = 0;
+    bool ready(Deferred& job) {
+      for (auto name : job.after)
+        for (auto& d : _jobs)
+          if (!d.done && !strcmp(d.name, name))
+            return false;
+      return true;
+    }
+  };
+
+  void EventInit::runDeferred() {
+    if (_deferred.empty())
+      return;
+    int helpers =
+        std::min((int)_deferred.size(), CONFIG_ESP32M_INIT_WORKERS) - 1;
+    auto pool = std::make_shared<Pool>(std::move(_deferred));
+    _deferred.clear();
+    for (int i = 0; i < helpers; i++) {
+      // helpers keep the pool alive until they are completely done with it
+      auto ref = new std::shared_ptr<Pool>(pool);
+      if (xTaskCreate(
+              [](void* arg) {
+                auto ref = (std::shared_ptr<Pool>*)arg;
+                (*ref)->work();
+                delete ref;
+                vTaskDelete(nullptr);
+              },
+              "m/init", InitWorkerStackSize, ref, tskIDLE_PRIORITY + 1,
+              nullptr) != pdPASS)
+        delete ref;
+    }
+    pool->work();
+    // all jobs are started, wait for the ones still running on the helpers
+    pool->wait();
+  }
+
   void EventDone::publish(DoneReason reason) {
     EventDone ev(reason);
     EventManager::instance().publishBackwards(ev);
@@ -34,11 +129,17 @@ namespace esp32m {
 
   AppObject::AppObject() {
     _subscription = EventManager::instance().subscribe([this](Event& ev) {
+#if CONFIG_ESP32M_EVENTS_PROFILE
+      // name() is not available in the constructor, pick it up on first use
+      if (_subscription && !_subscription->name())
+        _subscription->setName(name());
+#endif
       Request* req;
       EventDescribe* ed;
-      if (Request::is(ev, interactiveName(), &req))
+      if (Request::is(ev, interactiveName(), &req)) {
+        debug::trace::Span span(name());
         handleRequest(*req);
-      else if (EventDescribe::is(ev, &ed)) {
+      } else if (EventDescribe::is(ev, &ed)) {
         ed->add(name(), descriptor());
       } else
         handleEvent(ev);
@@ -76,6 +177,11 @@ namespace esp32m {
     const char* iname = interactiveName();
     if (!strcmp(name, KeyStateGet)) {
       RequestContext ctx(req, req.data());
+      auto producer = stateProducer(ctx);
+      if (producer) {
+        req.respondStream(iname, producer);
+        return true;
+      }
       JsonDocument* state = getState(ctx);
       if (state) {
         json::check(this, state, "getState()");
@@ -133,8 +239,31 @@ namespace esp32m {
     return false;
   }
 
-  static uint32_t sketchSize() {
-    esp_image_metadata_t data;
+  namespace {
+    constexpr const char* SizeNvsNamespace = "app";
+    constexpr const char* SizeNvsKey = "size";
+
+    // image size of the build identified by the ELF SHA
+    struct SizeCache {
+      uint8_t sha[32];
+      uint32_t size;
+    };
+  }  // namespace
+
+  uint32_t App::sketchSize() {
+    if (_sketchSize)
+      return _sketchSize;
+    auto desc = esp_app_get_description();
+    SizeCache cache;
+    nvs_handle_t h;
+    if (nvs_open(SizeNvsNamespace, NVS_READONLY, &h) == ESP_OK) {
+      size_t len = sizeof(cache);
+      esp_err_t r = nvs_get_blob(h, SizeNvsKey, &cache, &len);
+      nvs_close(h);
+      if (r == ESP_OK && len == sizeof(cache) &&
+          !memcmp(cache.sha, desc->app_elf_sha256, sizeof(cache.sha)))
+        return _sketchSize = cache.size;
+    }
     const esp_partition_t* running = esp_ota_get_running_partition();
     if (!running)
       return 0;
@@ -142,9 +271,20 @@ namespace esp32m {
         .offset = running->address,
         .size = running->size,
     };
+    esp_image_metadata_t data = {};
     data.start_addr = running_pos.offset;
-    esp_image_verify(ESP_IMAGE_VERIFY, &running_pos, &data);
-    return data.image_len;
+    // the bootloader has verified the image already, only walk the segments
+    if (esp_image_get_metadata(&running_pos, &data) != ESP_OK ||
+        !data.image_len)
+      return 0;
+    memcpy(cache.sha, desc->app_elf_sha256, sizeof(cache.sha));
+    cache.size = data.image_len;
+    if (nvs_open(SizeNvsNamespace, NVS_READWRITE, &h) == ESP_OK) {
+      if (nvs_set_blob(h, SizeNvsKey, &cache, sizeof(cache)) == ESP_OK)
+        nvs_commit(h);
+      nvs_close(h);
+    }
+    return _sketchSize = cache.size;
   }
 
   App::Init::Init(const char* name, const char* version) {
@@ -223,7 +363,6 @@ namespace esp32m {
         .trigger_panic = true};
     esp_task_wdt_deinit();
     esp_task_wdt_init(&wdtc);
-    _sketchSize = sketchSize();
 #if CONFIG_ESP32M_LOG_CONSOLE
     log::addAppender(&log::Console::instance());
 #endif
@@ -289,7 +428,10 @@ namespace esp32m {
     for (int i = 0; i <= _maxInitLevel; i++) {
       EventInit evt(i);
       logI("init level %i", i);
+      auto started = millis();
       evt.publish();
+      evt.runDeferred();
+      logI("init level %i completed in %lums", i, millis() - started);
       _curInitLevel++;
     }
     xTaskCreate([](void* self) { ((App*)self)->run(); }, "m/app", 5120, this,
@@ -338,19 +480,13 @@ namespace esp32m {
     } else if (req.is("describe")) {
       EventDescribe ev;
       EventManager::instance().publish(ev);
-      // size_t size = JSON_OBJECT_SIZE(ev.descriptors.size());
-      if (ev.descriptors.size()) {
-        /*for (auto &e : ev.descriptors) {
-          size += JSON_STRING_SIZE(e.first.size()) + json::measure(e.second);
-        }*/
-        auto doc = new JsonDocument(); /* size */
-        auto root = doc->to<JsonObject>();
-        for (auto& e : ev.descriptors) {
-          root[e.first] = e.second;
-        }
-        req.respond(root, false);
-        delete doc;
-      } else
+      if (ev.descriptors.size())
+        req.respondStream(req.target(), [&ev](json::Writer& w) {
+          w.beginObject();
+          for (auto& e : ev.descriptors) w.member(e.first.c_str(), e.second);
+          w.endObject();
+        });
+      else
         req.respond();
       return true;
     }
@@ -381,7 +517,7 @@ namespace esp32m {
       info["version"] = _version;
     info["built"] = __DATE__ " " __TIME__;
     info["sdk"] = esp_get_idf_version();
-    info["size"] = _sketchSize;
+    info["size"] = sketchSize();
     return doc;
   }
 
@@ -398,7 +534,9 @@ namespace esp32m {
       info["version"] = _version;
     info["built"] = __DATE__ " " __TIME__;
     info["sdk"] = esp_get_idf_version();
-    info["size"] = _sketchSize;
+    // state is polled, don't make it wait for the image size
+    if (_sketchSize)
+      info["size"] = _sketchSize;
     return doc;
   }
 
@@ -1,13 +1,17 @@
 #include "esp32m/base.hpp"
 
+#include <assert.h>
 #include <esp_attr.h>
 #include <esp_timer.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <math.h>
+#include <atomic>
 #include <cstdarg>
 #include <cstdio>
-#include <map>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
 
 #define NOP() asm volatile("nop")
 
@@ -163,9 +167,113 @@ namespace esp32m {
 
   namespace locks {
 
-    std::map<gpio_num_t, std::mutex> _gpio_locks;
-    std::map<std::string, std::mutex> _locks;
-    std::map<uart_port_t, std::mutex> _uart_locks;
+    namespace {
+      std::mutex _registryMutex;
+      // locks are never removed, so references handed out stay valid
+      std::vector<std::unique_ptr<Lock> > _locks;
+      // keys point to the names owned by the locks
+      std::unordered_map<std::string_view, Id> _ids;
+      // locks by id in chunks that are never moved or freed, so that get(Id)
+      // can read them without taking the registry mutex
+      constexpr size_t ChunkSize = 32;
+      constexpr size_t MaxChunks = 64;
+      std::atomic<std::atomic<Lock*>*> _chunks[MaxChunks] = {};
+      std::atomic<Id> _count = 0;
+
+      Lock* lookup(const char* name) {
+        auto it = _ids.find(name);
+        return it == _ids.end() ? nullptr : _locks[it->second].get();
+      }
+
+      Lock& intern(const char* name) {
+        std::lock_guard guard(_registryMutex);
+        auto lock = lookup(name);
+        if (lock)
+          return *lock;
+        auto id = _locks.size();
+        assert(id < ChunkSize * MaxChunks);
+        auto& chunk = _chunks[id / ChunkSize];
+        if (!chunk.load(std::memory_order_relaxed))
+          chunk.store(new std::atomic<Lock*>[ChunkSize](),
+                      std::memory_order_release);
+        lock = new Lock(id, name);
+        _locks.emplace_back(lock);
+        _ids.emplace(lock->name(), lock->id());
+        chunk.load(std::memory_order_relaxed)[id % ChunkSize].store(
+            lock, std::memory_order_release);
+        _count.store(_locks.size(), std::memory_order_release);
+        return *lock;
+      }
+
+      std::string pinName(gpio_num_t pin) {
+        return string_printf("gpio%d", pin);
+      }
+    }  // namespace
+
+#if CONFIG_ESP32M_LOCK_STATS
+    namespace {
+      void currentTaskName(char* dst) {
+        const char* name = pcTaskGetName(xTaskGetCurrentTaskHandle());
+        strlcpy(dst, name ? name : "?", CONFIG_FREERTOS_MAX_TASK_NAME_LEN);
+      }
+    }  // namespace
+
+    void Lock::acquired() {
+      _stats.acquisitions++;
+      currentTaskName(_owner);
+      _acquiredAt = esp_timer_get_time();
+    }
+
+    void Lock::lock() {
+      if (_mutex.try_lock()) {
+        acquired();
+        return;
+      }
+      // the owner may change while we copy, a torn name is acceptable here
+      char blocker[CONFIG_FREERTOS_MAX_TASK_NAME_LEN];
+      memcpy(blocker, _owner, sizeof(blocker));
+      blocker[sizeof(blocker) - 1] = 0;
+      auto started = esp_timer_get_time();
+      _mutex.lock();
+      uint32_t waited = esp_timer_get_time() - started;
+      _stats.contended++;
+      if (waited > _stats.maxWaitUs) {
+        _stats.maxWaitUs = waited;
+        currentTaskName(_stats.waiter);
+        memcpy(_stats.blocker, blocker, sizeof(blocker));
+      }
+      acquired();
+    }
+
+    bool Lock::try_lock() {
+      if (!_mutex.try_lock())
+        return false;
+      acquired();
+      return true;
+    }
+
+    void Lock::unlock() {
+      uint32_t held = esp_timer_get_time() - _acquiredAt;
+      if (held > _stats.maxHoldUs) {
+        _stats.maxHoldUs = held;
+        memcpy(_stats.holder, _owner, sizeof(_owner));
+      }
+      _owner[0] = 0;
+      _mutex.unlock();
+    }
+
+    Lock::Stats Lock::stats() const {
+      return _stats;
+    }
+
+    void Lock::resetStats() {
+      _stats = {};
+    }
+
+    const char* Lock::owner() const {
+      return _owner[0] ? _owner : nullptr;
+    }
+#endif
 
     Guard::Guard(const char* name) : _lock(find(name)) {
       if (_lock)
@@ -175,44 +283,47 @@ namespace esp32m {
       if (_lock)
         _lock->lock();
     }
+    Guard::Guard(Id id) : _lock(&get(id)) {
+      _lock->lock();
+    }
     Guard::~Guard() {
       if (_lock)
         _lock->unlock();
     }
 
-    std::mutex& get(const char* name) {
-      auto it = _locks.find(name);
-      if (it != _locks.end())
-        return it->second;
-      return _locks[name];
+    Id id(const char* name) {
+      return intern(name).id();
+    }
+
+    Id count() {
+      return _count.load(std::memory_order_acquire);
+    }
+
+    Lock& get(Id id) {
+      assert(id < count());
+      auto chunk = _chunks[id / ChunkSize].load(std::memory_order_acquire);
+      return *chunk[id % ChunkSize].load(std::memory_order_acquire);
+    }
+
+    Lock& get(const char* name) {
+      return intern(name);
     }
 
-    std::mutex* find(const char* name) {
-      auto it = _locks.find(name);
-      if (it != _locks.end())
-        return &it->second;
-      return nullptr;
+    Lock* find(const char* name) {
+      std::lock_guard guard(_registryMutex);
+      return lookup(name);
     }
 
-    std::mutex& get(gpio_num_t pin) {
-      auto it = _gpio_locks.find(pin);
-      if (it != _gpio_locks.end())
-        return it->second;
-      return _gpio_locks[pin];
+    Lock& get(gpio_num_t pin) {
+      return intern(pinName(pin).c_str());
     }
 
-    std::mutex* find(gpio_num_t pin) {
-      auto it = _gpio_locks.find(pin);
-      if (it != _gpio_locks.end())
-        return &it->second;
-      return nullptr;
+    Lock* find(gpio_num_t pin) {
+      return find(pinName(pin).c_str());
     }
 
-    std::mutex& uart(uart_port_t port) {
-      auto it = _uart_locks.find(port);
-      if (it != _uart_locks.end())
-        return it->second;
-      return _uart_locks[port];
+    Lock& uart(uart_port_t port) {
+      return intern(string_printf("uart%d", port).c_str());
     }
   }  // namespace locks
 
@@ -1,5 +1,6 @@
 #include "esp32m/base.hpp"
 #include "esp32m/bus/modbus.hpp"
+#include "esp32m/debug/trace.hpp"
 #include "esp32m/defs.hpp"
 
 namespace esp32m {
@@ -56,9 +57,16 @@ namespace esp32m {
       _config.ser_opts.stop_bits = UART_STOP_BITS_1;
       _mutex = &locks::uart(port);
 
-      if (changed && _running) {
-        stop();
-        start();
+      if (changed && _handle) {
+        // the controller keeps its own copy of the options, restarting it is
+        // not enough for them to take effect
+        std::lock_guard guard(*_mutex);
+        auto running = _running;
+        (void)stopNoLock();
+        (void)mbc_master_delete(_handle);
+        _handle = nullptr;
+        if (running)
+          ESP_ERROR_CHECK_WITHOUT_ABORT(startNoLock());
       }
       _configured = true;
     }
@@ -185,10 +193,11 @@ namespace esp32m {
     }
 
     esp_err_t Master::request(uint8_t addr, Command command, uint16_t reg_start,
-                              uint16_t reg_size, void* data) {
+                              uint16_t reg_size, void* data, bool recover) {
       if (!_mutex)
         return ESP_ERR_INVALID_STATE;
       std::lock_guard guard(*_mutex);
+      debug::trace::Span span("modbus");
       if (!_running)
         ESP_CHECK_RETURN(startNoLock());
       mb_param_request_t req = {.slave_addr = addr,
@@ -197,6 +206,11 @@ namespace esp32m {
                                 .reg_size = reg_size};
       auto err = mbc_master_send_request(_handle, &req, data);
       if (err == ESP_ERR_TIMEOUT || err == ESP_ERR_INVALID_RESPONSE) {
+        if (!recover) {
+          // drop a late reply so that it is not taken for the next one
+          (void)uart_flush_input(_config.ser_opts.port);
+          return err;
+        }
         if (resetNoLock() == ESP_OK)
           err = mbc_master_send_request(_handle, &req, data);
       }
@@ -29,6 +29,11 @@ namespace esp32m {
       bool I2C::handleRequest(Request &req) {
         if (AppObject::handleRequest(req))
           return true;
+        if (req.is("i2c", "cancel")) {
+          _cancel = true;
+          req.respond("i2c", ESP_OK);
+          return true;
+        }
         if (req.is("i2c", "scan")) {
           auto data = req.data();
           if (_pendingResponse) {
@@ -73,14 +78,10 @@ namespace esp32m {
           esp_task_wdt_reset();
           if (_pendingResponse) {
             memset(&_ids, 0, sizeof(_ids));
-            scan();
-            JsonDocument *doc = new JsonDocument(
-                /*JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(sizeof(_ids))*/);
-                auto root=doc->to<JsonObject>();
-            auto ids = root["ids"].to<JsonArray>();
-            for (auto i = 0; i < sizeof(_ids); i++) ids.add(_ids[i]);
-            _pendingResponse->setData(doc);
-            _pendingResponse->publish();
+            _cancel = false;
+            _aborted = false;
+            auto done = scan();
+            publishScan(100, false, !done);
             delete _pendingResponse;
             _pendingResponse = nullptr;
           }
@@ -101,7 +102,24 @@ namespace esp32m {
               }
             }
       */
-      void I2C::scan() {
+      void I2C::publishScan(int progress, bool partial, bool cancelled) {
+        JsonDocument *doc = new JsonDocument(
+            /*JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(sizeof(_ids))*/);
+        auto root = doc->to<JsonObject>();
+        if (partial)
+          root["progress"] = progress;
+        else if (cancelled)
+          root["cancelled"] = true;
+        else if (_aborted)
+          root["aborted"] = true;
+        auto ids = root["ids"].to<JsonArray>();
+        for (auto i = 0; i < sizeof(_ids); i++) ids.add(_ids[i]);
+        _pendingResponse->setPartial(partial);
+        _pendingResponse->setData(doc);
+        _pendingResponse->publish();
+      }
+
+      bool I2C::scan() {
         i2c_master_bus_config_t busConfig = {.i2c_port = I2C_NUM_0,
                                              .sda_io_num = (gpio_num_t)_pinSDA,
                                              .scl_io_num = (gpio_num_t)_pinSCL,
@@ -114,18 +132,34 @@ namespace esp32m {
                                                  .allow_pd = false,
                                              }};
         i2c::MasterBus *bus = nullptr;
-        if (i2c::MasterBus::New(busConfig, &bus) != ESP_OK)
-          return;
+        if (i2c::MasterBus::New(busConfig, &bus) != ESP_OK) {
+          logW("i2c bus could not be created, scan aborted");
+          _aborted = true;
+          return true;
+        }
 
+        bool done = true;
         for (int i = _startId; i <= _endId; i++) {
+          if (_cancel) {
+            done = false;
+            break;
+          }
           esp_err_t err = bus->probe(i, 30);
           if (err == ESP_OK) {
             logI("found i2c device at 0x%02x", i);
             _ids[i >> 3] |= 1 << (i & 7);
+            publishScan((i - _startId) * 100 / (_endId - _startId + 1), true);
+          } else if (err == ESP_ERR_TIMEOUT) {
+            // a stuck or unpulled bus times out on every address, no point in
+            // going on
+            logW("i2c bus timed out at 0x%02x, scan aborted", i);
+            _aborted = true;
+            break;
           }
           esp_task_wdt_reset();
         }
         delete bus;
+        return done;
       }
 
       I2C *useI2C() {
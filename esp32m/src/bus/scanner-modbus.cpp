@@ -12,6 +12,8 @@
 #include "esp32m/bus/modbus.hpp"
 #include "esp32m/bus/scanner/modbus.hpp"
 
+#include <algorithm>
+
 namespace esp32m {
   namespace bus {
     namespace scanner {
@@ -26,6 +28,8 @@ namespace esp32m {
         root["uart"] = _uart;
         root["baud"] = _baud;
         root["parity"] = _parity;
+        root["auto"] = _auto;
+        root["timeout"] = _timeout;
         root["addr"] = _addr;
         if (_cmd)
           root["cmd"] = _cmd;
@@ -50,6 +54,8 @@ namespace esp32m {
         json::from(data["uart"], _uart, &changed);
         json::from(data["baud"], _baud, &changed);
         json::fromIntCastable(data["parity"], _parity, &changed);
+        json::from(data["auto"], _auto, &changed);
+        json::from(data["timeout"], _timeout, &changed);
         json::from(data["regs"], _regs, &changed);
         json::from(data["regc"], _regc, &changed);
         json::fromIntCastable(data["cmd"], _cmd, &changed);
@@ -77,12 +83,21 @@ namespace esp32m {
           _addr = 1;
           changed = true;
         }
+        if (_timeout < 30) {
+          _timeout = 30;
+          changed = true;
+        }
         return changed;
       }
 
       bool Modbus::handleRequest(Request &req) {
         if (AppObject::handleRequest(req))
           return true;
+        if (req.is("cancel")) {
+          _cancel = true;
+          req.respond();
+          return true;
+        }
         if (req.is("scan") || req.is("request") || req.is("write")) {
           auto data = req.data();
           if (_pendingResponse)
@@ -90,6 +105,7 @@ namespace esp32m {
           else {
             RequestContext ctx(req, data);
             setConfig(ctx);
+            _resume = req.is("scan") && (data["resume"] | false);
             _pendingResponse = req.makeResponse();
             config::Changed::publish(this, true);
             xTaskNotifyGive(_task);
@@ -116,46 +132,31 @@ namespace esp32m {
         for (;;) {
           esp_task_wdt_reset();
           if (_pendingResponse) {
-            memset(&_addrs, 0, sizeof(_addrs));
             modbus::Master &mb = modbus::Master::instance();
             esp_err_t err = ESP_OK;
+            // the master is shared with the configured devices, hand it back
+            // with their serial settings however the request ends
+            bool restore = mb.isConfigured();
+            auto ser = mb.config().ser_opts;
+            auto rxTimeout = mb.uartRxTimeout();
+            auto respTimeout = mb.responseTimeout();
             mb.configureSerial(_uart, _baud, _parity, _ascii);
             if (!mb.isRunning())
               err = mb.start();
             if (mb.isRunning()) {
               if (_pendingResponse->is("scan")) {
-                auto t = millis();
-
-                for (int i = _startAddr; i <= _endAddr; i++) {
-                  uint16_t reg;
-                  err = mb.request(i, modbus::Command::ReadInput, 0, 1, &reg);
-                  if (err != ESP_OK)
-                    err =
-                        mb.request(i, modbus::Command::ReadHolding, 0, 1, &reg);
-                  if (err == ESP_OK) {
-                    logI("found modbus device at 0x%02x", i);
-                    _addrs[i >> 3] |= 1 << (i & 7);
-                  }
-                  if (millis() - t > 1000) {
-                    t = millis();
-                    JsonDocument *progressDoc =
-                        new JsonDocument(); /* JSON_OBJECT_SIZE(1) */
-                    progressDoc->to<JsonObject>()["progress"] =
-                        (i - _startAddr) * 100 / (_endAddr - _startAddr);
-                    _pendingResponse->setPartial(true);
-                    _pendingResponse->setData(progressDoc);
-                    _pendingResponse->publish();
-                  }
-                  esp_task_wdt_reset();
+                if (!_resume || !_nextAddr) {
+                  memset(&_addrs, 0, sizeof(_addrs));
+                  _found.clear();
+                  _serialIdx = 0;
+                  _nextAddr = _startAddr;
+                  _turnaround = -1;
                 }
-                JsonDocument *doc = new JsonDocument(
-                    /*JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(sizeof(_addrs))*/);
-                auto root = doc->to<JsonObject>();
-                auto addrs = root["addrs"].to<JsonArray>();
-                for (auto i = 0; i < sizeof(_addrs); i++) addrs.add(_addrs[i]);
-                _pendingResponse->setPartial(false);
-                _pendingResponse->setData(doc);
-                _pendingResponse->publish();
+                _cancel = false;
+                auto done = scan();
+                if (done)
+                  _nextAddr = 0;
+                publishScan(100, false, !done);
               } else if (_pendingResponse->is("request") && _cmd && _regc) {
                 void *buf = malloc(_regc * 2);
                 err = mb.request(_addr, _cmd, _regs, _regc, buf);
@@ -178,6 +179,9 @@ namespace esp32m {
                 _pendingResponse->publish();
               }
             }
+            if (restore)
+              mb.configureSerial(ser.port, ser.baudrate, ser.parity,
+                                 ser.mode == MB_ASCII, rxTimeout, respTimeout);
             delete _pendingResponse;
             _pendingResponse = nullptr;
           }
@@ -185,6 +189,113 @@ namespace esp32m {
         }
       }
 
+      std::vector<Modbus::Serial> Modbus::serials() {
+        // the settings RS-485 meters and sensors ship with most often
+        static const Serial Common[] = {
+            {9600, UART_PARITY_DISABLE},  {19200, UART_PARITY_DISABLE},
+            {9600, UART_PARITY_EVEN},     {4800, UART_PARITY_DISABLE},
+            {38400, UART_PARITY_DISABLE}, {115200, UART_PARITY_DISABLE},
+            {19200, UART_PARITY_EVEN},    {2400, UART_PARITY_DISABLE},
+            {57600, UART_PARITY_DISABLE}, {9600, UART_PARITY_ODD},
+        };
+        std::vector<Serial> result = {{_baud, _parity}};
+        if (_auto)
+          for (auto &s : Common)
+            if (s.baud != _baud || s.parity != _parity)
+              result.push_back(s);
+        return result;
+      }
+
+      // 8 byte probe and 7 byte reply, 11 bits per character
+      static int frameMs(uint32_t baud) {
+        return 15 * 11 * 1000 / baud + 1;
+      }
+
+      uint32_t Modbus::responseTimeout(uint32_t baud) {
+        if (_turnaround < 0)
+          return _timeout;
+        return std::clamp<uint32_t>(2 * _turnaround + frameMs(baud) + 20, 30,
+                                    _timeout);
+      }
+
+      bool Modbus::scan() {
+        modbus::Master &mb = modbus::Master::instance();
+        auto list = serials();
+        int range = _endAddr - _startAddr + 1;
+        int total = list.size() * range;
+        auto t = millis();
+        for (; _serialIdx < (int)list.size();
+             _serialIdx++, _nextAddr = _startAddr) {
+          auto &s = list[_serialIdx];
+          auto timeout = responseTimeout(s.baud);
+          mb.configureSerial(_uart, s.baud, s.parity, _ascii, 3, timeout);
+          for (; _nextAddr <= _endAddr; _nextAddr++) {
+            if (_cancel)
+              return false;
+            auto i = _nextAddr;
+            auto progress =
+                (_serialIdx * range + i - _startAddr) * 100 / total;
+            uint16_t reg;
+            auto started = millis();
+            auto err = mb.request(i, modbus::Command::ReadInput, 0, 1, &reg,
+                                  false);
+            // an absent slave times out, one without input registers replies
+            // with an exception
+            if (err != ESP_OK && err != ESP_ERR_TIMEOUT)
+              err = mb.request(i, modbus::Command::ReadHolding, 0, 1, &reg,
+                               false);
+            if (err == ESP_OK) {
+              logI("found modbus device at 0x%02x, baud=%d, parity=%d", i,
+                   s.baud, s.parity);
+              _addrs[i >> 3] |= 1 << (i & 7);
+              _found.push_back({(uint8_t)i, s});
+              if (_turnaround < 0) {
+                _turnaround =
+                    std::max<int>(0, millis() - started - frameMs(s.baud));
+                auto shorter = responseTimeout(s.baud);
+                if (shorter < timeout) {
+                  timeout = shorter;
+                  logI("response timeout reduced to %d ms", timeout);
+                  mb.configureSerial(_uart, s.baud, s.parity, _ascii, 3,
+                                     timeout);
+                }
+              }
+              t = millis();
+              publishScan(progress, true);
+            } else if (millis() - t > 1000) {
+              t = millis();
+              publishScan(progress, true);
+            }
+            esp_task_wdt_reset();
+          }
+        }
+        return true;
+      }
+
+      void Modbus::publishScan(int progress, bool partial, bool cancelled) {
+        JsonDocument *doc = new JsonDocument();
+        auto root = doc->to<JsonObject>();
+        if (partial)
+          root["progress"] = progress;
+        else {
+          auto addrs = root["addrs"].to<JsonArray>();
+          for (auto i = 0; i < sizeof(_addrs); i++) addrs.add(_addrs[i]);
+          if (cancelled)
+            root["cancelled"] = true;
+        }
+        // [addr, baud, parity] of every slave found so far
+        auto found = root["found"].to<JsonArray>();
+        for (auto &f : _found) {
+          auto entry = found.add<JsonArray>();
+          entry.add(f.addr);
+          entry.add(f.serial.baud);
+          entry.add((int)f.serial.parity);
+        }
+        _pendingResponse->setPartial(partial);
+        _pendingResponse->setData(doc);
+        _pendingResponse->publish();
+      }
+
       Modbus *useModbus() {
         return &Modbus::instance();
       }
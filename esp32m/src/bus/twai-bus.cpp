@@ -0,0 +1,90 @@
+#include <esp_timer.h>
+
+#include "esp32m/bus/twai/bus.hpp"
+#include "esp32m/defs.hpp"
+
+namespace esp32m {
+  namespace twai {
+
+    Bus::Bus(const char *name, twai_node_handle_t handle, int poolDepth,
+             int txDepth)
+        : _name(name),
+          _router(&_twai, txDepth),
+          _twai(
+              handle, [this](twai_frame_t *frame) { _router.dispatch(*frame); },
+              poolDepth) {
+      _twai.onTxDone([this](int count) {
+        _router.txDone(count);
+        if (_task)
+          xTaskNotifyGive(_task);
+      });
+      xTaskCreate([](void *self) { ((Bus *)self)->run(); }, "m/twai/tx",
+                  3072, this, 5, &_task);
+    }
+
+    Bus::~Bus() {
+      // the node goes first, so that its RX task no longer reports
+      // transmissions to the router or wakes the TX task
+      _twai.stop();
+      if (_task) {
+        // the TX task may be pumping the router holding its mutex, let it
+        // finish and exit by itself
+        _stopped = true;
+        xTaskNotifyGive(_task);
+        while (!_exited) delay(1);
+        _task = nullptr;
+      }
+    }
+
+    esp_err_t Bus::send(const twai_frame_t &frame, uint8_t priority) {
+      ESP_CHECK_RETURN(_router.send(frame, priority));
+      xTaskNotifyGive(_task);
+      return ESP_OK;
+    }
+
+    void Bus::run() {
+      while (!_stopped) {
+        auto wait = _router.pump();
+        ulTaskNotifyTake(pdTRUE, wait < 0 ? portMAX_DELAY
+                                          : pdMS_TO_TICKS(wait / 1000) + 1);
+      }
+      _exited = true;
+      vTaskDelete(NULL);
+    }
+
+    JsonDocument *Bus::getState(RequestContext &ctx) {
+      static const char *const StateNames[] = {"error_active", "error_warning",
+                                               "error_passive", "bus_off"};
+      auto node = _twai.stats();
+      auto router = _router.stats();
+      auto doc = new JsonDocument();
+      auto root = doc->to<JsonObject>();
+      root["state"] = StateNames[node.state];
+      root["transitions"] = node.transitions;
+      root["busErrors"] = node.busErrors;
+      root["rx"] = node.rx;
+      root["rxDropped"] = node.drops;
+      root["unhandled"] = router.unhandled;
+      root["tx"] = router.tx;
+      root["txDropped"] = router.txDropped;
+      root["txLimited"] = router.txLimited;
+      root["queued"] = _router.queued();
+      // rates since the previous state request
+      auto stamp = esp_timer_get_time();
+      if (_lastStamp && stamp > _lastStamp) {
+        float seconds = (stamp - _lastStamp) / 1000000.0f;
+        root["rxRate"] = (node.rx - _lastRx) / seconds;
+        root["txRate"] = (router.tx - _lastTx) / seconds;
+      }
+      _lastRx = node.rx;
+      _lastTx = router.tx;
+      _lastStamp = stamp;
+      return doc;
+    }
+
+    Bus *useBus(const char *name, twai_node_handle_t handle) {
+      return new Bus(name, handle);
+    }
+
+  }  // namespace twai
+}  // namespace esp32m
@@ -0,0 +1,163 @@
+#include <esp_timer.h>
+#include <string.h>
+
+#include "esp32m/bus/twai/router.hpp"
+
+namespace esp32m {
+  namespace twai {
+
+    Router::Router(Node *node, int txDepth, int inFlight)
+        : _node(node), _inFlightMax(inFlight) {
+      _slots.resize(txDepth);
+      for (int i = txDepth - 1; i >= 0; i--)
+        _free.push_back(i);
+      _queue.reserve(txDepth);
+    }
+
+    int Router::on(uint32_t id, uint32_t mask, Handler handler) {
+      std::lock_guard guard(_rxMutex);
+      auto handle = ++_nextHandle;
+      if (mask == ExactMask)
+        _exact[id].push_back({handle, id, mask, handler});
+      else
+        _masked.push_back({handle, id, mask, handler});
+      return handle;
+    }
+
+    void Router::off(int handle) {
+      std::lock_guard guard(_rxMutex);
+      auto matches = [handle](const Route &r) { return r.handle == handle; };
+      std::erase_if(_masked, matches);
+      for (auto it = _exact.begin(); it != _exact.end(); it++)
+        if (std::erase_if(it->second, matches)) {
+          if (it->second.empty())
+            _exact.erase(it);
+          break;
+        }
+    }
+
+    void Router::dispatch(const twai_frame_t &frame) {
+      std::lock_guard guard(_rxMutex);
+      auto id = frame.header.id;
+      bool handled = false;
+      auto it = _exact.find(id);
+      if (it != _exact.end())
+        for (auto &r : it->second) {
+          r.handler(frame);
+          handled = true;
+        }
+      for (auto &r : _masked)
+        if ((id & r.mask) == (r.id & r.mask)) {
+          r.handler(frame);
+          handled = true;
+        }
+      _stats.rx++;
+      if (!handled)
+        _stats.unhandled++;
+    }
+
+    esp_err_t Router::send(const twai_frame_t &frame, uint8_t priority) {
+      if (frame.buffer_len > TWAI_FRAME_MAX_LEN)
+        return ESP_ERR_INVALID_SIZE;
+      std::lock_guard guard(_txMutex);
+      if (_free.empty()) {
+        _stats.txDropped++;
+        return ESP_ERR_NO_MEM;
+      }
+      auto i = _free.back();
+      _free.pop_back();
+      auto &s = _slots[i];
+      s.frame = frame;
+      s.frame.buffer = s.data;
+      if (frame.buffer_len)
+        memcpy(s.data, frame.buffer, frame.buffer_len);
+      s.priority = priority;
+      s.seq = _seq++;
+      s.limited = false;
+      _queue.push_back(i);
+      return ESP_OK;
+    }
+
+    void Router::setRateLimit(uint32_t id, uint32_t intervalUs) {
+      std::lock_guard guard(_txMutex);
+      if (intervalUs)
+        _limits[id].first = intervalUs;
+      else
+        _limits.erase(id);
+    }
+
+    bool Router::before(int a, int b) const {
+      auto &sa = _slots[a];
+      auto &sb = _slots[b];
+      if (sa.priority != sb.priority)
+        return sa.priority < sb.priority;
+      if (sa.frame.header.id != sb.frame.header.id)
+        return sa.frame.header.id < sb.frame.header.id;
+      return (int32_t)(sa.seq - sb.seq) < 0;
+    }
+
+    int64_t Router::pump(int64_t now) {
+      std::lock_guard guard(_txMutex);
+      int64_t wait = -1;
+      while ((int)_inFlight.size() < _inFlightMax) {
+        int best = -1;
+        size_t bestPos = 0;
+        wait = -1;
+        for (size_t p = 0; p < _queue.size(); p++) {
+          auto i = _queue[p];
+          auto &s = _slots[i];
+          auto l = _limits.find(s.frame.header.id);
+          if (l != _limits.end() && l->second.second > now) {
+            auto w = l->second.second - now;
+            if (wait < 0 || w < wait)
+              wait = w;
+            if (!s.limited) {
+              s.limited = true;
+              _stats.txLimited++;
+            }
+            continue;
+          }
+          if (best < 0 || before(i, best)) {
+            best = i;
+            bestPos = p;
+          }
+        }
+        if (best < 0)
+          break;
+        // the node is full, txDone() will get things going again
+        if (_node->transmit(&_slots[best].frame) != ESP_OK)
+          break;
+        _queue.erase(_queue.begin() + bestPos);
+        _inFlight.push_back(best);
+        _stats.tx++;
+        auto l = _limits.find(_slots[best].frame.header.id);
+        if (l != _limits.end())
+          l->second.second = now + l->second.first;
+      }
+      return wait;
+    }
+
+    int64_t Router::pump() {
+      return pump(esp_timer_get_time());
+    }
+
+    void Router::txDone(int count) {
+      std::lock_guard guard(_txMutex);
+      while (count-- > 0 && !_inFlight.empty()) {
+        _free.push_back(_inFlight.front());
+        _inFlight.pop_front();
+      }
+    }
+
+    size_t Router::queued() {
+      std::lock_guard guard(_txMutex);
+      return _queue.size();
+    }
+
+    Router::Stats Router::stats() {
+      std::scoped_lock guard(_rxMutex, _txMutex);
+      return _stats;
+    }
+
+  }  // namespace twai
+}  // namespace esp32m
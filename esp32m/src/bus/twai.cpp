@@ -18,41 +18,39 @@ namespace esp32m {
       _pool[i].frame.buffer_len = sizeof(_pool[i].data);
     }
 
-    _freeSem = xSemaphoreCreateCounting(_poolDepth, _poolDepth);
-    _readySem = xSemaphoreCreateCounting(_poolDepth, 0);
+    // the task must exist before any ISR can notify it
+    xTaskCreate([](void* self) { static_cast<TWAI*>(self)->run(); },
+                "m/twai/rx", 3072, this, 5, &_task);
 
     twai_event_callbacks_t cbs = {};
     cbs.on_rx_done = rxIsr;
+    cbs.on_tx_done = txIsr;
     cbs.on_error = errorIsr;
     cbs.on_state_change = stateIsr;
     ESP_ERROR_CHECK_WITHOUT_ABORT(
         twai_node_register_event_callbacks(_handle, &cbs, this));
-
-    xTaskCreate([](void* self) { static_cast<TWAI*>(self)->run(); },
-                "m/twai/rx", 3072, this, 5, &_task);
   }
 
   TWAI::~TWAI() {
+    stop();
+    delete[] _pool;
+    _pool = nullptr;
+  }
+
+  void TWAI::stop() {
     // Delete the node first so no further ISR callbacks can fire before we
-    // tear down the task and free the pool.
+    // tear down the task.
     if (_handle) {
       ESP_ERROR_CHECK_WITHOUT_ABORT(twai_node_delete(_handle));
       _handle = nullptr;
     }
+    // The task may be inside a callback holding locks of its handlers, let
+    // it return and exit by itself.
     if (_task) {
-      vTaskDelete(_task);
+      xTaskNotify(_task, NotifyStop, eSetBits);
+      while (!_exited.load(std::memory_order_acquire)) vTaskDelay(1);
       _task = nullptr;
     }
-    if (_readySem) {
-      vSemaphoreDelete(_readySem);
-      _readySem = nullptr;
-    }
-    if (_freeSem) {
-      vSemaphoreDelete(_freeSem);
-      _freeSem = nullptr;
-    }
-    delete[] _pool;
-    _pool = nullptr;
   }
 
   // ISR: called by the TWAI driver when a frame has been received.
@@ -65,18 +63,32 @@ namespace esp32m {
     auto* self = static_cast<TWAI*>(ctx);
 
     // Claim a free slot; if the pool is exhausted the frame is dropped.
-    if (xSemaphoreTakeFromISR(self->_freeSem, &woken) != pdTRUE)
-      return woken == pdTRUE;
-
-    PoolSlot& slot = self->_pool[self->_writeIdx];
-    if (twai_node_receive_from_isr(handle, &slot.frame) == ESP_OK) {
-      self->_writeIdx = (self->_writeIdx + 1) % self->_poolDepth;
-      xSemaphoreGiveFromISR(self->_readySem, &woken);
-    } else {
-      // Receive failed; return the slot to the free pool.
-      xSemaphoreGiveFromISR(self->_freeSem, &woken);
+    int w = self->_writeIdx.load(std::memory_order_relaxed);
+    int next = (w + 1) % self->_poolDepth;
+    if (next == self->_readIdx.load(std::memory_order_acquire)) {
+      self->_drops.fetch_add(1, std::memory_order_relaxed);
+      return false;
     }
 
+    PoolSlot& slot = self->_pool[w];
+    slot.frame.buffer_len = sizeof(slot.data);
+    if (twai_node_receive_from_isr(handle, &slot.frame) != ESP_OK)
+      return false;
+    self->_writeIdx.store(next, std::memory_order_release);
+    self->_rx.fetch_add(1, std::memory_order_relaxed);
+    xTaskNotifyFromISR(self->_task, NotifyRx, eSetBits, &woken);
+    return woken == pdTRUE;
+  }
+
+  // ISR: called when the node has finished sending a frame, successfully or
+  // not. The frame buffer may be reused from now on.
+  bool IRAM_ATTR TWAI::txIsr(twai_node_handle_t /*handle*/,
+                              const twai_tx_done_event_data_t* /*edata*/,
+                              void* ctx) {
+    BaseType_t woken = pdFALSE;
+    auto* self = static_cast<TWAI*>(ctx);
+    self->_txDone.fetch_add(1, std::memory_order_relaxed);
+    xTaskNotifyFromISR(self->_task, NotifyTx, eSetBits, &woken);
     return woken == pdTRUE;
   }
 
@@ -84,7 +96,8 @@ namespace esp32m {
   // ESP_EARLY_LOG* must be used here - regular logX macros are not ISR-safe.
   bool IRAM_ATTR TWAI::errorIsr(twai_node_handle_t /*handle*/,
                                  const twai_error_event_data_t* edata,
-                                 void* /*ctx*/) {
+                                 void* ctx) {
+    static_cast<TWAI*>(ctx)->_busErrors.fetch_add(1, std::memory_order_relaxed);
     ESP_EARLY_LOGW("twai", "bus error: 0x%x", (unsigned)edata->err_flags.val);
     return false;
   }
@@ -92,7 +105,10 @@ namespace esp32m {
   // ISR: called on node state transitions (error_active/warning/passive/bus_off).
   bool IRAM_ATTR TWAI::stateIsr(twai_node_handle_t /*handle*/,
                                  const twai_state_change_event_data_t* edata,
-                                 void* /*ctx*/) {
+                                 void* ctx) {
+    auto* self = static_cast<TWAI*>(ctx);
+    self->_state.store(edata->new_sta, std::memory_order_relaxed);
+    self->_transitions.fetch_add(1, std::memory_order_relaxed);
     static const char* const kStateNames[] = {"error_active", "error_warning",
                                               "error_passive", "bus_off"};
     ESP_EARLY_LOGI("twai", "state: %s -> %s", kStateNames[edata->old_sta],
@@ -100,15 +116,30 @@ namespace esp32m {
     return false;
   }
 
-  // Task: dequeues frames from the pool and dispatches them to _rxCallback.
+  // Task: drains every frame that is ready in the pool per wakeup, then
+  // reports completed transmissions.
   void TWAI::run() {
     for (;;) {
-      if (xSemaphoreTake(_readySem, portMAX_DELAY) != pdTRUE)
-        continue;
-      _rxCallback(&_pool[_readIdx].frame);
-      _readIdx = (_readIdx + 1) % _poolDepth;
-      xSemaphoreGive(_freeSem);
+      uint32_t bits = 0;
+      xTaskNotifyWait(0, NotifyRx | NotifyTx | NotifyStop, &bits,
+                      portMAX_DELAY);
+      if (bits & NotifyStop)
+        break;
+      int r = _readIdx.load(std::memory_order_relaxed);
+      while (r != _writeIdx.load(std::memory_order_acquire)) {
+        _rxCallback(&_pool[r].frame);
+        r = (r + 1) % _poolDepth;
+        _readIdx.store(r, std::memory_order_release);
+      }
+      auto done = _txDone.load(std::memory_order_relaxed);
+      if (done != _txReported) {
+        if (_txDoneCallback)
+          _txDoneCallback(done - _txReported);
+        _txReported = done;
+      }
     }
+    _exited.store(true, std::memory_order_release);
+    vTaskDelete(NULL);
   }
 
 }  // namespace esp32m
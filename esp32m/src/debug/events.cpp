@@ -0,0 +1,72 @@
+#include "esp32m/debug/events.hpp"
+
+namespace esp32m {
+  namespace debug {
+
+    Events &Events::instance() {
+      static Events i;
+      return i;
+    }
+
+    bool Events::handleRequest(Request &req) {
+      if (AppObject::handleRequest(req))
+        return true;
+#if CONFIG_ESP32M_EVENTS_PROFILE
+      if (req.is("reset")) {
+        auto &em = EventManager::instance();
+        {
+          std::lock_guard<std::mutex> guard(em._mutex);
+          em._dispatches.clear();
+          for (auto sub : em._subscriptions)
+            if (sub)
+              sub->_timing = {};
+        }
+        req.respond();
+        return true;
+      }
+#endif
+      return false;
+    }
+
+    JsonDocument *Events::getState(RequestContext &ctx) {
+      auto doc = new JsonDocument();
+      auto root = doc->to<JsonObject>();
+#if CONFIG_ESP32M_EVENTS_PROFILE
+      auto &em = EventManager::instance();
+      std::lock_guard<std::mutex> guard(em._mutex);
+      auto types = root["types"].to<JsonArray>();
+      for (auto &[type, d] : em._dispatches) {
+        auto ti = types.add<JsonArray>();
+        ti.add(type);
+        ti.add(d.calls);
+        ti.add(d.total);
+        ti.add(d.max);
+        auto h = ti.add<JsonArray>();
+        for (auto count : d.histogram) h.add(count);
+      }
+      auto handlers = root["handlers"].to<JsonArray>();
+      for (auto i = 0; i < em._subscriptions.size(); i++) {
+        auto sub = em._subscriptions[i];
+        if (!sub || !sub->_timing.calls)
+          continue;
+        auto hi = handlers.add<JsonArray>();
+        if (sub->_name)
+          hi.add(sub->_name);
+        else
+          hi.add(i);
+        hi.add(sub->_timing.calls);
+        hi.add(sub->_timing.total);
+        hi.add(sub->_timing.max);
+      }
+#else
+      root["disabled"] = true;
+#endif
+      return doc;
+    }
+
+    Events *useEvents() {
+      return &Events::instance();
+    }
+
+  }  // namespace debug
+}  // namespace esp32m
\ No newline at end of file
@@ -0,0 +1,211 @@
+#include <esp_heap_caps.h>
+
+#include <algorithm>
+
+#include "esp32m/base.hpp"
+#include "esp32m/debug/heap.hpp"
+
+namespace esp32m {
+  namespace debug {
+
+    namespace heap {
+      const char *SiteNames[] = {"log", "json", "httpd", "mqtt"};
+      static_assert(sizeof(SiteNames) / sizeof(SiteNames[0]) ==
+                    (size_t)Site::MAX);
+
+#if CONFIG_ESP32M_HEAP_SITES
+      struct Counter {
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> bytes;
+      };
+      Counter counters[(size_t)Site::MAX] = {};
+
+      void track(Site site, size_t bytes) {
+        auto &c = counters[(size_t)site];
+        c.count.fetch_add(1, std::memory_order_relaxed);
+        c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+      }
+
+      class SiteAllocator : public ArduinoJson::Allocator {
+       public:
+        SiteAllocator(Site site) : _site(site) {}
+        void *allocate(size_t size) override {
+          track(_site, size);
+          return malloc(size);
+        }
+        void deallocate(void *ptr) override {
+          free(ptr);
+        }
+        void *reallocate(void *ptr, size_t new_size) override {
+          track(_site, new_size);
+          return realloc(ptr, new_size);
+        }
+
+       private:
+        Site _site;
+      };
+
+      ArduinoJson::Allocator *allocator(Site site) {
+        static SiteAllocator json(Site::JsonParse);
+        switch (site) {
+          case Site::JsonParse:
+            return &json;
+          default:
+            return ArduinoJson::detail::DefaultAllocator::instance();
+        }
+      }
+#endif
+    }  // namespace heap
+
+    // allow EventPeriodic to fire slightly early without skipping a sample
+    const unsigned long IntervalSlack = 100;
+
+    struct Cap {
+      const char *name;
+      uint32_t caps;
+    };
+    const Cap HeapCaps[] = {{"internal", MALLOC_CAP_INTERNAL},
+                            {"dma", MALLOC_CAP_DMA},
+                            {"spiram", MALLOC_CAP_SPIRAM}};
+
+    Heap &Heap::instance() {
+      static Heap i;
+      return i;
+    }
+
+    bool Heap::handleRequest(Request &req) {
+      if (AppObject::handleRequest(req))
+        return true;
+      if (req.is("history")) {
+        size_t last = _depth;
+        json::from(req.data()["last"], last);
+        auto doc = history(last);
+        req.respond(doc->as<JsonVariantConst>(), false);
+        delete doc;
+        return true;
+      }
+      return false;
+    }
+
+    void Heap::handleEvent(Event &ev) {
+      if (EventPeriodic::is(ev)) {
+        if (!_interval)
+          return;
+        if (_stamp &&
+            millis() - _stamp + IntervalSlack < _interval * 1000UL)
+          return;
+        sample();
+      }
+    }
+
+    JsonDocument *Heap::getState(RequestContext &ctx) {
+      auto doc = new JsonDocument();
+      auto root = doc->to<JsonObject>();
+      for (auto &cap : HeapCaps) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, cap.caps);
+        auto size = info.total_free_bytes + info.total_allocated_bytes;
+        if (!size)
+          continue;
+        auto ci = root[cap.name].to<JsonArray>();
+        ci.add(size);
+        ci.add(info.total_free_bytes);
+        ci.add(info.minimum_free_bytes);
+        ci.add(info.largest_free_block);
+        ci.add(info.total_free_bytes
+                   ? 100 - info.largest_free_block * 100 /
+                               info.total_free_bytes
+                   : 0);
+      }
+#if CONFIG_ESP32M_HEAP_SITES
+      auto sites = root["sites"].to<JsonArray>();
+      for (size_t i = 0; i < (size_t)heap::Site::MAX; i++) {
+        auto si = sites.add<JsonArray>();
+        si.add(heap::SiteNames[i]);
+        si.add(heap::counters[i].count.load(std::memory_order_relaxed));
+        si.add(heap::counters[i].bytes.load(std::memory_order_relaxed));
+      }
+#endif
+      return doc;
+    }
+
+    bool Heap::setConfig(RequestContext &ctx) {
+      JsonObjectConst obj = ctx.data.as<JsonObjectConst>();
+      bool changed = false;
+      // the sampler indexes the ring by _depth, it may only change together
+      // with the buffer
+      auto interval = _interval;
+      auto depth = _depth;
+      json::from(obj["interval"], interval, &changed);
+      json::from(obj["depth"], depth, &changed);
+      depth = std::clamp(depth, (uint16_t)1, MaxDepth);
+      if (changed) {
+        std::lock_guard guard(_mutex);
+        _interval = interval;
+        _depth = depth;
+        _samples.reset();
+        _seq = 0;
+        _stamp = 0;
+      }
+      return changed;
+    }
+
+    JsonDocument *Heap::getConfig(RequestContext &ctx) {
+      auto doc = new JsonDocument();
+      auto root = doc->to<JsonObject>();
+      json::to(root, "interval", _interval);
+      json::to(root, "depth", _depth);
+      return doc;
+    }
+
+    void Heap::sample() {
+      std::lock_guard guard(_mutex);
+      if (!_samples)
+        _samples = std::make_unique<Sample[]>(Caps * _depth);
+      auto slot = _seq % _depth;
+      for (int c = 0; c < Caps; c++) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, HeapCaps[c].caps);
+        auto &s = _samples[c * _depth + slot];
+        s.free = info.total_free_bytes;
+        s.min = info.minimum_free_bytes;
+        s.largest = info.largest_free_block;
+      }
+      _seq++;
+      _stamp = millis();
+    }
+
+    JsonDocument *Heap::history(size_t last) {
+      auto doc = new JsonDocument();
+      auto root = doc->to<JsonObject>();
+      std::lock_guard guard(_mutex);
+      size_t n = std::min({last, (size_t)_seq, (size_t)_depth});
+      json::to(root, "interval", _interval);
+      json::to(root, "samples", n);
+      if (_stamp)
+        json::to(root, "age", millis() - _stamp);
+      if (!n)
+        return doc;
+      // oldest to newest, [free, min, largest] per sample
+      for (int c = 0; c < Caps; c++) {
+        auto ring = &_samples[c * _depth];
+        if (!ring[(_seq - 1) % _depth].free)
+          continue;
+        auto samples = root[HeapCaps[c].name].to<JsonArray>();
+        for (size_t i = 0; i < n; i++) {
+          auto &s = ring[(_seq - n + i) % _depth];
+          auto si = samples.add<JsonArray>();
+          si.add(s.free);
+          si.add(s.min);
+          si.add(s.largest);
+        }
+      }
+      return doc;
+    }
+
+    Heap *useHeap() {
+      return &Heap::instance();
+    }
+
+  }  // namespace debug
+}  // namespace esp32m
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include "esp32m/debug/locks.hpp"
+
+namespace esp32m {
+  namespace debug {
+
+    Locks &Locks::instance() {
+      static Locks i;
+      return i;
+    }
+
+    bool Locks::handleRequest(Request &req) {
+      if (AppObject::handleRequest(req))
+        return true;
+#if CONFIG_ESP32M_LOCK_STATS
+      if (req.is("reset")) {
+        auto count = locks::count();
+        for (locks::Id id = 0; id < count; id++) locks::get(id).resetStats();
+        req.respond();
+        return true;
+      }
+#endif
+      return false;
+    }
+
+    JsonDocument *Locks::getState(RequestContext &ctx) {
+      auto doc = new JsonDocument();
+      auto root = doc->to<JsonObject>();
+      auto list = root["locks"].to<JsonArray>();
+      auto count = locks::count();
+      for (locks::Id id = 0; id < count; id++) {
+        auto &lock = locks::get(id);
+        auto li = list.add<JsonArray>();
+        li.add(lock.name());
+#if CONFIG_ESP32M_LOCK_STATS
+        auto stats = lock.stats();
+        li.add(stats.acquisitions);
+        li.add(stats.contended);
+        li.add(stats.maxWaitUs);
+        li.add(stats.maxHoldUs);
+        li.add(stats.holder);
+        li.add(stats.waiter);
+        li.add(stats.blocker);
+        li.add(lock.owner());
+#endif
+      }
+#if !CONFIG_ESP32M_LOCK_STATS
+      root["disabled"] = true;
+#endif
+      return doc;
+    }
+
+    Locks *useLocks() {
+      return &Locks::instance();
+    }
+
+  }  // namespace debug
+}  // namespace esp32m
\ No newline at end of file
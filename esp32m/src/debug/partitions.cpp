@@ -13,46 +13,44 @@ namespace esp32m {
       return i;
     }
 
-    JsonDocument *Partitions::getState(RequestContext &ctx) {
-      const uint32_t *ptr;
-      spi_flash_mmap_handle_t handle;
-      esp_err_t err = ESP_ERROR_CHECK_WITHOUT_ABORT(spi_flash_mmap(
-          ESP_PARTITION_TABLE_OFFSET & 0xffff0000, SPI_FLASH_SEC_SIZE,
-          SPI_FLASH_MMAP_DATA, (const void **)&ptr, &handle));
-      if (err != ESP_OK)
-        return nullptr;
-      const esp_partition_info_t *start =
-          (const esp_partition_info_t *)(ptr +
-                                         (ESP_PARTITION_TABLE_OFFSET & 0xffff) /
-                                             sizeof(*ptr));
-      const esp_partition_info_t *end =
-          start + SPI_FLASH_SEC_SIZE / sizeof(*start);
-      int pc = 0;
-      for (const esp_partition_info_t *it = start; it != end; ++it)
-        if (it->magic != ESP_PARTITION_MAGIC)
-          break;
-        else
-          pc++;
-      JsonDocument *doc =
-          new JsonDocument(/*JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(pc) +
-                                  pc * (16 + JSON_ARRAY_SIZE(6))*/);
-      auto root = doc->to<JsonObject>();
-      auto partitions = root["partitions"].to<JsonArray>();
-      for (const esp_partition_info_t *it = start; it != end; ++it)
-        if (it->magic != ESP_PARTITION_MAGIC)
-          break;
-        else {
-          auto e = partitions.add<JsonArray>();
-          e.add((char *)it->label);
-          e.add(it->type);
-          e.add(it->subtype);
-          e.add(it->pos.offset);
-          e.add(it->pos.size);
-          e.add(it->flags);
+    json::Producer Partitions::stateProducer(RequestContext &ctx) {
+      return [](json::Writer &w) {
+        const uint32_t *ptr;
+        spi_flash_mmap_handle_t handle;
+        esp_err_t err = ESP_ERROR_CHECK_WITHOUT_ABORT(spi_flash_mmap(
+            ESP_PARTITION_TABLE_OFFSET & 0xffff0000, SPI_FLASH_SEC_SIZE,
+            SPI_FLASH_MMAP_DATA, (const void **)&ptr, &handle));
+        if (err != ESP_OK) {
+          w.value(nullptr);
+          return;
         }
-
-      spi_flash_munmap(handle);
-      return doc;
+        const esp_partition_info_t *start =
+            (const esp_partition_info_t *)(ptr +
+                                           (ESP_PARTITION_TABLE_OFFSET &
+                                            0xffff) /
+                                               sizeof(*ptr));
+        const esp_partition_info_t *end =
+            start + SPI_FLASH_SEC_SIZE / sizeof(*start);
+        w.beginObject();
+        w.key("partitions");
+        w.beginArray();
+        for (const esp_partition_info_t *it = start; it != end; ++it)
+          if (it->magic != ESP_PARTITION_MAGIC)
+            break;
+          else {
+            w.beginArray();
+            w.value((const char *)it->label);
+            w.value(it->type);
+            w.value(it->subtype);
+            w.value(it->pos.offset);
+            w.value(it->pos.size);
+            w.value(it->flags);
+            w.endArray();
+          }
+        w.endArray();
+        w.endObject();
+        spi_flash_munmap(handle);
+      };
     }
 
     Partitions *usePartitions() {
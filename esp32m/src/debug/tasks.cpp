@@ -1,45 +1,267 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 
+#include <algorithm>
+#include <cstring>
+
+#include "esp32m/base.hpp"
 #include "esp32m/debug/tasks.hpp"
 
 namespace esp32m {
   namespace debug {
 
+    // allow EventPeriodic to fire slightly early without skipping a sample
+    const unsigned long IntervalSlack = 100;
+
     Tasks &Tasks::instance() {
       static Tasks i;
       return i;
     }
 
-    JsonDocument *Tasks::getState(RequestContext &ctx) {
-      volatile UBaseType_t uxArraySize;
-      uxArraySize = uxTaskGetNumberOfTasks();
-      JsonDocument *doc = new JsonDocument(/*
-          JSON_OBJECT_SIZE(2) + JSON_ARRAY_SIZE(uxArraySize) +
-          uxArraySize * (JSON_ARRAY_SIZE(7) + 16)*/);
+    json::Producer Tasks::stateProducer(RequestContext &ctx) {
+      return [this](json::Writer &w) {
+        UBaseType_t count = uxTaskGetNumberOfTasks();
+        TaskStatus_t *status =
+            (TaskStatus_t *)pvPortMalloc(count * sizeof(TaskStatus_t));
+        uint32_t total = 0;
+        if (status)
+          count = uxTaskGetSystemState(status, count, &total);
+        w.beginObject();
+        w.key("tasks");
+        w.beginArray();
+        for (UBaseType_t i = 0; status && i < count; i++) {
+          auto &ts = status[i];
+          w.beginArray();
+          w.value(ts.xTaskNumber);
+          w.value(ts.pcTaskName);
+          w.value((int)ts.eCurrentState);
+          w.value(ts.uxCurrentPriority);
+          w.value(ts.uxBasePriority);
+          w.value(ts.ulRunTimeCounter);
+          w.value(ts.usStackHighWaterMark);
+          w.endArray();
+        }
+        w.endArray();
+        if (status)
+          w.member("rt", total);
+        vPortFree(status);
+        // copy the last sample out, so that the sampler isn't held up while
+        // the response is being sent
+        uint8_t cores[portNUM_PROCESSORS];
+        bool sampled;
+        {
+          std::lock_guard guard(_mutex);
+          sampled = _seq != 0;
+          if (sampled) {
+            auto slot = (_seq - 1) % _depth;
+            for (int c = 0; c < portNUM_PROCESSORS; c++)
+              cores[c] = _cores[c * _depth + slot];
+          }
+        }
+        if (sampled) {
+          w.key("cores");
+          w.beginArray();
+          for (int c = 0; c < portNUM_PROCESSORS; c++) w.value(cores[c]);
+          w.endArray();
+        }
+        w.endObject();
+      };
+    }
+
+    bool Tasks::handleRequest(Request &req) {
+      if (AppObject::handleRequest(req))
+        return true;
+      if (req.is("history")) {
+        size_t last = _depth;
+        json::from(req.data()["last"], last);
+        auto doc = history(last);
+        req.respond(doc->as<JsonVariantConst>(), false);
+        delete doc;
+        return true;
+      }
+      return false;
+    }
+
+    void Tasks::handleEvent(Event &ev) {
+      if (EventPeriodic::is(ev)) {
+        if (!_interval)
+          return;
+        if (_stamp &&
+            millis() - _stamp + IntervalSlack < _interval * 1000UL)
+          return;
+        sample();
+      }
+    }
+
+    bool Tasks::setConfig(RequestContext &ctx) {
+      JsonObjectConst obj = ctx.data.as<JsonObjectConst>();
+      bool changed = false, layout = false;
+      // the sampler indexes the rings by _depth, it may only change together
+      // with the buffers
+      auto interval = _interval;
+      auto depth = _depth;
+      json::from(obj["interval"], interval, &layout);
+      json::from(obj["depth"], depth, &layout);
+      json::from(obj["loadAlarm"], _loadAlarm, &changed);
+      json::from(obj["stackAlarm"], _stackAlarm, &changed);
+      depth = std::clamp(depth, (uint16_t)1, MaxDepth);
+      if (layout) {
+        std::lock_guard guard(_mutex);
+        _interval = interval;
+        _depth = depth;
+        reset();
+      }
+      return changed || layout;
+    }
+
+    JsonDocument *Tasks::getConfig(RequestContext &ctx) {
+      auto doc = new JsonDocument();
       auto root = doc->to<JsonObject>();
-      auto tasks = root["tasks"].to<JsonArray>();
-      TaskStatus_t *pxTaskStatusArray =
-          (TaskStatus_t *)pvPortMalloc(uxArraySize * sizeof(TaskStatus_t));
-      if (pxTaskStatusArray) {
-        uint32_t ulTotalRunTime;
-        uxArraySize = uxTaskGetSystemState(pxTaskStatusArray, uxArraySize,
-                                           &ulTotalRunTime);
-        root["rt"] = ulTotalRunTime;
-        TaskStatus_t *tp = pxTaskStatusArray;
-        for (int i = 0; i < uxArraySize; i++) {
-          auto ti = tasks.add<JsonArray>();
-          ti.add(tp->xTaskNumber);
-          ti.add((char *)tp->pcTaskName);
-          ti.add(tp->eCurrentState);
-          ti.add(tp->uxCurrentPriority);
-          ti.add(tp->uxBasePriority);
-          ti.add(tp->ulRunTimeCounter);
-          ti.add(tp->usStackHighWaterMark);
-          tp++;
+      json::to(root, "interval", _interval);
+      json::to(root, "depth", _depth);
+      json::to(root, "loadAlarm", _loadAlarm);
+      json::to(root, "stackAlarm", _stackAlarm);
+      return doc;
+    }
+
+    void Tasks::reset() {
+      _tracks.clear();
+      _cores.reset();
+      _seq = 0;
+      _stamp = 0;
+    }
+
+    void Tasks::sample() {
+      UBaseType_t count = uxTaskGetNumberOfTasks();
+      // leave some room for the tasks created in the meantime
+      if (_status.size() < count + 2)
+        _status.resize(count + 4);
+      uint32_t total;
+      count = uxTaskGetSystemState(_status.data(), _status.size(), &total);
+      if (!count)
+        return;
+      auto now = millis();
+      std::lock_guard guard(_mutex);
+      // the first call only establishes the baseline for the counters
+      bool primed = _stamp != 0;
+      if (!_cores)
+        _cores = std::make_unique<uint8_t[]>(portNUM_PROCESSORS * _depth);
+      auto slot = _seq % _depth;
+      uint32_t elapsed = total - _total;
+      _total = total;
+      _stamp = now;
+
+      TaskHandle_t idle[portNUM_PROCESSORS];
+      for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        idle[c] = xTaskGetIdleTaskHandleForCore(c);
+        _cores[c * _depth + slot] = 0;
+      }
+
+      for (UBaseType_t i = 0; i < count; i++) {
+        auto &ts = _status[i];
+        auto it = std::find_if(_tracks.begin(), _tracks.end(), [&](Track &t) {
+          return t.handle == ts.xHandle && t.number == ts.xTaskNumber;
+        });
+        if (it == _tracks.end()) {
+          auto &t = _tracks.emplace_back();
+          t.handle = ts.xHandle;
+          t.number = ts.xTaskNumber;
+          strncpy(t.name, ts.pcTaskName, sizeof(t.name) - 1);
+          // tasks that appear after the baseline were created within this
+          // interval, so all of their run time belongs to it
+          t.counter = primed ? 0 : ts.ulRunTimeCounter;
+          t.stackMin = ts.usStackHighWaterMark;
+          t.stackDropped = now;
+          t.load = std::make_unique<uint8_t[]>(_depth);
+          it = _tracks.end() - 1;
+        }
+        auto &t = *it;
+        uint32_t delta = ts.ulRunTimeCounter - t.counter;
+        t.counter = ts.ulRunTimeCounter;
+        t.seen = _seq;
+        uint8_t load = 0;
+        if (elapsed)
+          load = std::min((uint64_t)delta * 100 / elapsed, (uint64_t)100);
+        t.load[slot] = load;
+        if (ts.usStackHighWaterMark < t.stackMin) {
+          t.stackMin = ts.usStackHighWaterMark;
+          t.stackDropped = now;
+        }
+        bool isIdle = false;
+        for (int c = 0; c < portNUM_PROCESSORS; c++)
+          if (idle[c] == ts.xHandle) {
+            _cores[c * _depth + slot] = 100 - load;
+            isIdle = true;
+          }
+        uint8_t flags = t.flags & ~(LoadAlarm | Gone);
+        if (primed && !isIdle && load > _loadAlarm) {
+          flags |= LoadAlarm;
+          t.spikes++;
+          t.spiked = now;
         }
+        if (t.stackMin < _stackAlarm)
+          flags |= StackAlarm;
+        if ((flags & LoadAlarm) && !(t.flags & LoadAlarm))
+          logW("task %s is using %d%% of CPU", t.name, load);
+        if ((flags & StackAlarm) && !(t.flags & StackAlarm))
+          logW("task %s has only %d bytes of stack left", t.name, t.stackMin);
+        t.flags = flags;
+      }
+
+      for (auto it = _tracks.begin(); it != _tracks.end();) {
+        if (it->seen == _seq) {
+          it++;
+          continue;
+        }
+        if (_seq - it->seen >= _depth) {
+          it = _tracks.erase(it);
+          continue;
+        }
+        it->flags = (it->flags & ~LoadAlarm) | Gone;
+        it->load[slot] = 0;
+        it++;
+      }
+      if (primed)
+        _seq++;
+    }
+
+    JsonDocument *Tasks::history(size_t last) {
+      auto doc = new JsonDocument();
+      auto root = doc->to<JsonObject>();
+      std::lock_guard guard(_mutex);
+      size_t n = std::min({last, (size_t)_seq, (size_t)_depth});
+      auto now = millis();
+      json::to(root, "interval", _interval);
+      json::to(root, "samples", n);
+      if (_stamp)
+        json::to(root, "age", now - _stamp);
+      if (!n)
+        return doc;
+      // unwind the rings oldest to newest, one hex byte per sample
+      auto buf = std::make_unique<uint8_t[]>(n);
+      auto linear = [&](const uint8_t *ring) {
+        for (size_t i = 0; i < n; i++)
+          buf[i] = ring[(_seq - n + i) % _depth];
+        return hex_encode(buf.get(), n);
+      };
+      auto cores = root["cores"].to<JsonArray>();
+      for (int c = 0; c < portNUM_PROCESSORS; c++)
+        cores.add(linear(&_cores[c * _depth]));
+      auto tasks = root["tasks"].to<JsonArray>();
+      for (auto &t : _tracks) {
+        auto ti = tasks.add<JsonArray>();
+        ti.add(t.number);
+        ti.add(t.name);
+        ti.add(t.flags);
+        ti.add(t.stackMin);
+        ti.add((now - t.stackDropped) / 1000);
+        ti.add(t.spikes);
+        if (t.spikes)
+          ti.add((now - t.spiked) / 1000);
+        else
+          ti.add(nullptr);
+        ti.add(linear(t.load.get()));
       }
-      vPortFree(pxTaskStatusArray);
       return doc;
     }
 
@@ -0,0 +1,188 @@
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "esp32m/debug/trace.hpp"
+#include "esp32m/ui.hpp"
+
+namespace esp32m {
+  namespace debug {
+
+#if CONFIG_ESP32M_TRACE
+    namespace trace {
+      const uint32_t Size = CONFIG_ESP32M_TRACE_SIZE;
+      static_assert((Size & (Size - 1)) == 0,
+                    "CONFIG_ESP32M_TRACE_SIZE must be a power of two");
+
+      struct Record {
+        // index + 1 once the record is complete, 0 while it is being written
+        std::atomic<uint32_t> seq;
+        Phase phase;
+        uint8_t core;
+        TaskHandle_t task;
+        const char *name;
+        int64_t stamp;
+      };
+
+      Record ring[Size];
+      std::atomic<uint32_t> head;
+
+      void record(Phase phase, const char *name) {
+        auto index = head.fetch_add(1, std::memory_order_relaxed);
+        auto &r = ring[index & (Size - 1)];
+        r.seq.store(0, std::memory_order_relaxed);
+        // readers on the other core must not see the new fields before seq
+        // was cleared
+        std::atomic_thread_fence(std::memory_order_release);
+        r.stamp = esp_timer_get_time();
+        r.phase = phase;
+        r.core = xPortGetCoreID();
+        r.task = xTaskGetCurrentTaskHandle();
+        r.name = name;
+        r.seq.store(index + 1, std::memory_order_release);
+      }
+
+      struct Entry {
+        Phase phase;
+        uint8_t core;
+        TaskHandle_t task;
+        const char *name;
+        int64_t stamp;
+      };
+
+      void escape(std::string &out, const char *str) {
+        for (; str && *str; str++) {
+          if (*str == '"' || *str == '\\')
+            out += '\\';
+          if ((uint8_t)*str >= ' ')
+            out += *str;
+        }
+      }
+
+      class Reader : public stream::Reader {
+       public:
+        Reader() {
+          auto end = head.load(std::memory_order_acquire);
+          auto start = end > Size ? end - Size : 0;
+          _entries.reserve(end - start);
+          for (auto i = start; i != end; i++) {
+            auto &r = ring[i & (Size - 1)];
+            if (r.seq.load(std::memory_order_acquire) != i + 1)
+              continue;
+            Entry e = {r.phase, r.core, r.task, r.name, r.stamp};
+            // skip records overwritten while we were copying them, the fence
+            // keeps the copy from being reordered past the check
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (r.seq.load(std::memory_order_relaxed) != i + 1)
+              continue;
+            _entries.push_back(e);
+          }
+#  if configUSE_TRACE_FACILITY
+          // names are only resolved for the tasks that are still alive
+          UBaseType_t count = uxTaskGetNumberOfTasks();
+          std::unique_ptr<TaskStatus_t[]> tasks(new TaskStatus_t[count]);
+          count = uxTaskGetSystemState(tasks.get(), count, nullptr);
+          for (UBaseType_t i = 0; i < count; i++)
+            for (auto &e : _entries)
+              if (e.task == tasks[i].xHandle) {
+                _threads.emplace_back(e.task, tasks[i].pcTaskName);
+                break;
+              }
+#  endif
+        }
+        size_t read(uint8_t *buf, size_t size) override {
+          size_t done = 0;
+          while (done < size) {
+            if (_pos >= _chunk.size()) {
+              _chunk.clear();
+              _pos = 0;
+              if (!next())
+                break;
+            }
+            auto n = std::min(size - done, _chunk.size() - _pos);
+            memcpy(buf + done, _chunk.data() + _pos, n);
+            _pos += n;
+            done += n;
+          }
+          return done;
+        }
+
+       private:
+        std::vector<Entry> _entries;
+        std::vector<std::pair<TaskHandle_t, std::string>> _threads;
+        std::string _chunk;
+        size_t _pos = 0;
+        size_t _index = 0;
+        bool _started = false, _finished = false;
+        bool next() {
+          if (_finished)
+            return false;
+          char buf[128];
+          if (!_started) {
+            _started = true;
+            _chunk = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+          } else if (_index < _entries.size()) {
+            auto &e = _entries[_index];
+            if (_index++)
+              _chunk += ',';
+            _chunk += "{\"name\":\"";
+            escape(_chunk, e.name);
+            snprintf(buf, sizeof(buf),
+                     "\",\"ph\":\"%c\",%s\"ts\":%lld,\"pid\":0,\"tid\":%lu,"
+                     "\"args\":{\"core\":%d}}",
+                     (char)e.phase,
+                     e.phase == Phase::Instant ? "\"s\":\"t\"," : "", e.stamp,
+                     (unsigned long)e.task, e.core);
+            _chunk += buf;
+          } else if (_index - _entries.size() < _threads.size()) {
+            auto &t = _threads[_index - _entries.size()];
+            if (_index++)
+              _chunk += ',';
+            snprintf(buf, sizeof(buf),
+                     "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+                     "\"tid\":%lu,\"args\":{\"name\":\"",
+                     (unsigned long)t.first);
+            _chunk += buf;
+            escape(_chunk, t.second.c_str());
+            _chunk += "\"}}";
+          } else {
+            _finished = true;
+            _chunk = "]}";
+          }
+          return true;
+        }
+      };
+    }  // namespace trace
+#endif
+
+    Trace::Trace() {
+      ui::AssetInfo info{"/debug/trace.json", "application/json", nullptr,
+                         nullptr};
+      init(info);
+#if CONFIG_ESP32M_TRACE
+      Ui::instance().addAsset(this);
+#endif
+    }
+
+    Trace &Trace::instance() {
+      static Trace i;
+      return i;
+    }
+
+    std::unique_ptr<stream::Reader> Trace::createReader() const {
+#if CONFIG_ESP32M_TRACE
+      return std::make_unique<trace::Reader>();
+#else
+      return nullptr;
+#endif
+    }
+
+    Trace *useTrace() {
+      return &Trace::instance();
+    }
+
+  }  // namespace debug
+}  // namespace esp32m
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "esp32m/device.hpp"
 #include "esp32m/app.hpp"
 #include "esp32m/base.hpp"
+#include "esp32m/debug/trace.hpp"
 #include "esp32m/net/ota.hpp"
 #include "esp32m/sleep.hpp"
 
@@ -55,6 +56,7 @@ namespace esp32m {
     if (EventPollSensorsTime::is(ev, &pste))
       pste->record(nextSensorsPollTime());
     else if (EventPollSensors::is(ev) && shouldPollSensors()) {
+      debug::trace::Span span(name());
       if (sensorsReady() && !pollSensors())
         resetSensors();
       _sensorsPolledAt = millis();
@@ -77,6 +79,8 @@ namespace esp32m {
                 xTaskNotifyGive(task);
             });
             esp_task_wdt_add(NULL);
+            // OTA takes this lock for the duration of the upgrade
+            const auto otaLock = locks::id(net::ota::Name);
             for (;;) {
               int sleepTime = 0;
               esp_task_wdt_reset();
@@ -86,7 +90,7 @@ namespace esp32m {
                 auto next = pste.getNext();
                 auto current = millis();
                 if (next < current) {
-                  locks::Guard guard(net::ota::Name);
+                  locks::Guard guard(otaLock);
                   ev.publish();
                 } else
                   sleepTime = next - current;  // sleeper.sleep();
@@ -1,6 +1,7 @@
 #include "esp32m/dev/flow.hpp"
 #include "esp32m/base.hpp"
 #include "esp32m/defs.hpp"
+#include "esp32m/io/pcnt_count.hpp"
 
 #include <math.h>
 #include <limits>
@@ -31,8 +32,15 @@ namespace esp32m {
       ESP_ERROR_CHECK_WITHOUT_ABORT(pcnt->setLevelAction(
           PCNT_CHANNEL_LEVEL_ACTION_KEEP, PCNT_CHANNEL_LEVEL_ACTION_KEEP));
       ESP_ERROR_CHECK_WITHOUT_ABORT(pcnt->setFilter(12 * 1000));  // 12 us is as high as it can go
+      // slow flow is timed edge to edge rather than counted per poll
+      auto sampler = pcnt->getSampler();
+      ESP_ERROR_CHECK_WITHOUT_ABORT(sampler->setGlitchFilter(1000));
+      ESP_ERROR_CHECK_WITHOUT_ABORT(
+          sampler->setMode(io::pin::PcntSampler::Mode::Auto));
       if (!pcnt->isEnabled())
         ESP_ERROR_CHECK_WITHOUT_ABORT(pcnt->enable(true));
+      else if (!sampler->isEnabled())
+        ESP_ERROR_CHECK_WITHOUT_ABORT(sampler->enable(true));
       return pcnt->isEnabled();
     }
 
@@ -49,12 +57,21 @@ namespace esp32m {
       auto pcnt = _pin->pcnt();
       if (!pcnt)
         return false;
-      int pc;
-      auto err = ESP_ERROR_CHECK_WITHOUT_ABORT(pcnt->read(pc, true));
+      int count;
+      // the count is left running for the sampler
+      auto err = ESP_ERROR_CHECK_WITHOUT_ABORT(pcnt->read(count));
       if (err == ESP_OK) {
         auto ms = millis();
         auto passed = ms - _stamp;
-        _value = compute(pc, passed);
+        auto pc = io::pcnt::countDelta(_count, count);
+        _count = count;
+        auto sampler = pcnt->getSampler();
+        if (sampler->isReciprocal()) {
+          // the estimate decays towards zero once the pulses stop
+          auto hz = sampler->getFreq();
+          _value = hz >= 0.5 ? fromFreq(hz) : 0;
+        } else
+          _value = compute(pc, passed);
         _consumption += _value * passed / 1000 / 60;
         _stamp = ms;
         _sensorFlow.set(_value);
@@ -86,7 +103,10 @@ namespace esp32m {
     float FlowSensor::compute(int pc, int ms) {
       if (pc == 0)
         return 0;
-      float hz = (float)pc * 1000 / ms;
+      return fromFreq((float)pc * 1000 / ms);
+    }
+
+    float FlowSensor::fromFreq(float hz) {
       return (hz + 8) / 6;
     }
 
@@ -62,12 +62,22 @@ namespace esp32m {
     esp_err_t HBridge::setPins(bool fwd, bool rev) {
       // logD("setPins %d %d PWM=%d", fwd, rev, isPwm());
       if (isPwm()) {
+        auto f = _fwd->pwm(), r = _rev->pwm();
         if (fwd && rev) {
-          ESP_CHECK_RETURN(_fwd->pwm()->enable(false));
-          ESP_CHECK_RETURN(_rev->pwm()->enable(false));
+          ESP_CHECK_RETURN(f->enable(false));
+          ESP_CHECK_RETURN(r->enable(false));
         } else {
-          ESP_CHECK_RETURN(_fwd->pwm()->enable(fwd));
-          ESP_CHECK_RETURN(_rev->pwm()->enable(rev));
+          // both legs run at the same frequency, so the allocator puts them
+          // on one timer and they switch in phase
+          ESP_CHECK_RETURN(f->setFreq(_freq));
+          ESP_CHECK_RETURN(r->setFreq(_freq));
+          ESP_CHECK_RETURN(f->enable(false));
+          ESP_CHECK_RETURN(r->enable(false));
+          auto leg = fwd ? f : (rev ? r : nullptr);
+          if (leg) {
+            ESP_CHECK_RETURN(leg->setDuty(_duty));
+            ESP_CHECK_RETURN(leg->enable(true));
+          }
         }
       }
       io::pin::Tx tx(io::pin::Tx::Type::Write);
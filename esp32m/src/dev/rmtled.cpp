@@ -3,46 +3,119 @@
 #include "esp32m/debug/diag.hpp"
 #include "esp32m/io/gpio.hpp"
 #include <esp_task_wdt.h>
+#include <soc/soc_caps.h>
 #include "led_strip.h"
 #include "esp_log.h"
 #include "esp_err.h"
 
+#include <algorithm>
 
 // 10MHz resolution, 1 tick = 0.1us (led strip needs a high resolution)
 #define LED_STRIP_RMT_RES_HZ  (10 * 1000 * 1000)
 
 namespace esp32m {
   namespace dev {
-    Rmtled::Rmtled(gpio_num_t pin) {
+    namespace {
+      const char *EffectNames[] = {"diag", "solid", "fade", "chase", "status"};
+      const char *StatusNames[] = {"off", "ok", "busy", "warning", "error"};
+      // number of lit pixels in the chase effect, including the head
+      const int ChaseTail = 4;
+
+      template <size_t N>
+      int indexOf(const char *(&names)[N], const char *name) {
+        if (name)
+          for (int i = 0; i < N; i++)
+            if (!strcmp(names[i], name))
+              return i;
+        return -1;
+      }
+
+      // triangle wave, 0 -> 255 -> 0 over the period
+      uint8_t wave(uint32_t now, uint32_t period) {
+        auto phase = (now % period) * 510 / period;
+        return phase > 255 ? 510 - phase : phase;
+      }
+
+      Rmtled::Color scale(Rmtled::Color c, uint8_t level) {
+        return {(uint8_t)(c.r * level / 255), (uint8_t)(c.g * level / 255),
+                (uint8_t)(c.b * level / 255)};
+      }
+
+      Rmtled::Color statusColor(Rmtled::Status status, uint32_t now) {
+        switch (status) {
+          case Rmtled::Status::Ok:
+            return {0, 32, 0};
+          case Rmtled::Status::Busy:
+            return scale({0, 0, 48}, wave(now, 1000));
+          case Rmtled::Status::Warning:
+            return (now % 1000) < 500 ? Rmtled::Color{48, 24, 0}
+                                      : Rmtled::Color{0, 0, 0};
+          case Rmtled::Status::Error:
+            return (now % 250) < 125 ? Rmtled::Color{64, 0, 0}
+                                     : Rmtled::Color{0, 0, 0};
+          default:
+            return {0, 0, 0};
+        }
+      }
+    }  // namespace
+
+    Rmtled::Rmtled(gpio_num_t pin, int count) {
       _pin=pin;
+      _count = std::max(count, 1);
+      _front = std::make_unique<Color[]>(_count);
+      _back = std::make_unique<Color[]>(_count);
       init();
     }
 
+    Rmtled::~Rmtled() {
+      if (_task)
+        vTaskDelete(_task);
+      if (led_strip)
+        led_strip_del(led_strip);
+    }
+
     void Rmtled::configure_led() {
       logI( "Initialising addressable LED");
       /* LED strip initialization with the GPIO and pixels number*/
       led_strip_config_t strip_config = {
-        .strip_gpio_num = _pin,                   
-        .max_leds = 1,                            
-        .led_model = LED_MODEL_WS2812,            
+        .strip_gpio_num = _pin,
+        .max_leds = (uint32_t)_count,
+        .led_model = LED_MODEL_WS2812,
         .color_component_format = LED_STRIP_COLOR_COMPONENT_FMT_GRB,
-        .flags = { 
-            .invert_out = false,                  
+        .flags = {
+            .invert_out = false,
           }
       };
 
      // LED strip backend configuration: RMT
       led_strip_rmt_config_t rmt_config = {
-          .clk_src = RMT_CLK_SRC_DEFAULT,         
-          .resolution_hz = LED_STRIP_RMT_RES_HZ,  
+          .clk_src = RMT_CLK_SRC_DEFAULT,
+          .resolution_hz = LED_STRIP_RMT_RES_HZ,
           .mem_block_symbols=64,
           .flags = {
-              .with_dma = false,                  // DMA feature is available on ESP target like ESP32-S3
+              .with_dma = false,
             }
       };
-      
+
+#if SOC_RMT_SUPPORT_DMA
+      // without DMA, RMT memory is refilled from an ISR every few pixels
+      if (_count > 8) {
+        rmt_config.mem_block_symbols = 1024;
+        rmt_config.flags.with_dma = true;
+        if (led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip) ==
+            ESP_OK) {
+          logI("Created LED strip object with RMT backend, %d pixels, DMA",
+               _count);
+          return;
+        }
+        logW("RMT DMA channel unavailable, falling back to ISR refill");
+        rmt_config.mem_block_symbols = 64;
+        rmt_config.flags.with_dma = false;
+      }
+#endif
+
       ESP_ERROR_CHECK(led_strip_new_rmt_device(&strip_config, &rmt_config, &led_strip));
-      logI("Created LED strip object with RMT backend");
+      logI("Created LED strip object with RMT backend, %d pixels", _count);
     }
 
     void Rmtled::init() {
@@ -51,34 +124,188 @@ namespace esp32m {
                   this, tskIDLE_PRIORITY + 1, &_task);
     }
 
+    void Rmtled::setEffect(Effect effect) {
+      std::lock_guard guard(_mutex);
+      _effect = effect;
+    }
+
+    void Rmtled::setColor(Color color) {
+      std::lock_guard guard(_mutex);
+      _color = color;
+    }
+
+    void Rmtled::setPeriod(uint32_t ms) {
+      std::lock_guard guard(_mutex);
+      _period = std::max(ms, (uint32_t)100);
+    }
+
+    void Rmtled::setBrightness(uint8_t brightness) {
+      std::lock_guard guard(_mutex);
+      _brightness = brightness;
+    }
+
+    void Rmtled::setFps(int fps) {
+      _fps = std::clamp(fps, 1, 100);
+    }
+
+    int Rmtled::addSegment(const char *name, int first, int count) {
+      if (first < 0 || count <= 0 || first + count > _count)
+        return -1;
+      std::lock_guard guard(_mutex);
+      _segments.push_back({name, first, count, Status::Off});
+      return _segments.size() - 1;
+    }
+
+    void Rmtled::setStatus(int segment, Status status) {
+      std::lock_guard guard(_mutex);
+      if (segment >= 0 && segment < _segments.size())
+        _segments[segment].status = status;
+    }
+
+    // same sequence as the former blocking loop: each code as a series of
+    // 200ms blinks followed by a 1s pause, and another 1s pause after the
+    // last code
+    bool Rmtled::diagLit(uint32_t now) {
+      while ((int32_t)(now - _diag.until) >= 0) {
+        if (_diag.on) {
+          _diag.on = false;
+          _diag.until = now + 200;
+          if (--_diag.blinks == 0)
+            _diag.until += 1000;
+        } else if (_diag.blinks > 0) {
+          _diag.on = true;
+          _diag.until = now + 200;
+        } else if (_diag.pos < _diag.count)
+          _diag.blinks = _diag.codes[_diag.pos++];
+        else {
+          _diag.count = debug::Diag::instance().toArray(_diag.codes,
+                                                        sizeof(_diag.codes));
+          _diag.pos = 0;
+          _diag.until = now + 1000;
+        }
+      }
+      return _diag.on;
+    }
+
+    void Rmtled::render(uint32_t now) {
+      std::lock_guard guard(_mutex);
+      auto frame = _back.get();
+      std::fill_n(frame, _count, Color{0, 0, 0});
+      switch (_effect) {
+        case Effect::Diag:
+          if (diagLit(now))
+            frame[0] = _color;
+          break;
+        case Effect::Solid:
+          std::fill_n(frame, _count, _color);
+          break;
+        case Effect::Fade:
+          std::fill_n(frame, _count, scale(_color, wave(now, _period)));
+          break;
+        case Effect::Chase: {
+          int head = (now % _period) * _count / _period;
+          for (int i = 0; i < ChaseTail && i < _count; i++)
+            frame[(head + _count - i) % _count] =
+                scale(_color, 255 >> (i * 2));
+          break;
+        }
+        case Effect::Status:
+          for (auto &s : _segments)
+            std::fill_n(frame + s.first, s.count, statusColor(s.status, now));
+          break;
+      }
+      if (_brightness != 255)
+        for (int i = 0; i < _count; i++)
+          frame[i] = scale(frame[i], _brightness);
+    }
 
-    void Rmtled::blink(int count) {
-      for (int i = 0; i < count; i++) {
-          // Set the pixel color 
-          led_strip_set_pixel(led_strip, 0, _led_color[0], _led_color[1], _led_color[2]);
-          // update strip
-          led_strip_refresh(led_strip);
-          delay(200);
-          // turn off all LEDs in strip
-          led_strip_clear(led_strip);
-          delay(200);
+    esp_err_t Rmtled::push() {
+      if (_pushed &&
+          std::equal(_back.get(), _back.get() + _count, _front.get()))
+        return ESP_OK;
+      std::swap(_front, _back);
+      _pushed = false;
+      for (int i = 0; i < _count; i++) {
+        auto &c = _front[i];
+        ESP_CHECK_RETURN(led_strip_set_pixel(led_strip, i, c.r, c.g, c.b));
       }
+      ESP_CHECK_RETURN(led_strip_refresh(led_strip));
+      _pushed = true;
+      return ESP_OK;
     }
 
     void Rmtled::run() {
-      uint8_t codes[10];
       esp_task_wdt_add(NULL);
+      TickType_t wake = xTaskGetTickCount();
       for (;;) {
         esp_task_wdt_reset();
-        auto c = debug::Diag::instance().toArray(codes, sizeof(codes));
-        for (int i = 0; i < c; i++) {
-          blink(codes[i]);
-          delay(1000);
+        render(millis());
+        ESP_ERROR_CHECK_WITHOUT_ABORT(push());
+        auto period = std::max(pdMS_TO_TICKS(1000 / _fps), (TickType_t)1);
+        // drop frames rather than catch up after an overrun
+        if (xTaskDelayUntil(&wake, period) == pdFALSE)
+          wake = xTaskGetTickCount();
+      }
+    }
+
+    JsonDocument *Rmtled::getState(RequestContext &ctx) {
+      std::lock_guard guard(_mutex);
+      JsonDocument *doc = new JsonDocument();
+      JsonObject root = doc->to<JsonObject>();
+      root["effect"] = EffectNames[(int)_effect];
+      auto color = root["color"].to<JsonArray>();
+      color.add(_color.r);
+      color.add(_color.g);
+      color.add(_color.b);
+      root["period"] = _period;
+      if (_segments.size()) {
+        auto segments = root["segments"].to<JsonObject>();
+        for (auto &s : _segments) segments[s.name] = StatusNames[(int)s.status];
+      }
+      return doc;
+    }
+
+    void Rmtled::setState(RequestContext &ctx) {
+      auto data = ctx.data;
+      auto effect = indexOf(EffectNames, data["effect"].as<const char *>());
+      if (effect >= 0)
+        setEffect((Effect)effect);
+      JsonArrayConst color = data["color"];
+      if (color && color.size() == 3)
+        setColor({color[0].as<uint8_t>(), color[1].as<uint8_t>(),
+                  color[2].as<uint8_t>()});
+      if (data["period"].is<uint32_t>())
+        setPeriod(data["period"].as<uint32_t>());
+      JsonObjectConst segments = data["segments"];
+      if (segments) {
+        std::lock_guard guard(_mutex);
+        for (auto &s : _segments) {
+          auto status = indexOf(StatusNames, segments[s.name].as<const char *>());
+          if (status >= 0)
+            s.status = (Status)status;
         }
-        delay(1000);
       }
     }
 
+    JsonDocument *Rmtled::getConfig(RequestContext &ctx) {
+      JsonDocument *doc = new JsonDocument(); /* JSON_OBJECT_SIZE(2) */
+      JsonObject root = doc->to<JsonObject>();
+      json::to(root, "brightness", _brightness);
+      json::to(root, "fps", _fps);
+      return doc;
+    }
+
+    bool Rmtled::setConfig(RequestContext &ctx) {
+      bool changed = false;
+      auto brightness = _brightness;
+      if (json::from(ctx.data["brightness"], brightness, &changed))
+        setBrightness(brightness);
+      auto fps = _fps;
+      if (json::from(ctx.data["fps"], fps, &changed))
+        setFps(fps);
+      return changed;
+    }
+
     bool Rmtled::handleRequest(Request &req) {
       if (AppObject::handleRequest(req))
         return true;
@@ -86,23 +313,22 @@ namespace esp32m {
         JsonArrayConst data = req.data();
         if (data) {
           if (data.size() == 3) {
-            _led_color[0]=data[0];
-            _led_color[1]=data[1];
-            _led_color[2]=data[2];
+            setColor({data[0].as<uint8_t>(), data[1].as<uint8_t>(),
+                      data[2].as<uint8_t>()});
           } else {
             req.respond(ESP_ERR_INVALID_SIZE);
-            return true; 
+            return true;
           }
         }
         req.respond();
-        return true;  
+        return true;
       }
       return false;
     }
 
 
-    Rmtled *useRmtled(gpio_num_t pin) {
-      return new Rmtled(pin);
+    Rmtled *useRmtled(gpio_num_t pin, int count) {
+      return new Rmtled(pin, count);
     }
 
   }  // namespace dev
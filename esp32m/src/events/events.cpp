@@ -1,9 +1,16 @@
 #include <string.h>
 
 #include "esp32m/base.hpp"
+#include "esp32m/debug/trace.hpp"
 #include "esp32m/events.hpp"
 #include "esp32m/logging.hpp"
 
+#if CONFIG_ESP32M_EVENTS_PROFILE
+#include <bit>
+
+#include <esp_timer.h>
+#endif
+
 namespace esp32m {
 
   bool Event::is(const char *type) const {
@@ -19,6 +26,10 @@ namespace esp32m {
   }
 
   void EventManager::publish(Event &event) {
+    debug::trace::Span span(event.type());
+#if CONFIG_ESP32M_EVENTS_PROFILE
+    auto started = esp_timer_get_time();
+#endif
     for (auto i = 0; i < _subscriptions.size(); i++) {
       Subscription *sub;
       {
@@ -28,15 +39,18 @@ namespace esp32m {
           continue;
         sub->ref();
       }
-      sub->_cb(event);
-      {
-        std::lock_guard<std::mutex> guard(_mutex);
-        sub->unref();
-      }
+      dispatch(sub, event);
     }
+#if CONFIG_ESP32M_EVENTS_PROFILE
+    dispatched(event, started);
+#endif
   }
 
   void EventManager::publishBackwards(Event &event) {
+    debug::trace::Span span(event.type());
+#if CONFIG_ESP32M_EVENTS_PROFILE
+    auto started = esp_timer_get_time();
+#endif
     for (int i = _subscriptions.size() - 1; i >= 0; i--) {
       Subscription *sub;
       {
@@ -46,14 +60,47 @@ namespace esp32m {
           continue;
         sub->ref();
       }
-      sub->_cb(event);
-      {
-        std::lock_guard<std::mutex> guard(_mutex);
-        sub->unref();
-      }
+      dispatch(sub, event);
     }
+#if CONFIG_ESP32M_EVENTS_PROFILE
+    dispatched(event, started);
+#endif
   }
 
+  void EventManager::dispatch(Subscription *sub, Event &event) {
+#if CONFIG_ESP32M_EVENTS_PROFILE
+    auto started = esp_timer_get_time();
+#endif
+    sub->_cb(event);
+    std::lock_guard<std::mutex> guard(_mutex);
+#if CONFIG_ESP32M_EVENTS_PROFILE
+    sub->_timing.add(esp_timer_get_time() - started);
+#endif
+    sub->unref();
+  }
+
+#if CONFIG_ESP32M_EVENTS_PROFILE
+  void EventManager::dispatched(Event &event, int64_t started) {
+    uint32_t us = esp_timer_get_time() - started;
+    std::string_view type(event.type());
+    std::lock_guard<std::mutex> guard(_mutex);
+    auto it = _dispatches.find(type);
+    if (it == _dispatches.end())
+      it = _dispatches.emplace(type, events::Dispatch()).first;
+    it->second.add(us);
+  }
+
+  namespace events {
+    void Dispatch::add(uint32_t us) {
+      Timing::add(us);
+      int bucket = us < 4 ? 0 : (std::bit_width(us) - 1) / 2;
+      if (bucket >= Buckets)
+        bucket = Buckets - 1;
+      histogram[bucket]++;
+    }
+  }  // namespace events
+#endif
+
   Subscription *EventManager::subscribe(Subscription::Callback cb) {
     const auto result = new Subscription(cb);
     std::lock_guard<std::mutex> guard(_mutex);
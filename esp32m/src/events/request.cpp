@@ -3,6 +3,17 @@
 
 namespace esp32m {
 
+  namespace {
+    class StringWriter : public stream::Writer {
+     public:
+      std::string text;
+      size_t write(const uint8_t *buf, size_t size) override {
+        text.append((const char *)buf, size);
+        return size;
+      }
+    };
+  }  // namespace
+
   bool Request::is(const char *name) const {
     return _name && name && !strcmp(_name, name);
   }
@@ -107,6 +118,22 @@ namespace esp32m {
     }
   }
 
+  void Request::respondStream(const char *source,
+                              const json::Producer &producer) {
+    if (!respondStreamImpl(source, producer)) {
+      StringWriter out;
+      json::Writer writer(out);
+      producer(writer);
+      std::unique_ptr<JsonDocument> doc(
+          json::parse(out.text.c_str(), out.text.size()));
+      respondImpl(source,
+                  doc ? doc->as<JsonVariantConst>()
+                      : json::null<JsonVariantConst>(),
+                  false);
+    }
+    _handled = true;
+  }
+
   Response *Request::makeResponse() {
     _handled = true;
     return makeResponseImpl();
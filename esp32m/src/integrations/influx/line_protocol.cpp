@@ -0,0 +1,31 @@
+#include <cstring>
+
+#include "esp32m/integrations/influx/line_protocol.hpp"
+
+namespace esp32m {
+  namespace integrations {
+    namespace influx {
+
+      // Escape special characters in tag values/field names for InfluxDB line protocol
+      // Spaces, commas, and equals signs need to be escaped
+      std::string escapeLineProtocolValue(const char* src) {
+        std::string result;
+        if (!src)
+          return result;
+        
+        // Pre-allocate with some extra space for escapes (worst case: every char gets escaped)
+        size_t srcLen = strlen(src);
+        result.reserve(srcLen * 2);
+        
+        for (const char* p = src; *p; p++) {
+          if (*p == '\\' || *p == ' ' || *p == ',' || *p == '=') {
+            result += '\\';
+          }
+          result += *p;
+        }
+        return result;
+      }
+
+    }  // namespace influx
+  }  // namespace integrations
+}  // namespace esp32m
@@ -4,6 +4,7 @@
 #include <cstring>
 #include <string>
 
+#include "esp32m/integrations/influx/line_protocol.hpp"
 #include "esp32m/integrations/influx/mqtt.hpp"
 #include "esp32m/net/mqtt.hpp"
 
@@ -12,26 +13,6 @@ using namespace dev;
   namespace integrations {
     namespace influx {
 
-      // Escape special characters in tag values/field names for InfluxDB line protocol
-      // Spaces, commas, and equals signs need to be escaped
-      std::string escapeLineProtocolValue(const char* src) {
-        std::string result;
-        if (!src)
-          return result;
-        
-        // Pre-allocate with some extra space for escapes (worst case: every char gets escaped)
-        size_t srcLen = strlen(src);
-        result.reserve(srcLen * 2);
-        
-        for (const char* p = src; *p; p++) {
-          if (*p == '\\' || *p == ' ' || *p == ',' || *p == '=') {
-            result += '\\';
-          }
-          result += *p;
-        }
-        return result;
-      }
-
       std::string serializeProps(const JsonObjectConst props) {
         std::string result;
         if (!props)
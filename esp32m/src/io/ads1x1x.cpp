@@ -2,6 +2,8 @@
 
 #include "esp32m/io/ads1x1x.hpp"
 
+#include <string.h>
+
 namespace esp32m {
   namespace io {
     namespace ads1x1x {
@@ -29,6 +31,11 @@ namespace esp32m {
       static const int ConfigModeSingle = 0x0100;
 
       static const int ConfigModeOsSingle = 0x8000;
+
+      static const int ConfigRateShift = 5;
+      static const uint16_t Ads111xSps[] = {8, 16, 32, 64, 128, 250, 475, 860};
+      static const uint16_t Ads101xSps[] = {128,  250,  490,  920,
+                                            1600, 2400, 3300, 3300};
     }  // namespace ads1x1x
 
     Ads1x1x::Ads1x1x(i2c::MasterDev *i2c, ads1x1x::Variant v) : _i2c(i2c), _variant(v) {
@@ -44,6 +51,22 @@ namespace esp32m {
       IPins::init(8);
     }
 
+    Ads1x1x::~Ads1x1x() {
+      if (_task) {
+        // the task may be in the middle of a conversion holding the mutex or
+        // the bus, let it finish and exit by itself
+        _stopped = true;
+        xTaskNotifyGive(_task);
+        int64_t wake = 0;
+        xQueueSend(_ready, &wake, 0);
+        while (!_exited) delay(1);
+      }
+      if (_rdy)
+        _rdy->detach();
+      if (_ready)
+        vQueueDelete(_ready);
+    }
+
     esp_err_t Ads1x1x::isBusy(bool &value) {
       uint16_t config;
       ESP_CHECK_RETURN(_i2c->read(ads1x1x::Register::Config, config));
@@ -61,7 +84,7 @@ namespace esp32m {
       }
       return ESP_OK;
     }
-    esp_err_t Ads1x1x::startReading(ads1x1x::Mux mux, bool continuous) {
+    esp_err_t Ads1x1x::writeConfig(ads1x1x::Mux mux, bool continuous) {
       // Start with default values
       uint16_t config =
           ads1x1x::ConfigCque1Conv |    // Set CQUE to any value other than
@@ -88,17 +111,24 @@ namespace esp32m {
       config |= ads1x1x::ConfigModeOsSingle;
 
       // Write config register to the ADC
-      ESP_CHECK_RETURN(_i2c->write(ads1x1x::Register::Config, config));
+      return _i2c->write(ads1x1x::Register::Config, config);
+    }
+    esp_err_t Ads1x1x::startReading(ads1x1x::Mux mux, bool continuous) {
+      ESP_CHECK_RETURN(writeConfig(mux, continuous));
 
-      // Set ALERT/RDY to RDY mode.
+      // Set ALERT/RDY to RDY mode: MSB of Hi_thresh set, MSB of Lo_thresh
+      // cleared
       ESP_CHECK_RETURN(
           _i2c->write(ads1x1x::Register::ThreshH, (uint16_t)0x8000));
       ESP_CHECK_RETURN(
-          _i2c->write(ads1x1x::Register::ThreshL, (uint16_t)0x8000));
+          _i2c->write(ads1x1x::Register::ThreshL, (uint16_t)0x0000));
       return ESP_OK;
     }
     esp_err_t Ads1x1x::readMux(ads1x1x::Mux mux, int16_t &value,
                                bool continuous) {
+      // the sampling task owns the mux
+      if (_task)
+        return ESP_ERR_INVALID_STATE;
       ESP_CHECK_RETURN(startReading(mux, continuous));
       bool busy = true;
       for (;;) {
@@ -138,6 +168,152 @@ namespace esp32m {
       return ESP_OK;
     }
 
+    esp_err_t Ads1x1x::setRdy(IPin *pin) {
+      if (_rdy)
+        return ESP_ERR_INVALID_STATE;
+      auto digital = pin ? pin->digital() : nullptr;
+      if (!digital)
+        return ESP_ERR_INVALID_ARG;
+      ESP_CHECK_RETURN(
+          _i2c->write(ads1x1x::Register::ThreshH, (uint16_t)0x8000));
+      ESP_CHECK_RETURN(
+          _i2c->write(ads1x1x::Register::ThreshL, (uint16_t)0x0000));
+      _channels.reset(new Channel[8]);
+      memset(_channels.get(), 0, sizeof(Channel) * 8);
+      _ready = xQueueCreate(4, sizeof(int64_t));
+      if (!_ready)
+        return ESP_ERR_NO_MEM;
+      // RDY is open drain and goes low when a conversion completes
+      auto err = digital->attach(_ready, GPIO_INTR_NEGEDGE);
+      if (err != ESP_OK) {
+        vQueueDelete(_ready);
+        _ready = nullptr;
+        return err;
+      }
+      _rdy = digital;
+      if (xTaskCreate([](void *self) { ((Ads1x1x *)self)->run(); },
+                      "m/ads1x1x", 3072, this, tskIDLE_PRIORITY + 2,
+                      &_task) != pdPASS) {
+        _task = nullptr;
+        return ESP_ERR_NO_MEM;
+      }
+      return ESP_OK;
+    }
+
+    void Ads1x1x::setAveraging(uint8_t samples) {
+      std::lock_guard guard(_mutex);
+      if (samples < 1)
+        samples = 1;
+      else if (samples > ads1x1x::MaxAveraging)
+        samples = ads1x1x::MaxAveraging;
+      _averaging = samples;
+    }
+
+    esp_err_t Ads1x1x::latest(int id, int16_t &value) {
+      if (!_task || id < 0 || id > 7)
+        return ESP_ERR_INVALID_STATE;
+      std::lock_guard guard(_mutex);
+      auto &c = _channels[id];
+      if (!c.count)
+        return ESP_ERR_INVALID_STATE;
+      value = c.samples[(c.pos + ads1x1x::MaxAveraging - 1) %
+                        ads1x1x::MaxAveraging];
+      return ESP_OK;
+    }
+
+    esp_err_t Ads1x1x::average(int id, int &value) {
+      std::lock_guard guard(_mutex);
+      auto &c = _channels[id];
+      if (!c.count)
+        return ESP_ERR_INVALID_STATE;
+      int n = std::min(c.count, _averaging);
+      int sum = 0;
+      for (int i = 1; i <= n; i++)
+        sum += c.samples[(c.pos + ads1x1x::MaxAveraging - i) %
+                         ads1x1x::MaxAveraging];
+      value = (sum + (sum < 0 ? -n : n) / 2) / n;
+      return ESP_OK;
+    }
+
+    void Ads1x1x::enable(int id) {
+      {
+        std::lock_guard guard(_mutex);
+        _enabled |= 1 << id;
+      }
+      if (_task)
+        xTaskNotifyGive(_task);
+    }
+
+    int Ads1x1x::next(int id) {
+      for (int i = 1; i <= 8; i++) {
+        auto n = (id + i) & 7;
+        if (_enabled & (1 << n))
+          return n;
+      }
+      return -1;
+    }
+
+    TickType_t Ads1x1x::timeout() {
+      auto sps = (_variant == ads1x1x::Variant::Ads101x
+                      ? ads1x1x::Ads101xSps
+                      : ads1x1x::Ads111xSps)[_rate >> ads1x1x::ConfigRateShift];
+      return pdMS_TO_TICKS(2000 / sps + 10);
+    }
+
+    void Ads1x1x::run() {
+      int current = -1;
+      bool continuous = false;
+      int64_t diff;
+      while (!_stopped) {
+        if (current < 0) {
+          {
+            std::lock_guard guard(_mutex);
+            current = next(-1);
+          }
+          if (current < 0) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+          }
+          xQueueReset(_ready);
+          esp_err_t err;
+          {
+            std::lock_guard guard(_mutex);
+            continuous = next(current) == current;
+            err = writeConfig((ads1x1x::Mux)(current << 12), continuous);
+          }
+          if (err != ESP_OK) {
+            // give the bus a break before trying again
+            current = -1;
+            vTaskDelay(timeout());
+          }
+          continue;
+        }
+        // the timeout spans two conversions, so a result is there even if RDY
+        // was missed, e.g. a continuous mode pulse behind a port expander
+        xQueueReceive(_ready, &diff, timeout());
+        std::lock_guard guard(_mutex);
+        int16_t value;
+        if (readValue(value) == ESP_OK) {
+          auto &c = _channels[current];
+          c.samples[c.pos] = value;
+          c.pos = (c.pos + 1) % ads1x1x::MaxAveraging;
+          if (c.count < ads1x1x::MaxAveraging)
+            c.count++;
+        }
+        auto n = next(current);
+        // in continuous mode the device keeps converting the same channel,
+        // otherwise the next conversion has to be started explicitly
+        if (continuous && n == current)
+          continue;
+        current = n;
+        continuous = next(current) == current;
+        if (writeConfig((ads1x1x::Mux)(current << 12), continuous) != ESP_OK)
+          current = -1;
+      }
+      _exited = true;
+      vTaskDelete(NULL);
+    }
+
     namespace ads1x1x {
       class Pin : public IPin {
        public:
@@ -191,12 +367,19 @@ namespace esp32m {
 
       class ADC : public pin::IADC {
        public:
-        ADC(Pin *pin) : _pin(pin) {}
+        ADC(Pin *pin) : _pin(pin) {
+          _pin->_owner->enable(pin->id());
+        }
         esp_err_t read(int &value, uint32_t *mv) override {
-          Mux mux = (Mux)(_pin->id() << 12);
-          int16_t v;
-          ESP_CHECK_RETURN(_pin->_owner->readMux(mux, v));
-          value = v;
+          auto owner = _pin->_owner;
+          if (owner->isSampling()) {
+            ESP_CHECK_RETURN(owner->average(_pin->id(), value));
+          } else {
+            Mux mux = (Mux)(_pin->id() << 12);
+            int16_t v;
+            ESP_CHECK_RETURN(owner->readMux(mux, v));
+            value = v;
+          }
           if (mv) {
             float volts;
             ESP_CHECK_RETURN(_pin->_owner->computeVolts(value, volts));
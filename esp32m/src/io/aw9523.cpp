@@ -101,6 +101,12 @@ namespace esp32m {
         esp_err_t write(bool value) override {
           return _pin->_owner->writePin(_pin->id(), value);
         }
+        esp_err_t attach(QueueHandle_t queue, gpio_int_type_t type) override {
+          return _pin->_owner->monitor().attach(_pin->id(), queue, type);
+        }
+        esp_err_t detach() override {
+          return _pin->_owner->monitor().detach(_pin->id());
+        }
 
        private:
         Pin *_pin;
@@ -139,7 +145,11 @@ namespace esp32m {
 
     }  // namespace aw9523
 
-    Aw9523::Aw9523(i2c::MasterDev *i2c) : _i2c(i2c) {
+    Aw9523::Aw9523(i2c::MasterDev *i2c)
+        : _i2c(i2c),
+          _monitor([this](uint16_t &port) {
+            return _i2c->read(aw9523::Register::InP0, port);
+          }) {
       init();
     }
 
@@ -203,11 +213,13 @@ namespace esp32m {
       uint16_t mask = 1 << pin;
       if (_cfg & mask) {
         auto tx = pin::Tx::current();
-        if (!tx || ((tx->type() & pin::Tx::Type::Read) != 0 &&
-                    !tx->getReadPerformed())) {
+        if (_monitor.isEnabled())
+          ESP_CHECK_RETURN(_monitor.read(_input));
+        else if (!tx || ((tx->type() & pin::Tx::Type::Read) != 0 &&
+                         !tx->getReadPerformed(this))) {
           ESP_CHECK_RETURN(readInput());
           if (tx)
-            tx->setReadPerformed();
+            tx->setReadPerformed(this);
         }
         value = _input & mask;
       } else if (_mode & mask) {
@@ -225,8 +237,7 @@ namespace esp32m {
         _out &= ~(1 << pin);
       if (!tx || ((tx->type() & pin::Tx::Type::Write) == 0))
         return commit();
-      if (!tx->getFinalizer())
-        tx->setFinalizer(this);
+      tx->setFinalizer(this);
       return ESP_OK;
     }
 
@@ -254,6 +265,8 @@ namespace esp32m {
         ESP_CHECK_RETURN(_i2c->write(aw9523::Register::CfgP0, _cfg = cfg));
       if (mode != _mode)
         ESP_CHECK_RETURN(_i2c->write(aw9523::Register::ModeP0, _mode = mode));
+      // INT only fires for pins that are inputs already
+      _monitor.invalidate();
       return ESP_OK;
     }
 
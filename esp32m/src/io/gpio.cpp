@@ -1,6 +1,8 @@
 #include "esp32m/io/gpio.hpp"
 #include "esp32m/defs.hpp"
+#include "esp32m/io/pcnt_count.hpp"
 #include "esp32m/io/pins.hpp"
+#include "esp32m/io/softpwm.hpp"
 #include "esp32m/io/utils.hpp"
 
 #include <driver/dac_oneshot.h>
@@ -15,10 +17,15 @@
 #include <sdkconfig.h>
 #include <soc/sens_periph.h>
 #include <string.h>
+#include <algorithm>
+#include <memory>
 #include <mutex>
 #if SOC_DAC_SUPPORTED
 #  include <soc/dac_channel.h>
 #endif
+#if SOC_MCPWM_SUPPORTED
+#  include <driver/mcpwm_prelude.h>
+#endif
 
 #if SOC_CLK_RC_FAST_SUPPORT_CALIBRATION
 #  define LEDC_CLK_SRC_FREQ_PRECISION ESP_CLK_TREE_SRC_FREQ_PRECISION_CACHED
@@ -122,7 +129,8 @@ namespace esp32m {
 
     class ISRArg {
      public:
-      ISRArg(Digital *pin, QueueHandle_t queue) : _pin(pin), _queue(queue) {
+      ISRArg(Digital *pin, QueueHandle_t queue, gpio_int_type_t type)
+          : _pin(pin), _queue(queue), _type(type) {
         _num = pin->_pin->num();
         _stamp = esp_timer_get_time();
         _level = gpio_get_level(_num) != 0;
@@ -132,6 +140,7 @@ namespace esp32m {
       Digital *_pin;
       gpio_num_t _num;
       QueueHandle_t _queue;
+      gpio_int_type_t _type;
       bool _level;
       int64_t _stamp;
       friend IRAM_ATTR void gpio_isr_handler(void *self);
@@ -433,9 +442,29 @@ namespace esp32m {
           : _channel(channel), _handle(handle) {}
     };
 #endif
+    struct EdgeCapture {
+      portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+      uint32_t glitchUs;
+      uint32_t count = 0;
+      int64_t last = 0;
+    };
+
+    void IRAM_ATTR pcnt_edge_isr_handler(void *self) {
+      int64_t stamp = esp_timer_get_time();
+      auto edges = (EdgeCapture *)self;
+      portENTER_CRITICAL_ISR(&edges->lock);
+      if (stamp - edges->last >= edges->glitchUs) {
+        edges->count++;
+        edges->last = stamp;
+      }
+      portEXIT_CRITICAL_ISR(&edges->lock);
+    }
+
     class Pcnt : public pin::IPcnt {
      public:
       ~Pcnt() override {
+        _sampler.reset();
+        captureEdges(false);
         if (_channel && _unit)
           pcnt_unit_stop(_unit);
         if (_channel) {
@@ -499,16 +528,63 @@ namespace esp32m {
         glitchNs = _glitchNs;
         return ESP_OK;
       }
+      esp_err_t captureEdges(bool on, uint32_t glitchUs) override {
+        auto num = _pin->num();
+        if (!on) {
+          if (!_edges)
+            return ESP_OK;
+          ESP_CHECK_RETURN(gpio_intr_disable(num));
+          ESP_CHECK_RETURN(gpio_isr_handler_remove(num));
+          delete _edges;
+          _edges = nullptr;
+          return ESP_OK;
+        }
+        if (_edges)
+          return ESP_ERR_INVALID_STATE;
+        esp_err_t err = gpio_install_isr_service(0);
+        if (err != ESP_ERR_INVALID_STATE)
+          ESP_CHECK_RETURN(err);
+        // the channel has already routed the pin as an input
+        ESP_CHECK_RETURN(gpio_set_intr_type(num, GPIO_INTR_POSEDGE));
+        auto edges = new EdgeCapture();
+        edges->glitchUs = glitchUs;
+        err = gpio_isr_handler_add(num, pcnt_edge_isr_handler, edges);
+        if (err != ESP_OK) {
+          delete edges;
+          return err;
+        }
+        _edges = edges;
+        return gpio_intr_enable(num);
+      }
+      esp_err_t readEdges(uint32_t &count, int64_t &last) override {
+        auto edges = _edges;
+        if (!edges)
+          return ESP_ERR_INVALID_STATE;
+        portENTER_CRITICAL(&edges->lock);
+        count = edges->count;
+        last = edges->last;
+        portEXIT_CRITICAL(&edges->lock);
+        return ESP_OK;
+      }
 
       static esp_err_t create(Pin *pin, pin::Feature **feature) {
         pcnt_unit_config_t unit_config = {};
-        unit_config.low_limit = SHRT_MIN;
-        unit_config.high_limit = SHRT_MAX;
+        unit_config.low_limit = pcnt::LowLimit;
+        unit_config.high_limit = pcnt::HighLimit;
         unit_config.flags.accum_count = true;
 
         pcnt_unit_handle_t unit;
         pcnt_channel_handle_t channel;
         ESP_CHECK_RETURN(pcnt_new_unit(&unit_config, &unit));
+        // the driver only accumulates on limit watch point events, without
+        // them the count silently drops back to 0 at either limit
+        for (auto limit : {pcnt::LowLimit, pcnt::HighLimit}) {
+          auto err = pcnt_unit_add_watch_point(unit, limit);
+          if (err != ESP_OK) {
+            pcnt_del_unit(unit);
+            return err;
+          }
+        }
         pcnt_chan_config_t chan_config = {
             .edge_gpio_num = pin->num(),
             .level_gpio_num = -1,
@@ -548,6 +624,7 @@ namespace esp32m {
       pcnt_channel_level_action_t _hla = PCNT_CHANNEL_LEVEL_ACTION_KEEP,
                                   _lla = PCNT_CHANNEL_LEVEL_ACTION_KEEP;
       uint32_t _glitchNs = 0;
+      EdgeCapture *_edges = nullptr;
       Pcnt(Pin *pin, pcnt_unit_handle_t unit, pcnt_channel_handle_t channel)
           : _pin(pin), _unit(unit), _channel(channel) {}
     };
@@ -637,8 +714,12 @@ namespace esp32m {
       esp_err_t setFreq(uint32_t value) override {
         if (_freq == value)
           return ESP_OK;
-        if (_timer >= 0) { // TODO: this is bad idea if the timer is used by more than 1 channel
-          ESP_CHECK_RETURN(ledc_set_freq(LEDC_BEST_SPEED_MODE, (ledc_timer_t)_timer, value));
+        {
+          // channels of equal frequency share a timer and run in phase,
+          // retuning it in place would drag the other channels along
+          std::lock_guard lock(ledcTimersMutex);
+          ledcTimerUnref(_timer);
+          _timer = -1;
         }
         _freq = value;
         return ensureChannel();
@@ -657,6 +738,9 @@ namespace esp32m {
       bool isEnabled() const override {
         return _enabled;
       }
+      const char *backend() const override {
+        return "ledc";
+      }
 
       static esp_err_t create(Pin *pin, pin::Feature **feature) {
         std::lock_guard lock(ledcTimersMutex);
@@ -704,6 +788,290 @@ namespace esp32m {
       }
     };
 
+#if SOC_MCPWM_SUPPORTED
+    namespace mcpwm {
+      /** Counts for every operator of the given frequency in its group, so
+       * that all channels running at that frequency stay in phase */
+      struct Timer {
+        int group;
+        uint32_t freq, period;
+        mcpwm_timer_handle_t handle;
+        int ref;
+      };
+      /** Drives up to SOC_MCPWM_GENERATORS_PER_OPERATOR pins */
+      struct Operator {
+        Timer *timer;
+        mcpwm_oper_handle_t handle;
+        int ref;
+      };
+
+      const int MaxChannels = SOC_MCPWM_GROUPS *
+                              SOC_MCPWM_OPERATORS_PER_GROUP *
+                              SOC_MCPWM_GENERATORS_PER_OPERATOR;
+      std::mutex mutex;
+      std::vector<Operator *> operators;
+      int channels = 0;
+
+      // keeps the period within the 16-bit counter
+      uint32_t resolution(uint32_t freq) {
+        if (freq >= 160)
+          return 10000000;
+        if (freq >= 16)
+          return 1000000;
+        return 0;
+      }
+
+      void timerUnref(Timer *timer) {
+        if (--timer->ref)
+          return;
+        mcpwm_timer_start_stop(timer->handle, MCPWM_TIMER_STOP_EMPTY);
+        mcpwm_timer_disable(timer->handle);
+        mcpwm_del_timer(timer->handle);
+        delete timer;
+      }
+
+      Timer *timerNew(int group, uint32_t freq) {
+        mcpwm_timer_config_t c = {};
+        c.group_id = group;
+        c.clk_src = MCPWM_TIMER_CLK_SRC_DEFAULT;
+        c.resolution_hz = resolution(freq);
+        c.count_mode = MCPWM_TIMER_COUNT_MODE_UP;
+        c.period_ticks = c.resolution_hz / freq;
+        mcpwm_timer_handle_t handle;
+        if (mcpwm_new_timer(&c, &handle) != ESP_OK)
+          return nullptr;
+        if (mcpwm_timer_enable(handle) != ESP_OK) {
+          mcpwm_del_timer(handle);
+          return nullptr;
+        }
+        if (mcpwm_timer_start_stop(handle, MCPWM_TIMER_START_NO_STOP) !=
+            ESP_OK) {
+          mcpwm_timer_disable(handle);
+          mcpwm_del_timer(handle);
+          return nullptr;
+        }
+        return new Timer{group, freq, c.period_ticks, handle, 0};
+      }
+
+      Operator *operatorNew(Timer *timer) {
+        mcpwm_operator_config_t c = {};
+        c.group_id = timer->group;
+        mcpwm_oper_handle_t handle;
+        if (mcpwm_new_operator(&c, &handle) != ESP_OK)
+          return nullptr;
+        if (mcpwm_operator_connect_timer(handle, timer->handle) != ESP_OK) {
+          mcpwm_del_operator(handle);
+          return nullptr;
+        }
+        timer->ref++;
+        auto o = new Operator{timer, handle, 0};
+        operators.push_back(o);
+        return o;
+      }
+
+      /** Finds a generator slot for the frequency, sharing the operator or at
+       * least the timer with other channels of that frequency when possible.
+       * Must be called with the mutex held */
+      Operator *acquire(uint32_t freq) {
+        if (!resolution(freq))
+          return nullptr;
+        for (auto o : operators)
+          if (o->timer->freq == freq &&
+              o->ref < SOC_MCPWM_GENERATORS_PER_OPERATOR) {
+            o->ref++;
+            return o;
+          }
+        Operator *result = nullptr;
+        for (auto o : operators)
+          if (o->timer->freq == freq) {
+            result = operatorNew(o->timer);
+            if (result)
+              break;
+          }
+        for (int g = 0; !result && g < SOC_MCPWM_GROUPS; g++) {
+          auto timer = timerNew(g, freq);
+          if (!timer)
+            continue;
+          timer->ref++;  // hold it while the operator is being set up
+          result = operatorNew(timer);
+          timerUnref(timer);
+        }
+        if (result)
+          result->ref++;
+        return result;
+      }
+
+      void release(Operator *o) {
+        if (--o->ref)
+          return;
+        operators.erase(std::find(operators.begin(), operators.end(), o));
+        mcpwm_del_operator(o->handle);
+        timerUnref(o->timer);
+        delete o;
+      }
+    }  // namespace mcpwm
+
+    class Mcpwm : public pin::IPWM {
+     public:
+      ~Mcpwm() override {
+        std::lock_guard lock(mcpwm::mutex);
+        release();
+        mcpwm::channels--;
+      }
+      esp_err_t setDuty(float value) override {
+        _duty = value;
+        ESP_CHECK_RETURN(ensureChannel());
+        if (_soft) {
+          ESP_CHECK_RETURN(_soft->setDuty(value));
+          return enable(true);
+        }
+        ESP_CHECK_RETURN(
+            mcpwm_comparator_set_compare_value(_comparator, ticks()));
+        ESP_CHECK_RETURN(
+            mcpwm_generator_set_force_level(_generator, level(true), true));
+        _enabled = true;
+        return ESP_OK;
+      };
+      float getDuty() const override {
+        return _duty;
+      };
+      esp_err_t setFreq(uint32_t value) override {
+        if (_freq == value)
+          return ESP_OK;
+        {
+          std::lock_guard lock(mcpwm::mutex);
+          release();
+        }
+        // the backend is picked again for the new frequency
+        _soft.reset();
+        _freq = value;
+        return ensureChannel();
+      }
+      uint32_t getFreq() const override {
+        return _freq;
+      };
+      esp_err_t enable(bool on) override {
+        ESP_CHECK_RETURN(ensureChannel());
+        if (_soft)
+          ESP_CHECK_RETURN(_soft->enable(on));
+        else
+          ESP_CHECK_RETURN(
+              mcpwm_generator_set_force_level(_generator, level(on), true));
+        _enabled = on;
+        return ESP_OK;
+      }
+      bool isEnabled() const override {
+        return _enabled;
+      }
+      const char *backend() const override {
+        return _soft ? "soft" : "mcpwm";
+      }
+
+      static esp_err_t create(Pin *pin, pin::Feature **feature) {
+        std::lock_guard lock(mcpwm::mutex);
+        if (mcpwm::channels >= mcpwm::MaxChannels)
+          return ESP_FAIL;
+        mcpwm::channels++;
+        *feature = new Mcpwm(pin);
+        return ESP_OK;
+      }
+
+     private:
+      Pin *_pin;
+      mcpwm::Operator *_oper = nullptr;
+      mcpwm_cmpr_handle_t _comparator = nullptr;
+      mcpwm_gen_handle_t _generator = nullptr;
+      // used instead of MCPWM when no timer can run at the frequency
+      std::unique_ptr<SoftPwm> _soft;
+      uint32_t _freq = 0;
+      float _duty = 0;
+      bool _enabled = false;
+
+      Mcpwm(Pin *pin) : _pin(pin) {}
+      // the comparator only takes values below the period, full duty is
+      // forced by level()
+      uint32_t ticks() const {
+        auto period = _oper->timer->period;
+        if (_duty <= 0)
+          return 0;
+        return std::min((uint32_t)(_duty * period), period - 1);
+      }
+      int level(bool on) const {
+        if (!on || _duty <= 0)
+          return 0;
+        if (_duty >= 1)
+          return 1;
+        return -1;
+      }
+      esp_err_t useSoft() {
+        auto num = _pin->num();
+        ESP_CHECK_RETURN(gpio_reset_pin(num));
+        ESP_CHECK_RETURN(gpio_set_direction(num, GPIO_MODE_OUTPUT));
+        _soft = std::make_unique<SoftPwm>(
+            [num](bool high) { gpio_set_level(num, high); });
+        ESP_CHECK_RETURN(_soft->setFreq(_freq));
+        ESP_CHECK_RETURN(_soft->setDuty(_duty));
+        LOGI(_pin, "PWM config: no MCPWM timer for freq=%i, using soft PWM",
+             _freq);
+        return _enabled ? _soft->enable(true) : ESP_OK;
+      }
+      // must be called with the mutex held
+      void release() {
+        if (!_oper)
+          return;
+        mcpwm_del_generator(_generator);
+        mcpwm_del_comparator(_comparator);
+        _generator = nullptr;
+        _comparator = nullptr;
+        mcpwm::release(_oper);
+        _oper = nullptr;
+      }
+      esp_err_t ensureChannel() {
+        if (_oper || _soft)
+          return ESP_OK;
+        if (!_freq)
+          return ESP_FAIL;
+        std::lock_guard lock(mcpwm::mutex);
+        auto oper = mcpwm::acquire(_freq);
+        if (!oper)
+          return useSoft();
+        mcpwm_comparator_config_t cc = {};
+        cc.flags.update_cmp_on_tez = true;
+        auto err = mcpwm_new_comparator(oper->handle, &cc, &_comparator);
+        if (err == ESP_OK) {
+          mcpwm_generator_config_t gc = {};
+          gc.gen_gpio_num = _pin->num();
+          err = mcpwm_new_generator(oper->handle, &gc, &_generator);
+          if (err != ESP_OK) {
+            mcpwm_del_comparator(_comparator);
+            _comparator = nullptr;
+          }
+        }
+        if (err != ESP_OK) {
+          mcpwm::release(oper);
+          return err;
+        }
+        _oper = oper;
+        ESP_CHECK_RETURN(
+            mcpwm_comparator_set_compare_value(_comparator, ticks()));
+        ESP_CHECK_RETURN(mcpwm_generator_set_action_on_timer_event(
+            _generator,
+            MCPWM_GEN_TIMER_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP,
+                                         MCPWM_TIMER_EVENT_EMPTY,
+                                         MCPWM_GEN_ACTION_HIGH)));
+        ESP_CHECK_RETURN(mcpwm_generator_set_action_on_compare_event(
+            _generator,
+            MCPWM_GEN_COMPARE_EVENT_ACTION(MCPWM_TIMER_DIRECTION_UP,
+                                           _comparator, MCPWM_GEN_ACTION_LOW)));
+        ESP_CHECK_RETURN(
+            mcpwm_generator_set_force_level(_generator, level(_enabled), true));
+        LOGI(_pin, "PWM config: mcpwm group=%i, freq=%i, period=%i",
+             oper->timer->group, _freq, oper->timer->period);
+        return ESP_OK;
+      }
+    };
+#endif
+
     class LEDC : public pin::ILEDC {
      public:
       ~LEDC() override {
@@ -795,9 +1163,22 @@ namespace esp32m {
     void IRAM_ATTR gpio_isr_handler(void *self) {
       int64_t stamp = esp_timer_get_time();
       auto arg = (ISRArg *)self;
-      bool level = gpio_get_level(arg->_num) != 0;
-      if (arg->_level == level)
-        return;
+      bool level;
+      switch (arg->_type) {
+        // with a single edge type every interrupt is a transition, and a short
+        // pulse may be over before the level can be read here
+        case GPIO_INTR_NEGEDGE:
+          level = false;
+          break;
+        case GPIO_INTR_POSEDGE:
+          level = true;
+          break;
+        default:
+          level = gpio_get_level(arg->_num) != 0;
+          if (arg->_level == level)
+            return;
+          break;
+      }
       int64_t diff = stamp - arg->_stamp;
       if (diff > 0x7FFFFFFF)
         diff = 0x7FFFFFFF;
@@ -832,7 +1213,7 @@ namespace esp32m {
 
       // ESP_CHECK_RETURN(gpio_set_intr_type(num(), type));
       // ESP_CHECK_RETURN(gpio_intr_enable(num()));
-      _isr = new ISRArg(this, queue);
+      _isr = new ISRArg(this, queue, type);
       err = gpio_isr_handler_add(num, gpio_isr_handler, _isr);
       if (err != ESP_OK) {
         delete _isr;
@@ -866,6 +1247,10 @@ namespace esp32m {
           if ((flags() & pin::Flags::Output) != 0) {
             if (gpio::PWM::create(this, feature) == ESP_OK)
               return ESP_OK;
+#if SOC_MCPWM_SUPPORTED
+            if (gpio::Mcpwm::create(this, feature) == ESP_OK)
+              return ESP_OK;
+#endif
           }
           break;
         case pin::Type::ADC:
@@ -0,0 +1,174 @@
+#include "esp32m/io/inputs.hpp"
+#include "esp32m/base.hpp"
+#include "esp32m/device.hpp"
+
+#include <esp_task_wdt.h>
+
+#include <vector>
+
+namespace esp32m {
+  namespace io {
+
+    Inputs &Inputs::instance() {
+      static Inputs i;
+      return i;
+    }
+
+    esp_err_t Inputs::init() {
+      if (_task)
+        return ESP_OK;
+      // one slot per queued edge, plus room for handles of queues that were
+      // removed before the task got to them
+      _set = xQueueCreateSet((MaxInputs + 1) * QueueDepth);
+      if (!_set)
+        return ESP_ERR_NO_MEM;
+      if (xTaskCreate([](void *self) { ((Inputs *)self)->run(); }, "m/inputs",
+                      4096, this, tskIDLE_PRIORITY + 5, &_task) != pdPASS) {
+        vQueueDelete(_set);
+        _set = nullptr;
+        return ESP_ERR_NO_MEM;
+      }
+      return ESP_OK;
+    }
+
+    esp_err_t Inputs::add(IPin *pin, const input::Options &options) {
+      auto digital = pin ? pin->digital() : nullptr;
+      if (!digital)
+        return ESP_ERR_INVALID_ARG;
+      bool level;
+      {
+        std::lock_guard guard(_mutex);
+        for (auto &[queue, input] : _inputs)
+          if (input.pin == pin)
+            return ESP_ERR_INVALID_STATE;
+        if (_inputs.size() >= MaxInputs)
+          return ESP_ERR_NO_MEM;
+        ESP_CHECK_RETURN(init());
+        auto queue = xQueueCreate(QueueDepth, sizeof(int64_t));
+        if (!queue)
+          return ESP_ERR_NO_MEM;
+        xQueueAddToSet(queue, _set);
+        auto err = digital->attach(queue, GPIO_INTR_ANYEDGE);
+        if (err == ESP_OK) {
+          err = digital->read(level);
+          if (err != ESP_OK)
+            digital->detach();
+        }
+        if (err != ESP_OK) {
+          xQueueReset(queue);
+          xQueueRemoveFromSet(queue, _set);
+          vQueueDelete(queue);
+          return err;
+        }
+        level ^= options.inverted;
+        _inputs[queue] = {pin, options, level, millis(), false, 0};
+      }
+      if (options.component)
+        options.component->setState(level);
+      return ESP_OK;
+    }
+
+    esp_err_t Inputs::remove(IPin *pin) {
+      std::lock_guard guard(_mutex);
+      for (auto it = _inputs.begin(); it != _inputs.end(); it++)
+        if (it->second.pin == pin) {
+          auto queue = it->first;
+          pin->digital()->detach();
+          _inputs.erase(it);
+          // the set may still hold the handle, the task skips unknown ones
+          xQueueReset(queue);
+          xQueueRemoveFromSet(queue, _set);
+          vQueueDelete(queue);
+          return ESP_OK;
+        }
+      return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_err_t Inputs::read(IPin *pin, bool &level) {
+      std::lock_guard guard(_mutex);
+      for (auto &[queue, input] : _inputs)
+        if (input.pin == pin) {
+          level = input.level;
+          return ESP_OK;
+        }
+      return ESP_ERR_NOT_FOUND;
+    }
+
+    bool Inputs::settle(Input &input, unsigned long now, Change &change) {
+      input.armed = false;
+      bool level;
+      // the level is read rather than derived from the edges, so a burst that
+      // overflowed the queue cannot leave a stale state behind
+      if (ESP_ERROR_CHECK_WITHOUT_ABORT(input.pin->digital()->read(level)) !=
+          ESP_OK)
+        return false;
+      level ^= input.options.inverted;
+      if (level == input.level)
+        return false;
+      auto edge = level ? input::Edge::Rising : input::Edge::Falling;
+      change = {input.pin, level, now - input.since,
+                ((int)input.options.edges & (int)edge) != 0,
+                input.options.component};
+      input.level = level;
+      input.since = now;
+      return true;
+    }
+
+    void Inputs::run() {
+      esp_task_wdt_add(NULL);
+      std::vector<Change> changes;
+      for (;;) {
+        esp_task_wdt_reset();
+        TickType_t wait = pdMS_TO_TICKS(1000);
+        {
+          std::lock_guard guard(_mutex);
+          auto now = millis();
+          for (auto &[queue, input] : _inputs)
+            if (input.armed) {
+              long left = input.deadline - now;
+              TickType_t ticks =
+                  left > 0 ? (left + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS
+                           : 0;
+              if (ticks < wait)
+                wait = ticks;
+            }
+        }
+        auto member = xQueueSelectFromSet(_set, wait);
+        {
+          std::lock_guard guard(_mutex);
+          auto now = millis();
+          if (member) {
+            auto it = _inputs.find(member);
+            int64_t diff;
+            if (it != _inputs.end() &&
+                xQueueReceive(member, &diff, 0) == pdTRUE) {
+              auto &input = it->second;
+              input.armed = true;
+              input.deadline = now + input.options.debounceMs;
+            }
+          }
+          Change change;
+          for (auto &[queue, input] : _inputs)
+            if (input.armed && (long)(now - input.deadline) >= 0 &&
+                settle(input, now, change))
+              changes.push_back(change);
+        }
+        // outside of the lock, subscribers may call back into read()
+        for (auto &c : changes) {
+          if (c.component)
+            c.component->setState(c.level);
+          if (c.report) {
+            input::Changed ev(c.pin, c.level, c.held);
+            ev.publish();
+          }
+        }
+        changes.clear();
+      }
+    }
+
+    Inputs &useInputs() {
+      return Inputs::instance();
+    }
+
+  }  // namespace io
+}  // namespace esp32m
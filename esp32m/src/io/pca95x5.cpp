@@ -43,6 +43,12 @@ namespace esp32m {
         esp_err_t write(bool value) override {
           return _pin->_owner->writePin(_pin->id(), value);
         }
+        esp_err_t attach(QueueHandle_t queue, gpio_int_type_t type) override {
+          return _pin->_owner->monitor().attach(_pin->id(), queue, type);
+        }
+        esp_err_t detach() override {
+          return _pin->_owner->monitor().detach(_pin->id());
+        }
 
        private:
         Pin *_pin;
@@ -60,7 +66,12 @@ namespace esp32m {
       }
     }  // namespace pca95x5
 
-    Pca95x5::Pca95x5(i2c::MasterDev *i2c, pca95x5::Bits bits) : _i2c(i2c), _bits(bits) {
+    Pca95x5::Pca95x5(i2c::MasterDev *i2c, pca95x5::Bits bits)
+        : _i2c(i2c),
+          _bits(bits),
+          _monitor([this](uint16_t &port) {
+            return read(pca95x5::Register::Input, port);
+          }) {
       init();
     }
 
@@ -110,13 +121,18 @@ namespace esp32m {
         return ESP_OK;
       }
 
+      if (_monitor.isEnabled()) {
+        ESP_CHECK_RETURN(_monitor.read(_input));
+        value = _input & (1 << pin);
+        return ESP_OK;
+      }
       auto tx = pin::Tx::current();
       if (!tx || ((tx->type() & pin::Tx::Type::Read) != 0 &&
-                  !tx->getReadPerformed())) {
+                  !tx->getReadPerformed(this))) {
         ESP_CHECK_RETURN(read(pca95x5::Register::Input, _input));
         // logD("readPin %d reg_input=0x%04x", pin, _input);
         if (tx)
-          tx->setReadPerformed();
+          tx->setReadPerformed(this);
       }
       value = _input & (1 << pin);
       return ESP_OK;
@@ -125,9 +141,9 @@ namespace esp32m {
       // logD("writePin %d: %d", pin, value);
       auto tx = pin::Tx::current();
       if (tx && (tx->type() & pin::Tx::Type::Read) != 0 &&
-          !tx->getReadPerformed()) {
+          !tx->getReadPerformed(this)) {
         ESP_CHECK_RETURN(read(pca95x5::Register::Input, _input));
-        tx->setReadPerformed();
+        tx->setReadPerformed(this);
       }
       if (value)
         _targetOutput |= (1 << pin);
@@ -137,8 +153,7 @@ namespace esp32m {
       if (!tx || ((tx->type() & pin::Tx::Type::Write) == 0))
         return commit();
 
-      if (!tx->getFinalizer())
-        tx->setFinalizer(this);
+      tx->setFinalizer(this);
       return ESP_OK;
     }
     esp_err_t Pca95x5::setPinMode(int pin, bool input) {
@@ -147,6 +162,8 @@ namespace esp32m {
       else
         _config &= ~(1 << pin);
       ESP_CHECK_RETURN(write(pca95x5::Register::Config, _config));
+      // INT only fires for pins that are inputs already
+      _monitor.invalidate();
       // logD("setPinMode (%d=%d) reg_config=0x%04x", pin, input, _config);
       return ESP_OK;
     }
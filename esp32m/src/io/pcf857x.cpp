@@ -64,6 +64,12 @@ namespace esp32m {
         esp_err_t write(bool value) override {
           return _pin->_owner->writePin(_pin->id(), value);
         }
+        esp_err_t attach(QueueHandle_t queue, gpio_int_type_t type) override {
+          return _pin->_owner->monitor().attach(_pin->id(), queue, type);
+        }
+        esp_err_t detach() override {
+          return _pin->_owner->monitor().detach(_pin->id());
+        }
 
        private:
         Pin *_pin;
@@ -81,7 +87,10 @@ namespace esp32m {
       }
     }  // namespace pcf857x
 
-    Pcf857x::Pcf857x(Flavor f, i2c::MasterDev *i2c) : _flavor(f), _i2c(i2c) {
+    Pcf857x::Pcf857x(Flavor f, i2c::MasterDev *i2c)
+        : _flavor(f),
+          _i2c(i2c),
+          _monitor([this](uint16_t &port) { return readPort(port); }) {
       init();
     }
 
@@ -95,10 +104,14 @@ namespace esp32m {
       return new pcf857x::Pin(this, id);
     }
 
+    esp_err_t Pcf857x::readPort(uint16_t &port) {
+      port = 0;
+      return _i2c->read(nullptr, 0, &port, _flavor == Flavor::PCF8574 ? 1 : 2);
+    }
+
     esp_err_t Pcf857x::read(uint16_t &port) {
       // std::lock_guard guard(_i2c->mutex());
-      ESP_CHECK_RETURN(
-          _i2c->read(nullptr, 0, &port, _flavor == Flavor::PCF8574 ? 1 : 2));
+      ESP_CHECK_RETURN(readPort(port));
       _port = port;
       return ESP_OK;
     }
@@ -108,17 +121,25 @@ namespace esp32m {
       ESP_CHECK_RETURN(
           _i2c->write(nullptr, 0, &port, _flavor == Flavor::PCF8574 ? 1 : 2));
       _port = port;
+      // levels of the pins driven low have changed without INT
+      _monitor.invalidate();
       return ESP_OK;
     }
 
     esp_err_t Pcf857x::readPin(int pin, bool &value) {
+      if (_monitor.isEnabled()) {
+        uint16_t port;
+        ESP_CHECK_RETURN(_monitor.read(port));
+        value = port & (1 << pin);
+        return ESP_OK;
+      }
       auto tx = pin::Tx::current();
       if (!tx || ((tx->type() & pin::Tx::Type::Read) != 0 &&
-                  !tx->getReadPerformed())) {
+                  !tx->getReadPerformed(this))) {
         uint16_t port;
         ESP_CHECK_RETURN(read(port));
         if (tx)
-          tx->setReadPerformed();
+          tx->setReadPerformed(this);
       }
       value = _port & (1 << pin);
       return ESP_OK;
@@ -126,10 +147,10 @@ namespace esp32m {
     esp_err_t Pcf857x::writePin(int pin, bool value) {
       auto tx = pin::Tx::current();
       if (tx && (tx->type() & pin::Tx::Type::Read) != 0 &&
-          !tx->getReadPerformed()) {
+          !tx->getReadPerformed(this)) {
         uint16_t port;
         ESP_CHECK_RETURN(read(port));
-        tx->setReadPerformed();
+        tx->setReadPerformed(this);
       }
       if (value)
         _port |= (1 << pin);
@@ -137,8 +158,7 @@ namespace esp32m {
         _port &= ~(1 << pin);
       if (!tx || ((tx->type() & pin::Tx::Type::Write) == 0))
         return commit();
-      if (!tx->getFinalizer())
-        tx->setFinalizer(this);
+      tx->setFinalizer(this);
       return ESP_OK;
     }
     esp_err_t Pcf857x::setPinMode(int pin, bool input) {
@@ -1,7 +1,11 @@
 #include "esp32m/io/pins.hpp"
 #include "esp32m/defs.hpp"
+#include "esp32m/io/pcnt_count.hpp"
 #include "esp32m/io/softpwm.hpp"
 
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
 #include <map>
 #include <mutex>
 
@@ -34,6 +38,9 @@ namespace esp32m {
         bool isEnabled() const override {
           return _pwm->isEnabled();
         }
+        const char *backend() const override {
+          return "soft";
+        }
 
        private:
         pin::IDigital *_digital;
@@ -128,6 +135,7 @@ namespace esp32m {
     }
 
     namespace pin {
+      std::recursive_mutex Tx::_mutex;
       int Tx::_nesting = 0;
       Tx *Tx::_current = nullptr;
       Tx::Tx(Type type, esp_err_t *errPtr) : _type(type), _errPtr(errPtr) {
@@ -140,21 +148,34 @@ namespace esp32m {
         _nesting--;
         if (_nesting == 0)
           _current = nullptr;
-        if (_finalizer) {
-          auto err = _finalizer->commit();
-          if (err) {
-            if (_errPtr)
-              *_errPtr = err;
-            else
-              ESP_ERROR_CHECK_WITHOUT_ABORT(err);
-          }
+        // order devices by bus, within a group they keep the order they were
+        // written to. Each commit takes the bus lock on its own (it is not
+        // recursive), so transfers of other tasks may still get in between
+        std::stable_sort(_finalizers.begin(), _finalizers.end(),
+                         [](ITxFinalizer *a, ITxFinalizer *b) {
+                           return std::less<const void *>()(a->txGroup(),
+                                                            b->txGroup());
+                         });
+        esp_err_t first = ESP_OK;
+        for (auto finalizer : _finalizers) {
+          auto err = finalizer->commit();
+          if (err && first == ESP_OK)
+            first = err;
+        }
+        if (first) {
+          if (_errPtr)
+            *_errPtr = first;
+          else
+            ESP_ERROR_CHECK_WITHOUT_ABORT(first);
         }
         _mutex.unlock();
       }
       esp_err_t Tx::setFinalizer(ITxFinalizer *finalizer) {
-        if (_finalizer)
-          return ESP_FAIL;
-        _finalizer = finalizer;
+        if (!finalizer)
+          return ESP_ERR_INVALID_ARG;
+        if (std::find(_finalizers.begin(), _finalizers.end(), finalizer) ==
+            _finalizers.end())
+          _finalizers.push_back(finalizer);
         return ESP_OK;
       }
 
@@ -178,6 +199,7 @@ namespace esp32m {
       esp_err_t PcntSampler::setPeriod(uint64_t period) {
         if (!_timer)
           return ESP_ERR_INVALID_STATE;
+        std::lock_guard guard(_mutex);
         if (_period) {
           esp_timer_stop(_timer);
           _period = 0;
@@ -185,6 +207,8 @@ namespace esp32m {
         _value = 0;
         _freq = 0;
         _ticks = 0;
+        _seeded = false;
+        ESP_CHECK_RETURN(capture(false));
         if (period) {
           ESP_CHECK_RETURN(esp_timer_start_periodic(_timer, period));
           int value;
@@ -192,21 +216,89 @@ namespace esp32m {
             _value = value;
           _period = period;
           _ticks = esp_timer_get_time();
+          if (_mode == Mode::Reciprocal)
+            ESP_CHECK_RETURN(capture(true));
         }
         return ESP_OK;
       }
 
+      esp_err_t PcntSampler::setMode(Mode mode) {
+        std::lock_guard guard(_mutex);
+        _mode = mode;
+        if (_period && mode != Mode::Auto)
+          ESP_CHECK_RETURN(capture(mode == Mode::Reciprocal));
+        return ESP_OK;
+      }
+
+      esp_err_t PcntSampler::setGlitchFilter(uint32_t us) {
+        std::lock_guard guard(_mutex);
+        _glitchUs = us;
+        if (!_reciprocal)
+          return ESP_OK;
+        ESP_CHECK_RETURN(capture(false));
+        return capture(true);
+      }
+
+      esp_err_t PcntSampler::capture(bool on) {
+        if (on == _reciprocal)
+          return ESP_OK;
+        ESP_CHECK_RETURN(_pcnt->captureEdges(on, _glitchUs));
+        _reciprocal = on;
+        // the next edge becomes the reference
+        int64_t last;
+        if (!on || _pcnt->readEdges(_edges, last) != ESP_OK)
+          _edges = 0;
+        _lastEdge = 0;
+        _captureStart = esp_timer_get_time();
+        return ESP_OK;
+      }
+
       void PcntSampler::cb() {
         if (!_pcnt->isEnabled())
           return;
+        std::lock_guard guard(_mutex);
         int value;
+        auto ticks = esp_timer_get_time();
         if (_pcnt->read(value) == ESP_OK) {
-          float ppp = value > _value ? value - _value : _value - value;
-          auto ticks = esp_timer_get_time();
+          float ppp = std::abs(pcnt::countDelta(_value, value));
           auto elapsed = ticks > _ticks ? ticks - _ticks : _ticks - ticks;
           _value = value;
           _ticks = ticks;
-          _freq = (_freq + ppp * _period / elapsed) / 2;
+          if (!_reciprocal && elapsed) {
+            auto freq = ppp * 1000000 / elapsed;
+            _freq = _seeded ? (_freq + freq) / 2 : freq;
+            _seeded = true;
+          }
+        }
+        uint32_t count;
+        int64_t last;
+        if (_reciprocal && _pcnt->readEdges(count, last) == ESP_OK) {
+          auto edges = count - _edges;
+          if (!_lastEdge) {
+            if (edges) {
+              _edges = count;
+              _lastEdge = last;
+            } else if (ticks > _captureStart) {
+              // no reference edge since capturing started, e.g. the flow
+              // stopped while counting
+              _freq = std::min(_freq, 1000000.0f / (ticks - _captureStart));
+            }
+          } else if (edges >= _minEdges && last > _lastEdge) {
+            _freq = edges * 1000000.0f / (last - _lastEdge);
+            _edges = count;
+            _lastEdge = last;
+          } else if (ticks > _lastEdge) {
+            // no edge for a while: the period is at least that long
+            _freq = std::min(_freq, (edges + 1) * 1000000.0f /
+                                        (ticks - _lastEdge));
+          }
+        }
+        // the first counting period decides which way auto mode starts
+        if (_mode == Mode::Auto && _seeded) {
+          if (!_reciprocal && _freq < _crossover)
+            capture(true);
+          else if (_reciprocal && _freq > _crossover * 2)
+            capture(false);
         }
       }
 
@@ -0,0 +1,142 @@
+#include "esp32m/io/portmonitor.hpp"
+#include "esp32m/base.hpp"
+
+namespace esp32m {
+  namespace io {
+
+    PortMonitor::~PortMonitor() {
+      if (_task) {
+        // the task may be in the middle of a read holding the mutex or the
+        // bus, let it finish and exit by itself
+        _stopped = true;
+        int64_t wake = -1;
+        xQueueSend(_edges, &wake, portMAX_DELAY);
+        while (!_exited) delay(1);
+      }
+      if (_int)
+        _int->detach();
+      if (_edges)
+        vQueueDelete(_edges);
+    }
+
+    esp_err_t PortMonitor::setInt(IPin *pin) {
+      if (_int)
+        return ESP_ERR_INVALID_STATE;
+      auto digital = pin ? pin->digital() : nullptr;
+      if (!digital)
+        return ESP_ERR_INVALID_ARG;
+      _edges = xQueueCreate(8, sizeof(int64_t));
+      if (!_edges)
+        return ESP_ERR_NO_MEM;
+      // INT is released by the read that follows the falling edge, rising
+      // edges are reported too but ignored
+      auto err = digital->attach(_edges, GPIO_INTR_ANYEDGE);
+      if (err != ESP_OK) {
+        vQueueDelete(_edges);
+        _edges = nullptr;
+        return err;
+      }
+      std::lock_guard guard(_mutex);
+      _int = digital;
+      _valid = false;
+      return ESP_OK;
+    }
+
+    bool PortMonitor::drain() {
+      bool fell = false;
+      int64_t diff;
+      while (xQueueReceive(_edges, &diff, 0) == pdTRUE)
+        if (diff >= 0)
+          fell = true;
+      return fell;
+    }
+
+    esp_err_t PortMonitor::refresh() {
+      _valid = false;
+      ESP_CHECK_RETURN(_reader(_port));
+      _valid = true;
+      auto stamp = esp_timer_get_time();
+      for (auto &[pin, w] : _watches) {
+        bool level = (_port & (1 << pin)) != 0;
+        if (level == w.level)
+          continue;
+        int64_t elapsed = stamp - w.stamp;
+        if (elapsed > 0x7FFFFFFF)
+          elapsed = 0x7FFFFFFF;
+        w.level = level;
+        w.stamp = stamp;
+        if ((level && w.type == GPIO_INTR_NEGEDGE) ||
+            (!level && w.type == GPIO_INTR_POSEDGE))
+          continue;
+        if (level)
+          elapsed = -elapsed;
+        xQueueSend(w.queue, &elapsed, 0);
+      }
+      return ESP_OK;
+    }
+
+    esp_err_t PortMonitor::read(uint16_t &port) {
+      std::lock_guard guard(_mutex);
+      // while the task runs, it keeps the cache up to date by itself, unless
+      // an edge is still waiting for it
+      if (_int && (!_task || uxQueueMessagesWaiting(_edges)) && drain())
+        _valid = false;
+      if (!_valid || !_int)
+        ESP_CHECK_RETURN(refresh());
+      port = _port;
+      return ESP_OK;
+    }
+
+    esp_err_t PortMonitor::attach(int pin, QueueHandle_t queue,
+                                  gpio_int_type_t type) {
+      if (!queue || pin < 0 || pin > 15)
+        return ESP_ERR_INVALID_ARG;
+      switch (type) {
+        case GPIO_INTR_POSEDGE:
+        case GPIO_INTR_NEGEDGE:
+        case GPIO_INTR_ANYEDGE:
+          break;
+        default:
+          return ESP_ERR_NOT_SUPPORTED;
+      }
+      if (!_int)
+        return ESP_ERR_NOT_SUPPORTED;
+      std::lock_guard guard(_mutex);
+      if (_watches.contains(pin))
+        return ESP_ERR_INVALID_STATE;
+      if (!_valid || drain())
+        ESP_CHECK_RETURN(refresh());
+      if (!_task &&
+          xTaskCreate([](void *self) { ((PortMonitor *)self)->run(); },
+                      "m/portmon", 3072, this, tskIDLE_PRIORITY + 2,
+                      &_task) != pdPASS) {
+        _task = nullptr;
+        return ESP_ERR_NO_MEM;
+      }
+      _watches[pin] = {queue, type, (_port & (1 << pin)) != 0,
+                       esp_timer_get_time()};
+      return ESP_OK;
+    }
+
+    esp_err_t PortMonitor::detach(int pin) {
+      std::lock_guard guard(_mutex);
+      return _watches.erase(pin) ? ESP_OK : ESP_ERR_INVALID_STATE;
+    }
+
+    void PortMonitor::run() {
+      int64_t diff;
+      while (!_stopped) {
+        // edges are taken off the queue under the mutex only, so that read()
+        // sees them pending until the port is refreshed
+        if (xQueuePeek(_edges, &diff, portMAX_DELAY) != pdTRUE)
+          continue;
+        std::lock_guard guard(_mutex);
+        if (drain())
+          refresh();
+      }
+      _exited = true;
+      vTaskDelete(NULL);
+    }
+
+  }  // namespace io
+}  // namespace esp32m
@@ -1,4 +1,5 @@
 #include "esp32m/json.hpp"
+#include "esp32m/debug/heap.hpp"
 #include "esp32m/logging.hpp"
 
 #include <errno.h>
@@ -44,7 +45,12 @@ namespace esp32m {
         doc = new (std::nothrow) JsonDocument(ds);
       if (!doc)
         return nullptr;*/
+#if CONFIG_ESP32M_HEAP_SITES
+      auto doc =
+          new JsonDocument(debug::heap::allocator(debug::heap::Site::JsonParse));
+#else
       auto doc = new JsonDocument();
+#endif
       auto r = deserializeJson(*doc, data, len);
       if (r == DeserializationError::Ok) {
         doc->shrinkToFit();
@@ -278,5 +284,142 @@ namespace esp32m {
       return std::unique_ptr<JsonDocument>(doc);
     }
 
+    size_t Writer::write(const uint8_t *buf, size_t size) {
+      if (!_ok)
+        return 0;
+      size_t written = _out.write(buf, size);
+      if (written != size)
+        _ok = false;
+      return written;
+    }
+
+    void Writer::separate() {
+      if (_keyed) {
+        _keyed = false;
+        return;
+      }
+      if (!_depth)
+        return;
+      uint32_t bit = 1u << ((_depth - 1) & 31);
+      if (_filled & bit)
+        write(',');
+      else
+        _filled |= bit;
+    }
+
+    void Writer::open(char c) {
+      separate();
+      write(c);
+      _filled &= ~(1u << (_depth & 31));
+      _depth++;
+    }
+
+    void Writer::close(char c) {
+      if (_depth)
+        _depth--;
+      write(c);
+    }
+
+    void Writer::beginObject() {
+      open('{');
+    }
+    void Writer::endObject() {
+      close('}');
+    }
+    void Writer::beginArray() {
+      open('[');
+    }
+    void Writer::endArray() {
+      close(']');
+    }
+
+    void Writer::key(const char *name) {
+      separate();
+      string(name);
+      write(':');
+      _keyed = true;
+    }
+
+    void Writer::value(JsonVariantConst v) {
+      separate();
+      serializeJson(v, *this);
+    }
+
+    void Writer::value(const char *v) {
+      separate();
+      if (v)
+        string(v);
+      else
+        write((const uint8_t *)"null", 4);
+    }
+
+    void Writer::value(std::nullptr_t) {
+      literal("null");
+    }
+
+    void Writer::literal(const char *s) {
+      separate();
+      write((const uint8_t *)s, strlen(s));
+    }
+
+    void Writer::string(const char *s) {
+      write('"');
+      // copy runs of plain characters in one go, escape the rest
+      const char *run = s;
+      for (; *s; s++) {
+        uint8_t c = *s;
+        if (c >= 0x20 && c != '"' && c != '\\')
+          continue;
+        write((const uint8_t *)run, s - run);
+        run = s + 1;
+        char esc[7];
+        switch (c) {
+          case '"':
+          case '\\':
+            esc[0] = '\\';
+            esc[1] = c;
+            esc[2] = 0;
+            break;
+          case '\n':
+            strcpy(esc, "\\n");
+            break;
+          case '\r':
+            strcpy(esc, "\\r");
+            break;
+          case '\t':
+            strcpy(esc, "\\t");
+            break;
+          default:
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            break;
+        }
+        write((const uint8_t *)esc, strlen(esc));
+      }
+      write((const uint8_t *)run, s - run);
+      write('"');
+    }
+
+    void Writer::number(int64_t v) {
+      char buf[24];
+      separate();
+      write((const uint8_t *)buf, snprintf(buf, sizeof(buf), "%lld", (long long)v));
+    }
+
+    void Writer::number(uint64_t v) {
+      char buf[24];
+      separate();
+      write((const uint8_t *)buf, snprintf(buf, sizeof(buf), "%llu", (unsigned long long)v));
+    }
+
+    void Writer::number(double v) {
+      if (isnan(v) || isinf(v)) {
+        literal("null");
+        return;
+      }
+      char buf[32];
+      separate();
+      write((const uint8_t *)buf, snprintf(buf, sizeof(buf), "%.9g", v));
+    }
+
   }  // namespace json
 }  // namespace esp32m
\ No newline at end of file
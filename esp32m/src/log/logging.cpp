@@ -1,5 +1,6 @@
 #include "esp32m/logging.hpp"
 #include "esp32m/base.hpp"
+#include "esp32m/debug/heap.hpp"
 #include "esp32m/net/ota.hpp"
 
 #include <esp_rom_serial_output.h>
@@ -103,6 +104,7 @@ namespace esp32m {
       if (tl > 255)
         tl = 255;
       auto size = sizeof(LogMessage) + nl + ml + tl;
+      debug::heap::track(debug::heap::Site::LogMessage, size);
       void* pool = malloc(size);
       return new (pool)
           LogMessage(size, level, stamp, task, tl, name, nl, message, ml);
@@ -5,25 +5,300 @@
 #include <string.h>
 #include <sys/stat.h>
 
+#include "esp32m/app.hpp"
 #include "esp32m/log/vfs.hpp"
 #include "esp32m/net/ota.hpp"
 
 namespace esp32m {
   namespace log {
+
+    // tag, id, length
+    const size_t NameRecordOverhead = 1 + 5 + 5;
+    // stamp record + tag, level, task id, name id, delta, length
+    const size_t MessageRecordOverhead = (1 + 10) + (1 + 1 + 5 + 5 + 10 + 5);
+
+    static size_t putVarint(uint8_t *out, uint64_t v) {
+      size_t n = 0;
+      do {
+        uint8_t b = v & 0x7f;
+        v >>= 7;
+        if (v)
+          b |= 0x80;
+        out[n++] = b;
+      } while (v);
+      return n;
+    }
+
+    Vfs::Vfs(const char *name, uint8_t maxFiles)
+        : Vfs(name, Options{.maxFiles = maxFiles}) {}
+
+    Vfs::Vfs(const char *name, const Options &options)
+        : _name(name), _options(options) {
+      if (_options.bufSize)
+        _options.bufSize = (_options.bufSize + BufAlign - 1) & ~(BufAlign - 1);
+      _sub = EventManager::instance().subscribe([this](Event &ev) {
+        // EventPeriodic is fired from the app task, so the time-based flush
+        // never runs in the context of the task that is logging
+        if (EventPeriodic::is(ev))
+          flush();
+        else if (EventDone::is(ev, nullptr)) {
+          // about to restart, the buffer must reach the file regardless of
+          // its age
+          std::lock_guard guard(_lock);
+          flushLocked();
+        }
+      });
+    }
+
+    Vfs::~Vfs() {
+      if (_sub)
+        delete _sub;
+      std::lock_guard guard(_lock);
+      flushLocked();
+      if (_file)
+        fclose(_file);
+      if (_buf)
+        free(_buf);
+    }
+
+    void Vfs::flush() {
+      if (!xPortCanYield())
+        return;
+      if (net::ota::isRunning())
+        return;
+      std::lock_guard guard(_lock);
+      if (_bufUsed && millis() - _bufStamp >= _options.flushInterval)
+        flushLocked();
+    }
+
+    bool Vfs::append(const LogMessage *message) {
+      if (_options.format == Format::Binary)
+        return appendBinary(message);
+      std::lock_guard guard(_lock);
+      _urgent = message && message->level() != Level::None &&
+                message->level() <= _options.flushLevel;
+      auto result = FormattingAppender::append(message);
+      _urgent = false;
+      return result;
+    }
+
     bool Vfs::append(const char *message) {
       if (!xPortCanYield())  // called from ISR
         return false;
       if (net::ota::isRunning())
         return false;
-      bool result = false;
-      std::lock_guard<std::mutex> guard(_lock);
+      std::lock_guard guard(_lock);
+      if (!open())
+        return false;
+      if (!message)
+        return true;
+      auto len = strlen(message);
+      if (_options.maxFiles > 1 && shouldRotate(_bufUsed + len + 1)) {
+        flushLocked();
+        rotate();
+      }
+      if (_options.bufSize && !_buf) {
+        _buf = (char *)malloc(_options.bufSize);
+        if (!_buf)
+          _options.bufSize = 0;
+      }
+      bool result;
+      if (!_buf || len + 1 > _options.bufSize) {
+        // unbuffered, or the line doesn't fit into the buffer at all
+        result = flushLocked() && write(message, len) && write("\n", 1);
+        if (_file)
+          fflush(_file);
+      } else {
+        result = true;
+        if (_bufUsed + len + 1 > _options.bufSize)
+          result = flushLocked();
+        if (!_bufUsed)
+          _bufStamp = millis();
+        memcpy(_buf + _bufUsed, message, len);
+        _buf[_bufUsed + len] = '\n';
+        _bufUsed += len + 1;
+        if (_urgent || millis() - _bufStamp >= _options.flushInterval)
+          result = flushLocked() && result;
+      }
+      return result;
+    }
+
+    bool Vfs::appendBinary(const LogMessage *message) {
+      if (!xPortCanYield())  // called from ISR
+        return false;
+      if (net::ota::isRunning())
+        return false;
+      std::lock_guard guard(_lock);
+      if (!open())
+        return false;
+      if (!message)
+        return true;
+      // upper bound of the encoded size, names are only defined once per file
+      size_t bound = MessageRecordOverhead + message->messagelen();
+      if (_ids.find(std::string_view(message->task(), message->tasklen())) ==
+          _ids.end())
+        bound += NameRecordOverhead + message->tasklen();
+      if (_ids.find(std::string_view(message->name(), message->namelen())) ==
+          _ids.end())
+        bound += NameRecordOverhead + message->namelen();
+      if (_options.maxFiles > 1 && shouldRotate(_bufUsed + bound)) {
+        flushLocked();
+        rotate();
+        if (!_file)
+          return false;
+        bound += 2 * NameRecordOverhead + message->tasklen() +
+                 message->namelen();
+      }
+      if (_options.bufSize && !_buf) {
+        _buf = (char *)malloc(_options.bufSize);
+        if (!_buf)
+          _options.bufSize = 0;
+      }
+      bool urgent = message->level() != Level::None &&
+                    message->level() <= _options.flushLevel;
+      bool result = true;
+      if (_buf && bound <= _options.bufSize) {
+        if (_bufUsed + bound > _options.bufSize)
+          result = flushLocked();
+        if (!_bufUsed)
+          _bufStamp = millis();
+        // encode straight into the buffer, no per-message allocation
+        _bufUsed += encode(message, (uint8_t *)_buf + _bufUsed);
+        if (urgent || millis() - _bufStamp >= _options.flushInterval)
+          result = flushLocked() && result;
+      } else {
+        auto tmp = (uint8_t *)malloc(bound);
+        if (!tmp)
+          return false;
+        auto size = encode(message, tmp);
+        result = flushLocked() && write((const char *)tmp, size);
+        if (_file)
+          fflush(_file);
+        free(tmp);
+      }
+      return result;
+    }
+
+    uint32_t Vfs::intern(const char *name, size_t len, uint8_t *&out) {
+      std::string_view key(name, len);
+      auto it = _ids.find(key);
+      if (it != _ids.end())
+        return it->second;
+      uint32_t id = _ids.size();
+      _ids.emplace(key, id);
+      *out++ = RecName;
+      out += putVarint(out, id);
+      out += putVarint(out, len);
+      memcpy(out, name, len);
+      out += len;
+      return id;
+    }
+
+    size_t Vfs::encode(const LogMessage *message, uint8_t *out) {
+      uint8_t *p = out;
+      auto task = intern(message->task(), message->tasklen(), p);
+      auto name = intern(message->name(), message->namelen(), p);
+      // positive stamps are uptime, negative - wall clock, see LogMessage
+      int64_t stamp = message->stamp();
+      int64_t abs = stamp < 0 ? -stamp : stamp;
+      int64_t prev = _lastStamp < 0 ? -_lastStamp : _lastStamp;
+      uint64_t delta = 0;
+      if (!_hasStamp || (stamp < 0) != (_lastStamp < 0) || abs < prev) {
+        *p++ = RecStamp;
+        p += putVarint(p, ((uint64_t)stamp << 1) ^ (uint64_t)(stamp >> 63));
+      } else
+        delta = abs - prev;
+      _lastStamp = stamp;
+      _hasStamp = true;
+      size_t len = message->messagelen();
+      if (len)
+        len--;  // null terminator
+      *p++ = RecMessage;
+      *p++ = message->level();
+      p += putVarint(p, task);
+      p += putVarint(p, name);
+      p += putVarint(p, delta);
+      p += putVarint(p, len);
+      memcpy(p, message->message(), len);
+      p += len;
+      return p - out;
+    }
+
+    bool Vfs::open() {
+      if (_file)
+        return true;
+      // the only place we ask the file system for the size
+      struct stat st;
+      _fileSize = stat(_name, &st) == 0 ? st.st_size : 0;
+      if (_fileSize && !formatMatches()) {
+        // readers tell the formats apart by the header only, so records of
+        // one format must never follow the other
+        rotate();
+        return _file != nullptr;
+      }
+      _file = fopen(_name, "a");
+      if (!_file)
+        return false;
+      return started();
+    }
+
+    bool Vfs::formatMatches() {
+      FILE *file = fopen(_name, "r");
+      if (!file)
+        return true;
+      char magic[4];
+      bool binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                    !memcmp(magic, BinaryMagic, sizeof(magic));
+      fclose(file);
+      return binary == (_options.format == Format::Binary);
+    }
+
+    bool Vfs::started() {
+      if (_options.format != Format::Binary)
+        return true;
+      // ids are per file, names will be defined again on first use
+      _ids.clear();
+      _hasStamp = false;
+      if (_fileSize)
+        return true;
+      uint8_t header[5];
+      memcpy(header, BinaryMagic, 4);
+      header[4] = BinaryVersion;
+      return write((const char *)header, sizeof(header));
+    }
+
+    bool Vfs::write(const char *data, size_t size) {
       if (!_file)
-        _file = fopen(_name, "a");
-      if (_file && _maxFiles > 1 && shouldRotate()) {
-        auto rn = strlen(_name) + 1 + 3 + 1;
-        char *a = (char *)malloc(rn), *b = (char *)malloc(rn);
+        return false;
+      auto written = fwrite(data, 1, size, _file);
+      _fileSize += written;
+      return written == size;
+    }
+
+    bool Vfs::flushLocked() {
+      if (!_bufUsed)
+        return true;
+      if (!open())
+        return false;
+      auto result = write(_buf, _bufUsed);
+      fflush(_file);
+      _bufUsed = 0;
+      return result;
+    }
+
+    bool Vfs::shouldRotate(size_t pending) {
+      return _fileSize && _fileSize + pending > _options.maxFileSize;
+    }
+
+    void Vfs::rotate() {
+      if (_file) {
         fclose(_file);
-        for (auto i = _maxFiles - 2; i >= 0; i--) {
+        _file = nullptr;
+      }
+      auto rn = strlen(_name) + 1 + 3 + 1;
+      char *a = (char *)malloc(rn), *b = (char *)malloc(rn);
+      if (a && b)
+        for (auto i = _options.maxFiles - 2; i >= 0; i--) {
           if (i)
             sprintf(a, "%s.%d", _name, i);
           else
@@ -36,21 +311,12 @@ namespace esp32m {
             rename(a, b);
           }
         }
-        free(a);
-        free(b);
-        _file = fopen(_name, "a");
-      }
-      if (_file) {
-        result = !message || fprintf(_file, "%s\n", message) > 0;
-        if (result)
-          fflush(_file);
-      }
-      return result;
-    }
-
-    bool Vfs::shouldRotate() {
-      struct stat st;
-      return (stat(_name, &st) == 0 && st.st_size > 8192);
+      free(a);
+      free(b);
+      _file = fopen(_name, "w");
+      _fileSize = 0;
+      if (_file)
+        started();
     }
   }  // namespace log
 }  // namespace esp32m
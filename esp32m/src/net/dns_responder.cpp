@@ -0,0 +1,157 @@
+#include "esp32m/net/dns_responder.hpp"
+
+#include <string.h>
+#include <algorithm>
+
+namespace esp32m {
+  namespace net {
+
+    namespace dns {
+      const size_t HeaderSize = 12;
+      const size_t MaxNameLength = 255;
+
+      // byte 2 of the header
+      const uint8_t FlagQR = 1 << 7;
+      const uint8_t OpcodeMask = 0xf << 3;
+      const uint8_t FlagAA = 1 << 2;
+      const uint8_t FlagTC = 1 << 1;
+      const uint8_t FlagRD = 1 << 0;
+
+      // byte 3 of the header
+      const uint8_t RcodeNoError = 0;
+      const uint8_t RcodeNxDomain = 3;
+
+      const uint16_t TypeA = 1;
+      const uint16_t TypeAAAA = 28;
+      const uint16_t TypeSVCB = 64;
+      const uint16_t TypeHTTPS = 65;
+
+      const uint16_t ClassIN = 1;
+      const uint16_t ClassAny = 255;
+
+      inline uint16_t get16(const uint8_t *p) {
+        return (p[0] << 8) | p[1];
+      }
+
+      inline void set16(uint8_t *p, uint16_t n) {
+        p[0] = n >> 8;
+        p[1] = n & 0xff;
+      }
+
+      inline void set32(uint8_t *p, uint32_t n) {
+        p[0] = n >> 24;
+        p[1] = (n >> 16) & 0xff;
+        p[2] = (n >> 8) & 0xff;
+        p[3] = n & 0xff;
+      }
+
+    }  // namespace dns
+
+    DnsResponder::DnsResponder(esp_ip4_addr_t ip, uint32_t ttl) {
+      // the name is a pointer to the question, which always follows the header
+      dns::set16(_answer, 0xc000 | dns::HeaderSize);
+      dns::set16(_answer + 2, dns::TypeA);
+      dns::set16(_answer + 4, dns::ClassIN);
+      dns::set32(_answer + 6, ttl);
+      dns::set16(_answer + 10, 4);
+      setAddress(ip);
+    }
+
+    void DnsResponder::setAddress(esp_ip4_addr_t ip) {
+      _answer[12] = esp_ip4_addr1(&ip);
+      _answer[13] = esp_ip4_addr2(&ip);
+      _answer[14] = esp_ip4_addr3(&ip);
+      _answer[15] = esp_ip4_addr4(&ip);
+    }
+
+    size_t DnsResponder::respond(const uint8_t *query, size_t len,
+                                 uint8_t *reply) const {
+      if (len < dns::HeaderSize || len > MaxPacket)
+        return 0;
+      uint8_t flags = query[2];
+      // replies, truncated queries and anything but the standard query
+      if (flags & (dns::FlagQR | dns::FlagTC | dns::OpcodeMask))
+        return 0;
+      // EDNS puts OPT into the additional section, it is simply not echoed
+      if (dns::get16(query + 4) != 1 || dns::get16(query + 6) ||
+          dns::get16(query + 8))
+        return 0;
+      // walk the name without copying it, compression is not expected here
+      size_t pos = dns::HeaderSize;
+      for (;;) {
+        if (pos >= len)
+          return 0;
+        uint8_t l = query[pos];
+        if (l == 0) {
+          pos++;
+          break;
+        }
+        if (l & 0xc0)
+          return 0;
+        pos += l + 1;
+        if (pos - dns::HeaderSize > dns::MaxNameLength)
+          return 0;
+      }
+      if (pos + 4 > len)
+        return 0;
+      uint16_t type = dns::get16(query + pos);
+      uint16_t clazz = dns::get16(query + pos + 2);
+      pos += 4;
+
+      bool answer = false;
+      uint8_t rcode = dns::RcodeNoError;
+      if (clazz == dns::ClassIN || clazz == dns::ClassAny)
+        switch (type) {
+          case dns::TypeA:
+            answer = true;
+            break;
+          case dns::TypeAAAA:
+          case dns::TypeSVCB:
+          case dns::TypeHTTPS:
+            rcode = dns::RcodeNxDomain;
+            break;
+        }
+
+      memcpy(reply, query, pos);
+      reply[2] = dns::FlagQR | dns::FlagAA | (flags & dns::FlagRD);
+      reply[3] = rcode;
+      dns::set16(reply + 6, answer ? 1 : 0);
+      dns::set16(reply + 10, 0);
+      if (answer) {
+        memcpy(reply + pos, _answer, sizeof(_answer));
+        pos += sizeof(_answer);
+      }
+      return pos;
+    }
+
+    bool DnsRateLimiter::allow(uint32_t addr, uint32_t now) {
+      const uint32_t cost = 1000, max = _burst * cost;
+      Client *client = nullptr, *oldest = &_clients[0];
+      for (auto &c : _clients) {
+        if (c.addr == addr) {
+          client = &c;
+          break;
+        }
+        if (!c.addr || (oldest->addr && now - c.stamp > now - oldest->stamp))
+          oldest = &c;
+      }
+      if (client) {
+        uint32_t elapsed = now - client->stamp;
+        if (elapsed >= _burst * cost / _rate)
+          client->tokens = max;
+        else
+          client->tokens = std::min(max, client->tokens + elapsed * _rate);
+      } else {
+        client = oldest;
+        client->addr = addr;
+        client->tokens = max;
+      }
+      client->stamp = now;
+      if (client->tokens < cost)
+        return false;
+      client->tokens -= cost;
+      return true;
+    }
+
+  }  // namespace net
+}  // namespace esp32m
@@ -119,6 +119,7 @@ namespace esp32m {
     void Ethernet::handleEvent(Event &ev) {
       Device::handleEvent(ev);
       EthEvent *eth;
+      EventInit *init;
       if (EthEvent::is(ev, &eth) && eth->handle() == _handle) {
         eth->claim(this);
         switch (eth->event()) {
@@ -141,8 +142,13 @@ namespace esp32m {
           default:
             break;
         }
-      } else if (EventInit::is(ev, 0)) {
-        ensureReady();
+      } else if (EventInit::is(ev, 0, &init)) {
+        // netif and event loop are set up on the main thread, driver install
+        // and PHY reset take a while and may run in parallel with others
+        ESP_ERROR_CHECK_WITHOUT_ABORT(useNetif());
+        ESP_ERROR_CHECK_WITHOUT_ABORT(useEventLoop());
+        init->defer(name(),
+                    [this] { ESP_ERROR_CHECK_WITHOUT_ABORT(ensureReady()); });
       } else if (EventPropChanged::is(ev, "app", "hostname")) {
         updateHostname();
       }
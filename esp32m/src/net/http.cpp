@@ -1,4 +1,6 @@
 #include "esp32m/net/http.hpp"
+#include <string.h>
+#include <algorithm>
 #include <map>
 #include <esp_crt_bundle.h>
 #include "esp32m/defs.hpp"
@@ -8,6 +10,10 @@ namespace esp32m {
   namespace net {
     namespace http {
 
+      // not all IDF versions define these in HttpStatus_Code
+      static constexpr int StatusPartialContent = 206;
+      static constexpr int StatusNotModified = 304;
+
       static bool shouldRedirect(int status_code) {
         switch (status_code) {
           case HttpStatus_MovedPermanently:
@@ -22,6 +28,45 @@ namespace esp32m {
         return false;
       }
 
+      /**
+       * Growable in-memory sink, used when the caller wants the whole body
+       */
+      class MemoryWriter : public stream::Writer {
+       public:
+        ~MemoryWriter() {
+          if (_buf)
+            free(_buf);
+        }
+        bool reserve(size_t capacity) {
+          if (capacity <= _capacity)
+            return true;
+          auto buf = (uint8_t*)realloc(_buf, capacity);
+          if (!buf)
+            return false;
+          _buf = buf;
+          _capacity = capacity;
+          return true;
+        }
+        size_t write(const uint8_t* buf, size_t size) override {
+          if (_size + size > _capacity &&
+              !reserve(std::max(_size + size, _capacity * 2)))
+            return 0;
+          memcpy(_buf + _size, buf, size);
+          _size += size;
+          return size;
+        }
+        void* release() {
+          auto buf = _buf;
+          _buf = nullptr;
+          _size = _capacity = 0;
+          return buf;
+        }
+
+       private:
+        uint8_t* _buf = nullptr;
+        size_t _size = 0, _capacity = 0;
+      };
+
       class Session {
        public:
         esp_http_client_config_t config = {};
@@ -37,13 +82,31 @@ namespace esp32m {
             _client = nullptr;
           }
         }
-        esp_err_t start() {
+        esp_err_t start(const ResourceStreamOptions* options = nullptr) {
           if (!_client)
             _client = esp_http_client_init(&config);
           auto& errors = _request->errors();
           if (!_client)
             return errors.check(ESP_ERR_NO_MEM);
+          if (options) {
+            _conditional =
+                !options->etag.empty() || !options->lastModified.empty();
+            if (!options->etag.empty())
+              esp_http_client_set_header(_client, "If-None-Match",
+                                         options->etag.c_str());
+            if (!options->lastModified.empty())
+              esp_http_client_set_header(_client, "If-Modified-Since",
+                                         options->lastModified.c_str());
+            if (options->offset) {
+              auto range = string_printf("bytes=%u-", options->offset);
+              esp_http_client_set_header(_client, "Range", range.c_str());
+              if (!options->ifRange.empty())
+                esp_http_client_set_header(_client, "If-Range",
+                                           options->ifRange.c_str());
+            }
+          }
           do {
+            headers.clear();
             ESP_CHECK_RETURN(errors.check(esp_http_client_open(_client, 0)));
             _opened = true;
             contentLength = esp_http_client_fetch_headers(_client);
@@ -52,28 +115,77 @@ namespace esp32m {
           } while (_redurecting);
           return ESP_OK;
         }
+        bool notModified() const {
+          return status == StatusNotModified;
+        }
+        const char* header(const char* name) const {
+          for (auto const& kv : headers)
+            if (!strcasecmp(kv.first.c_str(), name))
+              return kv.second.c_str();
+          return nullptr;
+        }
+        /**
+         * Reads the body into the sink in chunks, until the server signals
+         * the end of data (either Content-Length is reached or the last chunk
+         * of a chunked response is received)
+         */
+        esp_err_t pipe(stream::Writer& sink, size_t chunkSize,
+                       size_t& received) {
+          auto& errors = _request->errors();
+          received = 0;
+          if (!chunkSize)
+            chunkSize = 1024;
+          char* buf = (char*)malloc(chunkSize);
+          if (!buf)
+            return errors.check(ESP_ERR_NO_MEM, "failed to allocate %d bytes",
+                                chunkSize);
+          esp_err_t err = ESP_OK;
+          for (;;) {
+            int r = esp_http_client_read(_client, buf, chunkSize);
+            if (r < 0) {
+              err = errors.fail("read error %d after %d bytes", r, received);
+              break;
+            }
+            if (r == 0)
+              break;
+            if (sink.write((const uint8_t*)buf, r) != r) {
+              err = errors.fail("sink rejected data at %d", received);
+              break;
+            }
+            received += r;
+          }
+          free(buf);
+          // responses delimited by connection close can't be validated
+          bool delimited = contentLength > 0 ||
+                           esp_http_client_is_chunked_response(_client);
+          if (err == ESP_OK && delimited &&
+              !esp_http_client_is_complete_data_received(_client))
+            err = errors.fail("incomplete response: %d of %lld bytes", received,
+                              contentLength);
+          if (err == ESP_OK)
+            logd("%d bytes received from %s", received, config.url);
+          return err;
+        }
         Resource* read() {
-          Resource* resource = nullptr;
           auto& errors = _request->errors();
-          if (contentLength > 0) {
-            char* buf = (char*)malloc(
-                contentLength + (_request->options.addNullTerminator ? 1 : 0));
-            if (buf) {
-              int read_len = esp_http_client_read(_client, buf, contentLength);
-              if (read_len > 0) {
-                logd("%d bytes received from %s", read_len, config.url);
-                resource = new Resource(config.url);
-                if (_request->options.addNullTerminator)
-                  buf[read_len] = 0;
-                resource->setData(buf, read_len);
-                resource->setMeta(headersToJson());
-              } else {
-                free(buf);
-                errors.check(ESP_FAIL);
-              }
-            } else
-              errors.check(ESP_ERR_NO_MEM);
+          bool nt = _request->options.addNullTerminator;
+          MemoryWriter sink;
+          if (contentLength > 0 &&
+              !sink.reserve(contentLength + (nt ? 1 : 0))) {
+            errors.check(ESP_ERR_NO_MEM, "failed to allocate %lld bytes",
+                         contentLength);
+            return nullptr;
+          }
+          size_t received;
+          if (pipe(sink, 1024, received) != ESP_OK || !received)
+            return nullptr;
+          if (nt && sink.write((const uint8_t*)"", 1) != 1) {
+            errors.check(ESP_ERR_NO_MEM);
+            return nullptr;
           }
+          auto resource = new Resource(config.url);
+          resource->setData(sink.release(), received);
+          resource->setMeta(headersToJson());
           return resource;
         }
         esp_err_t handle(esp_http_client_event_t* evt) {
@@ -115,12 +227,15 @@ namespace esp32m {
        private:
         bool _opened = false;
         bool _redurecting = false;
+        bool _conditional = false;
         UrlResourceRequest* _request;
         esp_http_client_handle_t _client = nullptr;
         esp_err_t handleStatus() {
           _redurecting = false;
           if ((status / 100) == 2)
             return ESP_OK;
+          if (_conditional && status == StatusNotModified)
+            return ESP_OK;
           auto& errors = _request->errors();
           if (shouldRedirect(status)) {
             ESP_CHECK_RETURN(
@@ -188,6 +303,40 @@ namespace esp32m {
         return session.read();
       };
 
+      esp_err_t Client::stream(ResourceRequest& req, stream::Writer& sink,
+                               const ResourceStreamOptions& options,
+                               ResourceStreamResult& result) {
+        UrlResourceRequest* urr;
+        if (!check(req, &urr))
+          return ESP_ERR_NOT_SUPPORTED;
+        auto& errors = req.errors();
+        Session session(urr);
+        ESP_CHECK_RETURN(session.start(&options));
+        result = {};
+        result.size = session.contentLength;
+        auto etag = session.header("ETag");
+        if (etag)
+          result.etag = etag;
+        auto lm = session.header("Last-Modified");
+        if (lm)
+          result.lastModified = lm;
+        if (session.notModified()) {
+          result.notModified = true;
+          return ESP_OK;
+        }
+        // the server may ignore Range and send the whole entity with 200
+        if (session.status == StatusPartialContent)
+          result.offset = options.offset;
+        else if (options.offset)
+          result.restarted = true;
+        auto err = sink.begin(result.offset);
+        if (err == ESP_ERR_INVALID_SIZE)
+          result.restarted = true;
+        ESP_CHECK_RETURN(
+            errors.check(err, "sink can't start at %d", result.offset));
+        return session.pipe(sink, options.chunkSize, result.received);
+      }
+
     }  // namespace http
   }    // namespace net
 }  // namespace esp32m
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "esp32m/app.hpp"
 #include "esp32m/base.hpp"
+#include "esp32m/debug/heap.hpp"
 #include "esp32m/device.hpp"
 #include "esp32m/events.hpp"
 #include "esp32m/events/broadcast.hpp"
@@ -440,6 +441,8 @@ namespace esp32m {
         case MQTT_EVENT_UNSUBSCRIBED:
           break;
         case MQTT_EVENT_DATA: {
+          debug::heap::track(debug::heap::Site::MqttIncoming,
+                             event->topic_len + event->data_len);
           std::string topic = std::string(event->topic, event->topic_len);
           std::string payload = std::string(event->data, event->data_len);
           _recvcnt++;
@@ -464,30 +467,6 @@ namespace esp32m {
       return 0;
     }
 
-    bool mqttTopicMatchesFilter(const std::string& filter,
-                                const std::string& topic) {
-      size_t fi = 0, ti = 0;
-      while (fi < filter.size() && ti < topic.size()) {
-        if (filter[fi] == '#') {
-          return fi + 1 == filter.size();
-        } else if (filter[fi] == '+') {
-          // Skip to next level
-          while (ti < topic.size() && topic[ti] != '/') ti++;
-          fi++;
-          if (ti < topic.size() && topic[ti] == '/')
-            ti++;
-          if (fi < filter.size() && filter[fi] == '/')  // ← Add this
-            fi++;
-        } else {
-          if (filter[fi] != topic[ti])
-            return false;
-          fi++;
-          ti++;
-        }
-      }
-      return fi == filter.size() && ti == topic.size();
-    }
-
     std::vector<HandlerFunction> Mqtt::findMatchingHandlers(std::string topic) {
       std::lock_guard guard(_mutex);
       std::vector<HandlerFunction> handlers;
@@ -0,0 +1,31 @@
+#include "esp32m/net/mqtt_topic.hpp"
+
+namespace esp32m {
+  namespace net {
+
+    bool mqttTopicMatchesFilter(const std::string& filter,
+                                const std::string& topic) {
+      size_t fi = 0, ti = 0;
+      while (fi < filter.size() && ti < topic.size()) {
+        if (filter[fi] == '#') {
+          return fi + 1 == filter.size();
+        } else if (filter[fi] == '+') {
+          // Skip to next level
+          while (ti < topic.size() && topic[ti] != '/') ti++;
+          fi++;
+          if (ti < topic.size() && topic[ti] == '/')
+            ti++;
+          if (fi < filter.size() && filter[fi] == '/')  // ← Add this
+            fi++;
+        } else {
+          if (filter[fi] != topic[ti])
+            return false;
+          fi++;
+          ti++;
+        }
+      }
+      return fi == filter.size() && ti == topic.size();
+    }
+
+  }  // namespace net
+}  // namespace esp32m
\ No newline at end of file
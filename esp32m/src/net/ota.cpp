@@ -7,6 +7,7 @@
 
 #include "esp32m/app.hpp"
 #include "esp32m/base.hpp"
+#include "esp32m/debug/trace.hpp"
 #include "esp32m/events.hpp"
 #include "esp32m/events/broadcast.hpp"
 #include "esp32m/events/response.hpp"
@@ -409,7 +410,10 @@ namespace esp32m {
       if (ESP_ERROR_CHECK_WITHOUT_ABORT(err) == ESP_OK) {
         stage = "perform";
         while (1) {
-          err = esp_https_ota_perform(https_ota_handle);
+          {
+            debug::trace::Span span("ota-chunk");
+            err = esp_https_ota_perform(https_ota_handle);
+          }
           if (err != ESP_ERR_HTTPS_OTA_IN_PROGRESS)
             break;
           if (!_total || _httpClient)
@@ -543,6 +547,7 @@ namespace esp32m {
           } else {
             int received;
             while ((received = httpd_req_recv(req, buf, bufSize)) > 0) {
+              debug::trace::Span span("ota-chunk");
               err = esp_ota_write(otaHandle, buf, (size_t)received);
               if (err != ESP_OK)
                 break;
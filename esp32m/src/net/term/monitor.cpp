@@ -11,10 +11,17 @@ namespace esp32m {
   namespace net {
     namespace term {
 
-      struct LineItem {
-        size_t len;
-        char data[1];
-      };
+      // length + null terminator
+      static constexpr size_t RecordOverhead = sizeof(uint16_t) + 1;
+      // record length that tells readers to continue at the ring start
+      static constexpr uint16_t WrapMarker = 0xffff;
+
+      void IConsumer::gap(size_t lost) {
+        char marker[48];
+        auto len = snprintf(marker, sizeof(marker), "[... %u bytes lost ...]",
+                            (unsigned)lost);
+        consume(std::string_view(marker, len));
+      }
 
       class Monitor::RxTap : public IRxTap {
        public:
@@ -35,9 +42,11 @@ namespace esp32m {
       }
 
       Monitor::Monitor() {
-        _queue = xQueueCreate(64, sizeof(LineItem*));
-        if (!_queue) {
-          logE("failed to create queue");
+        _ring = (uint8_t*)malloc(_ringSize);
+        _line = (char*)malloc(_maxLineLen);
+        _scratch = (char*)malloc(_maxLineLen + 1);
+        if (!_ring || !_line || !_scratch) {
+          logE("failed to allocate %d bytes for the ring", _ringSize);
           return;
         }
 
@@ -50,84 +59,97 @@ namespace esp32m {
       }
 
       void Monitor::add(IConsumer& consumer) {
-        std::lock_guard<std::mutex> guard(_consumersMutex);
-        if (std::find(_consumers.begin(), _consumers.end(), &consumer) ==
-            _consumers.end()) {
-          _consumers.push_back(&consumer);
-        }
+        std::lock_guard<std::mutex> guard(_mutex);
+        for (auto& r : _readers)
+          if (r.consumer == &consumer)
+            return;
+        // new consumers only see lines received from now on
+        _readers.push_back({&consumer, _head});
       }
 
       void Monitor::remove(IConsumer& consumer) {
-        std::lock_guard<std::mutex> guard(_consumersMutex);
-        auto it = std::remove(_consumers.begin(), _consumers.end(), &consumer);
-        _consumers.erase(it, _consumers.end());
+        std::lock_guard<std::mutex> dispatching(_dispatchMutex);
+        std::lock_guard<std::mutex> guard(_mutex);
+        auto it = std::remove_if(
+            _readers.begin(), _readers.end(),
+            [&](const Reader& r) { return r.consumer == &consumer; });
+        _readers.erase(it, _readers.end());
       }
 
-      void Monitor::enqueueLine(const char* data, size_t len) {
-        if (!_queue)
-          return;
-
-        const size_t allocSize = sizeof(LineItem) + len + 1;
-        auto* item = (LineItem*)malloc(allocSize);
-        if (!item)
-          return;
+      uint32_t Monitor::skipPadding(uint32_t pos) const {
+        size_t off = pos % _ringSize;
+        size_t left = _ringSize - off;
+        if (left < sizeof(uint16_t) || recordLen(pos) == WrapMarker)
+          return pos + left;
+        return pos;
+      }
 
-        item->len = len;
-        if (len)
-          memcpy(item->data, data, len);
-        item->data[len] = 0;
+      uint16_t Monitor::recordLen(uint32_t pos) const {
+        uint16_t len;
+        memcpy(&len, _ring + pos % _ringSize, sizeof(len));
+        return len;
+      }
 
-        if (xQueueSend(_queue, &item, 0) != pdTRUE) {
-          free(item);
+      void Monitor::commitLine() {
+        const size_t size = RecordOverhead + _lineLen;
+        {
+          std::lock_guard<std::mutex> guard(_mutex);
+          size_t off = _head % _ringSize;
+          size_t left = _ringSize - off;
+          // keep records contiguous so consumers get a single span
+          uint32_t start = left < size ? _head + left : _head;
+          // drop the oldest records until the new one fits
+          while (_tail != _head && start + size - _tail > _ringSize) {
+            uint32_t pos = skipPadding(_tail);
+            if (pos != _tail)
+              _tail = pos;
+            else
+              _tail += RecordOverhead + recordLen(_tail);
+          }
+          if (start != _head && left >= sizeof(uint16_t))
+            memcpy(_ring + off, &WrapMarker, sizeof(WrapMarker));
+          uint8_t* p = _ring + start % _ringSize;
+          uint16_t len = _lineLen;
+          memcpy(p, &len, sizeof(len));
+          if (_lineLen)
+            memcpy(p + sizeof(len), _line, _lineLen);
+          p[sizeof(len) + _lineLen] = 0;
+          _head = start + size;
         }
+        _lineLen = 0;
+        if (_dispatchTask)
+          xTaskNotifyGive(_dispatchTask);
       }
 
       void Monitor::ingest(const uint8_t* data, size_t len) {
-        if (!data || !len)
+        if (!data || !len || !_ring)
           return;
 
-        std::vector<std::string> ready;
-        ready.reserve(4);
+        for (size_t i = 0; i < len; i++) {
+          const char c = (char)data[i];
 
-        {
-          auto flush = [&]() {
-            // Preserve empty lines (can be meaningful in logs).
-            ready.emplace_back(std::move(_buf));
-            _buf.clear();
-          };
-
-          std::lock_guard<std::mutex> guard(_bufMutex);
-
-          for (size_t i = 0; i < len; i++) {
-            const char c = (char)data[i];
-
-            if (c == '\n') {
-              if (_lastWasCr) {
-                _lastWasCr = false;
-                continue;
-              }
-              flush();
-              continue;
-            }
-
-            if (c == '\r') {
-              flush();
-              _lastWasCr = true;
+          if (c == '\n') {
+            if (_lastWasCr) {
+              _lastWasCr = false;
               continue;
             }
+            // Preserve empty lines (can be meaningful in logs).
+            commitLine();
+            continue;
+          }
 
-            _lastWasCr = false;
+          if (c == '\r') {
+            commitLine();
+            _lastWasCr = true;
+            continue;
+          }
 
-            if (_buf.size() >= _maxLineLen) {
-              flush();
-            }
+          _lastWasCr = false;
 
-            _buf.push_back(c);
-          }
-        }
+          if (_lineLen >= _maxLineLen)
+            commitLine();
 
-        for (auto& line : ready) {
-          enqueueLine(line.data(), line.size());
+          _line[_lineLen++] = c;
         }
       }
 
@@ -166,31 +188,56 @@ namespace esp32m {
         vTaskDelete(nullptr);
       }
 
-      void Monitor::dispatchLoop() {
-        while (true) {
-          LineItem* item = nullptr;
-          if (!_queue ||
-              xQueueReceive(_queue, &item, portMAX_DELAY) != pdTRUE || !item)
+      bool Monitor::next(Reader& reader, size_t& lost, uint16_t& len) {
+        lost = 0;
+        // unsigned distances stay correct across counter wrap-around
+        if (_head - reader.cursor > _head - _tail) {
+          lost = _tail - reader.cursor;
+          reader.cursor = _tail;
+        }
+        while (reader.cursor != _head) {
+          uint32_t pos = skipPadding(reader.cursor);
+          if (pos != reader.cursor) {
+            reader.cursor = pos;
             continue;
-
-          std::string line(item->data, item->len);
-          free(item);
-          
-
-          std::vector<IConsumer*> consumers;
-          {
-            std::lock_guard<std::mutex> guard(_consumersMutex);
-            consumers = _consumers;
           }
+          len = recordLen(pos);
+          memcpy(_scratch, _ring + pos % _ringSize + sizeof(len), len);
+          _scratch[len] = 0;
+          reader.cursor += RecordOverhead + len;
+          return true;
+        }
+        return false;
+      }
 
-          for (size_t i = 0; i < consumers.size(); i++) {
-            auto* c = consumers[i];
-            if (!c)
-              continue;
-            if (i + 1 == consumers.size())
-              c->consume(std::move(line));
-            else
-              c->consume(line);
+      void Monitor::dispatchLoop() {
+        while (true) {
+          ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+          // one line per reader and turn; the ring is only locked to copy the
+          // line out, so a slow consumer never holds up commitLine()
+          for (bool more = true; more;) {
+            more = false;
+            for (size_t i = 0;; i++) {
+              std::lock_guard<std::mutex> dispatching(_dispatchMutex);
+              IConsumer* consumer;
+              size_t lost;
+              uint16_t len;
+              bool have;
+              {
+                std::lock_guard<std::mutex> guard(_mutex);
+                if (i >= _readers.size())
+                  break;
+                auto& reader = _readers[i];
+                consumer = reader.consumer;
+                have = next(reader, lost, len);
+              }
+              if (lost)
+                consumer->gap(lost);
+              if (have) {
+                consumer->consume(std::string_view(_scratch, len));
+                more = true;
+              }
+            }
           }
         }
       }
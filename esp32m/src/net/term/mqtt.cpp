@@ -8,14 +8,18 @@ namespace esp32m {
   namespace net {
     namespace term {
 
-      void MqttConsumer::consume(std::string line) {
+      void MqttConsumer::consume(std::string_view line) {
         auto& mqtt = net::Mqtt::instance();
         if (!mqtt.isReady() || line.empty())
           return;
 
-        auto topic =
-            string_printf("esp32m/%s/uart", App::instance().hostname());
-        mqtt.enqueue(topic.c_str(), line.c_str());
+        auto hostname = App::instance().hostname();
+        if (_hostname != hostname) {
+          _hostname = hostname;
+          _topic = string_printf("esp32m/%s/uart", hostname);
+        }
+        // lines from the monitor are null-terminated
+        mqtt.enqueue(_topic.c_str(), line.data());
       }
 
     }  // namespace term
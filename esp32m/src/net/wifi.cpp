@@ -14,15 +14,18 @@
 
 // #include <dhcpserver/dhcpserver.h>
 // #include <dhcpserver/dhcpserver_options.h>
+#include <esp_attr.h>
 #include <esp_mac.h>
 #include <esp_mbo.h>
 #include <esp_netif.h>
 #include <esp_netif_types.h>
+#include <esp_rom_crc.h>
 #include <esp_rrm.h>
 #include <esp_task_wdt.h>
 #include <esp_wnm.h>
 #include <esp_wps.h>
 #include <lwip/dns.h>
+#include <mbedtls/pkcs5.h>
 #include <algorithm>
 
 #include <sdkconfig.h>
@@ -43,8 +46,65 @@ namespace esp32m {
       ApRunning = BIT4,
       Scanning = BIT5,
       ScanDone = BIT6,
+      StaFailed = BIT7,
     };
 
+    // how long a directed connect to the cached BSSID may take, including DHCP
+    constexpr uint32_t FastConnectTimeout = 5000;
+
+    /**
+     * Last good association, survives deep sleep and software resets so that
+     * the next connect can skip the all-channel scan and the PMK derivation
+     */
+    struct RtcApCache {
+      uint32_t magic, magicInv;
+      uint32_t crc;  // of everything below
+      uint32_t apId;
+      uint32_t credentials;  // crc of ssid and password
+      uint8_t bssid[6];
+      uint8_t channel;
+      uint8_t hasPmk;
+      uint8_t pmk[32];
+    };
+
+    constexpr uint32_t RtcApCacheMagic = 0x57494643;  // "WIFC"
+    RTC_NOINIT_ATTR static RtcApCache s_apCache;
+
+    static uint32_t rtcApCacheCrc() {
+      auto start = (const uint8_t*)&s_apCache.apId;
+      return esp_rom_crc32_le(0, start,
+                              (const uint8_t*)(&s_apCache + 1) - start);
+    }
+
+    static bool rtcApCacheValid() {
+      return s_apCache.magic == RtcApCacheMagic &&
+             s_apCache.magicInv == ~RtcApCacheMagic &&
+             s_apCache.crc == rtcApCacheCrc();
+    }
+
+    static void rtcApCacheReset() {
+      memset(&s_apCache, 0, sizeof(s_apCache));
+    }
+
+    static uint32_t credentialsCrc(ApInfo* ap) {
+      auto ssid = ap->ssid();
+      auto password = ap->password();
+      auto crc = esp_rom_crc32_le(0, (const uint8_t*)ssid, strlen(ssid) + 1);
+      return esp_rom_crc32_le(crc, (const uint8_t*)password, strlen(password));
+    }
+
+    static bool derivePmk(ApInfo* ap, uint8_t* pmk) {
+      auto password = ap->password();
+      auto pl = strlen(password);
+      // open networks have no PMK, and a 64 character password already is one
+      if (pl < 8 || pl > 63)
+        return false;
+      auto ssid = ap->ssid();
+      return mbedtls_pkcs5_pbkdf2_hmac_ext(
+                 MBEDTLS_MD_SHA1, (const unsigned char*)password, pl,
+                 (const unsigned char*)ssid, strlen(ssid), 4096, 32, pmk) == 0;
+    }
+
     namespace wifi {
 
       Sta::Sta() {
@@ -689,6 +749,7 @@ namespace esp32m {
             _errReason = (wifi_err_reason_t)r->reason;
             xEventGroupClearBits(_eventGroup,
                                  WifiFlags::StaConnected | WifiFlags::StaGotIp);
+            xEventGroupSetBits(_eventGroup, WifiFlags::StaFailed);
             if (_errReason == WIFI_REASON_ROAMING) {
               _roaming = true;
               logI("roaming: leaving bssid=" MACSTR " rssi=%d",
@@ -956,7 +1017,7 @@ namespace esp32m {
       return changed;
     }
 
-    bool Wifi::tryConnect(ApInfo* ap, bool noBssid) {
+    bool Wifi::tryConnect(ApInfo* ap, bool noBssid, bool fast) {
       esp_task_wdt_reset();
       _sta.disconnect();
       if (_sta.enable(true) != ESP_OK) {
@@ -969,21 +1030,30 @@ namespace esp32m {
         strlcpy(reinterpret_cast<char*>(conf.sta.ssid), ssid,
                 sizeof(conf.sta.ssid));
 
-        conf.sta.scan_method = WIFI_ALL_CHANNEL_SCAN;
+        // the fast path goes straight to the last good BSSID on its channel
+        conf.sta.scan_method = fast ? WIFI_FAST_SCAN : WIFI_ALL_CHANNEL_SCAN;
         conf.sta.sort_method = WIFI_CONNECT_AP_BY_SIGNAL;
         conf.sta.threshold.authmode = WIFI_AUTH_WPA2_PSK;
 
-        const uint8_t* bssid = ap->bssid();
+        const uint8_t* bssid = fast ? s_apCache.bssid : ap->bssid();
         char bssidStr[net::MacMaxChars] = "any";
-        if (_channel)
-          conf.sta.channel = _channel;
-        if (bssid && !noBssid) {
+        uint8_t channel = fast ? s_apCache.channel : _channel;
+        if (channel)
+          conf.sta.channel = channel;
+        if (bssid && (fast || !noBssid)) {
           conf.sta.bssid_set = 1;
           memcpy((void*)&conf.sta.bssid[0], bssid, 6);
           sprintf(bssidStr, MACSTR, MAC2STR(bssid));
         }
         const char* password = ap->password();
-        if (password) {
+        if (fast && s_apCache.hasPmk) {
+          // saves the supplicant 4096 rounds of PBKDF2
+          static const char Hex[] = "0123456789abcdef";
+          for (size_t i = 0; i < sizeof(s_apCache.pmk); i++) {
+            conf.sta.password[i * 2] = Hex[s_apCache.pmk[i] >> 4];
+            conf.sta.password[i * 2 + 1] = Hex[s_apCache.pmk[i] & 0xf];
+          }
+        } else if (password) {
           if (strlen(password) == 64)  // it's not a passphrase, is the PSK
             memcpy(reinterpret_cast<char*>(conf.sta.password), password, 64);
           else
@@ -1017,23 +1087,22 @@ namespace esp32m {
         _sta.apply(errl);
         if (!errl.check(this))
           return false;
-        logI("connecting to %s [%s], channel %d", ssid, bssidStr,
-             (int)_channel);
+        logI("%s to %s [%s], channel %d",
+             fast ? "fast-connecting" : "connecting", ssid, bssidStr,
+             (int)channel);
       }
       _errReason = (wifi_err_reason_t)0;
+      xEventGroupClearBits(_eventGroup, WifiFlags::StaFailed);
       if (ESP_ERROR_CHECK_WITHOUT_ABORT(esp_wifi_connect()) != ESP_OK)
         return false;
-      int i = 30;
-      while (!isConnected() && --i) {
-        delay(100);
-        esp_task_wdt_reset();
-      }
-      i = 100;
-      while (!isConnected() && !_errReason && --i) {
-        delay(100);
-        esp_task_wdt_reset();
+      bool ok = fast ? waitConnected(0, FastConnectTimeout)
+                     : waitConnected(3000, 13000);
+      if (!ok && fast) {
+        logW("fast connect failed: %u, falling back to full scan",
+             (unsigned)_errReason);
+        rtcApCacheReset();
+        return false;
       }
-      bool ok = isConnected();
       if (!ok) {
         esp_netif_dhcp_status_t dhcpc = ESP_NETIF_DHCP_INIT;
         (void)esp_netif_dhcpc_get_status(_sta.handle(), &dhcpc);
@@ -1053,14 +1122,103 @@ namespace esp32m {
           delay(1000);
       }
       if (ap) {
+        auto saved = updateFailcount(ap, ok);
+        if (ok)
+          rememberAp(saved);
+      }
+      return ok;
+    }
+
+    bool Wifi::waitConnected(uint32_t graceMs, uint32_t timeoutMs) {
+      auto started = millis();
+      for (;;) {
+        auto elapsed = millis() - started;
+        if (elapsed >= timeoutMs)
+          return isConnected();
+        auto bits = xEventGroupWaitBits(
+            _eventGroup, WifiFlags::StaGotIp | WifiFlags::StaFailed, pdFALSE,
+            pdFALSE, pdMS_TO_TICKS(std::min(timeoutMs - elapsed, 1000UL)));
+        esp_task_wdt_reset();
+        if (isConnected())
+          return true;
+        if (bits & WifiFlags::StaFailed) {
+          // a disconnect reported early on may be left over from the previous
+          // attempt, give the current one until the end of the grace period
+          elapsed = millis() - started;
+          if (elapsed < graceMs)
+            xEventGroupWaitBits(_eventGroup, WifiFlags::StaGotIp, pdFALSE,
+                                pdFALSE, pdMS_TO_TICKS(graceMs - elapsed));
+          return isConnected();
+        }
+      }
+    }
+
+    ApInfo* Wifi::updateFailcount(ApInfo* ap, bool ok) {
+      if (std::find(_aps.begin(), _aps.end(), ap) == _aps.end()) {
+        // not in the list yet, e.g. credentials from a connect request or WPS
         if (!ok)
           ap->failed();
         else
           ap->succeeded();
-        addOrUpdateAp(ap->clone());
+        auto result = addOrUpdateAp(ap->clone());
         config::Changed::publish(this);
+        return result;
       }
-      return ok;
+      auto order = _aps;
+      if (!ok)
+        ap->failed();
+      else
+        ap->succeeded();
+      std::stable_sort(_aps.begin(), _aps.end(), compareAps);
+      // fail counts live in RAM, the config is only saved when they change the
+      // order the APs are tried in, so a flapping link does not wear the flash
+      if (order != _aps)
+        config::Changed::publish(this);
+      return ap;
+    }
+
+    ApInfo* Wifi::cachedAp() {
+      if (!rtcApCacheValid())
+        return nullptr;
+      for (auto ap : _aps)
+        if (ap->id() == s_apCache.apId) {
+          if (s_apCache.credentials != credentialsCrc(ap))
+            return nullptr;
+          // respect a pinned BSSID
+          if (ap->bssid() && memcmp(ap->bssid(), s_apCache.bssid, 6))
+            return nullptr;
+          return ap;
+        }
+      return nullptr;
+    }
+
+    void Wifi::rememberAp(ApInfo* ap) {
+      wifi_ap_record_t info;
+      if (!ap || esp_wifi_sta_get_ap_info(&info) != ESP_OK)
+        return;
+      auto credentials = credentialsCrc(ap);
+      bool same = rtcApCacheValid() && s_apCache.apId == ap->id() &&
+                  s_apCache.credentials == credentials;
+      if (same && s_apCache.channel == info.primary &&
+          !memcmp(s_apCache.bssid, info.bssid, 6))
+        return;
+      uint8_t pmk[32];
+      bool hasPmk = same && s_apCache.hasPmk;
+      if (hasPmk)
+        memcpy(pmk, s_apCache.pmk, sizeof(pmk));
+      else
+        hasPmk = derivePmk(ap, pmk);
+      rtcApCacheReset();
+      s_apCache.apId = ap->id();
+      s_apCache.credentials = credentials;
+      memcpy(s_apCache.bssid, info.bssid, 6);
+      s_apCache.channel = info.primary;
+      s_apCache.hasPmk = hasPmk;
+      if (hasPmk)
+        memcpy(s_apCache.pmk, pmk, sizeof(pmk));
+      s_apCache.crc = rtcApCacheCrc();
+      s_apCache.magic = RtcApCacheMagic;
+      s_apCache.magicInv = ~RtcApCacheMagic;
     }
 
     bool Wifi::tryConnect() {
@@ -1071,6 +1229,11 @@ namespace esp32m {
           _connect.reset();
       }
       if (!_ap || _ap->clientsCount() == 0) {
+        if (!connected) {
+          auto ap = cachedAp();
+          if (ap)
+            connected = tryConnect(ap, false, true);
+        }
         bool hasPinnedBssid = false;
         for (auto ap : _aps)
           if (ap->bssid()) {
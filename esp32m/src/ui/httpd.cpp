@@ -1,4 +1,5 @@
 #include "esp32m/ui/httpd.hpp"
+#include "esp32m/debug/heap.hpp"
 #include "esp32m/defs.hpp"
 #include "esp32m/net/net.hpp"
 #include "esp32m/logging.hpp"
@@ -8,11 +9,15 @@
 #include "esp32m/ui/asset.hpp"
 #include "esp32m/version.h"
 
+#include <esp_task_wdt.h>
 #include <esp_tls_crypto.h>
 #include <mdns.h>
 #include <algorithm>
-#include <vector>
+#include <atomic>
 #include <cstring>
+#include <memory>
+#include <new>
+#include <vector>
 #include "sdkconfig.h"
 
 #define HTTPD_401 "401 UNAUTHORIZED" /*!< HTTP Response 401 */
@@ -620,61 +625,214 @@ namespace esp32m {
       return ESP_OK;
     }
 
-    esp_err_t Httpd::sendTo(uint32_t cid, const char* text) {
-      if (!_server)
-        return ESP_ERR_INVALID_STATE;
+    namespace {
+      // progress of a streamed message, shared with its queued fragments
+      struct Flow {
+        std::atomic<uint8_t> pending = 0;
+        std::atomic<bool> failed = false;
+      };
 
       struct WorkItem {
         httpd_handle_t server;
         int fd;
-        uint8_t* payload;
-        size_t len;
+        httpd_ws_frame_t packet;
+        std::shared_ptr<Flow> flow;
       };
 
-      auto work = (WorkItem*)calloc(1, sizeof(WorkItem));
-      if (!work)
-        return ESP_ERR_NO_MEM;
-
-      size_t len = text ? strlen(text) : 0;
-      uint8_t* payload = nullptr;
-      if (len) {
-        payload = (uint8_t*)malloc(len);
-        if (!payload) {
-          free(work);
+      // takes ownership of the payload
+      esp_err_t queueFrame(httpd_handle_t server, int fd,
+                           const httpd_ws_frame_t& packet,
+                           const std::shared_ptr<Flow>& flow) {
+        auto work = new (std::nothrow) WorkItem{server, fd, packet, flow};
+        if (!work) {
+          free(packet.payload);
           return ESP_ERR_NO_MEM;
         }
-        memcpy(payload, text, len);
+        debug::heap::track(debug::heap::Site::HttpdSend,
+                           sizeof(WorkItem) + packet.len);
+        if (flow)
+          flow->pending++;
+
+        auto fn = [](void* arg) {
+          auto* w = (WorkItem*)arg;
+          auto err = httpd_ws_send_frame_async(w->server, w->fd, &w->packet);
+          if (w->flow) {
+            if (err != ESP_OK)
+              w->flow->failed = true;
+            w->flow->pending--;
+          }
+          free(w->packet.payload);
+          delete w;
+        };
+
+        auto err = httpd_queue_work(server, fn, work);
+        if (err != ESP_OK) {
+          if (flow) {
+            flow->failed = true;
+            flow->pending--;
+          }
+          free(work->packet.payload);
+          delete work;
+        }
+        return err;
+      }
+    }  // namespace
+
+    /**
+     * Sends a message as a sequence of WebSocket fragments, each queued as
+     * soon as the buffer fills up. The writer waits for the server to send
+     * what is queued before adding more, so a large message never takes
+     * more than a few fragments worth of memory. A client that stops
+     * reading fails the stream after StreamTimeoutMs in total.
+     */
+    class Httpd::WsStream : public Stream {
+     public:
+      WsStream(Httpd* httpd, int fd)
+          : _httpd(httpd),
+            _fd(fd),
+            _flow(std::make_shared<Flow>()),
+            _started(millis()),
+            _wdt(esp_task_wdt_status(NULL) == ESP_OK) {}
+      WsStream(const WsStream&) = delete;
+      ~WsStream() {
+        end();
+        free(_buf);
+      }
+      size_t write(const uint8_t* buf, size_t size) override {
+        size_t done = 0;
+        while (done < size && !_flow->failed) {
+          if (!_buf) {
+            _buf = (uint8_t*)malloc(WsFragment);
+            if (!_buf) {
+              _flow->failed = true;
+              break;
+            }
+          }
+          size_t n = std::min(size - done, WsFragment - _len);
+          memcpy(_buf + _len, buf + done, n);
+          _len += n;
+          done += n;
+          if (_len == WsFragment)
+            flush(false);
+        }
+        return done;
+      }
+      esp_err_t end() override {
+        finish(!_flow->failed);
+        return _flow->failed ? ESP_FAIL : ESP_OK;
+      }
+      void abort() override {
+        _flow->failed = true;
+        finish(false);
+      }
+      bool sent() const override {
+        return _sent;
       }
 
-      work->server = _server;
-      work->fd = (int)cid;
-      work->payload = payload;
-      work->len = len;
-
-      auto fn = [](void* arg) {
-        auto* w = (WorkItem*)arg;
-
-        httpd_ws_frame_t ws_pkt;
-        memset(&ws_pkt, 0, sizeof(httpd_ws_frame_t));
-        ws_pkt.payload = w->payload;
-        ws_pkt.len = w->len;
-        ws_pkt.type = HTTPD_WS_TYPE_TEXT;
-
-        (void)httpd_ws_send_frame_async(w->server, w->fd, &ws_pkt);
+     private:
+      static constexpr size_t WsFragment = CONFIG_ESP32M_UI_HTTPD_WS_FRAGMENT;
+      static constexpr uint8_t MaxPending = 2;
+      static constexpr int PendingTimeoutMs = 5000;
+      static constexpr int StreamTimeoutMs = 30000;
+      Httpd* _httpd;
+      int _fd;
+      std::shared_ptr<Flow> _flow;
+      unsigned long _started;
+      // whether the writing task is watched by the task WDT
+      bool _wdt;
+      uint8_t* _buf = nullptr;
+      size_t _len = 0;
+      bool _sent = false, _ended = false;
+      void finish(bool complete) {
+        if (_ended)
+          return;
+        _ended = true;
+        std::lock_guard guard(_httpd->_streamsMutex);
+        bool closing = !complete && _sent;
+        if (complete)
+          flush(true);
+        else if (closing)
+          // terminating the message would pass the broken JSON for a whole
+          // one, the connection is out of sync and has to go
+          httpd_sess_trigger_close(_httpd->_server, _fd);
+        auto held = _httpd->_held.find(_fd);
+        if (held != _httpd->_held.end()) {
+          if (!closing)
+            for (auto& text : held->second)
+              _httpd->queueText(_fd, text.c_str());
+          _httpd->_held.erase(held);
+        }
+      }
+      // waits for a free fragment slot, feeding the WDT meanwhile
+      bool waitPending() {
+        auto since = millis();
+        while (_flow->pending >= MaxPending && !_flow->failed) {
+          auto now = millis();
+          if (now - since >= PendingTimeoutMs ||
+              now - _started >= StreamTimeoutMs)
+            return false;
+          if (_wdt)
+            esp_task_wdt_reset();
+          delay(1);
+        }
+        return true;
+      }
+      void flush(bool final) {
+        if (!final && !waitPending())
+          _flow->failed = true;
+        if (_flow->failed)
+          return;
+        httpd_ws_frame_t packet;
+        memset(&packet, 0, sizeof(httpd_ws_frame_t));
+        packet.type = _sent ? HTTPD_WS_TYPE_CONTINUE : HTTPD_WS_TYPE_TEXT;
+        // a message that fits into a single buffer goes out unfragmented
+        packet.fragmented = _sent || !final;
+        packet.final = final;
+        packet.payload = _buf;
+        packet.len = _len;
+        _buf = nullptr;
+        _len = 0;
+        _sent = true;
+        queueFrame(_httpd->_server, _fd, packet, _flow);
+      }
+    };
 
-        if (w->payload)
-          free(w->payload);
-        free(w);
-      };
+    esp_err_t Httpd::queueText(int fd, const char* text) {
+      httpd_ws_frame_t packet;
+      memset(&packet, 0, sizeof(httpd_ws_frame_t));
+      packet.type = HTTPD_WS_TYPE_TEXT;
+      packet.len = text ? strlen(text) : 0;
+      if (packet.len) {
+        packet.payload = (uint8_t*)malloc(packet.len);
+        if (!packet.payload)
+          return ESP_ERR_NO_MEM;
+        memcpy(packet.payload, text, packet.len);
+      }
+      return queueFrame(_server, fd, packet, nullptr);
+    }
 
-      auto err = httpd_queue_work(_server, fn, work);
-      if (err != ESP_OK) {
-        if (work->payload)
-          free(work->payload);
-        free(work);
-        return err;
+    esp_err_t Httpd::sendTo(uint32_t cid, const char* text) {
+      if (!_server)
+        return ESP_ERR_INVALID_STATE;
+      // queue under the lock, so that a stream can't start in between
+      std::lock_guard guard(_streamsMutex);
+      auto held = _held.find((int)cid);
+      if (held != _held.end()) {
+        held->second.emplace_back(text ? text : "");
+        return ESP_OK;
       }
-      return ESP_OK;
+      return queueText((int)cid, text);
+    }
+
+    std::unique_ptr<Stream> Httpd::openStream(uint32_t cid, size_t size) {
+      if (!_server || (size && size <= CONFIG_ESP32M_UI_HTTPD_WS_FRAGMENT))
+        return nullptr;
+      std::lock_guard guard(_streamsMutex);
+      // fragments of two messages can't be interleaved, if there's a stream
+      // to this client already, the message is held back and sent whole
+      if (!_held.try_emplace((int)cid).second)
+        return nullptr;
+      return std::make_unique<WsStream>(this, (int)cid);
     }
 
   }  // namespace ui
@@ -33,6 +33,54 @@ namespace esp32m {
       // return json::allocSerialize(doc);
     }
 
+    // same envelope as makeResponse(), written straight into the transport
+    bool streamResponse(Transport* transport, uint32_t cid, const char* name,
+                        const char* source, int seq, bool error, bool partial,
+                        size_t size, const json::Producer& producer) {
+      auto stream = transport->openStream(cid, size);
+      if (!stream)
+        return false;
+      json::Writer writer(*stream);
+      writer.beginObject();
+      writer.member("type", "response");
+      if (name)
+        writer.member("name", name);
+      if (source)
+        writer.member("source", source);
+      if (partial)
+        writer.member("partial", true);
+      if (seq)
+        writer.member("seq", seq);
+      writer.key(error ? "error" : "data");
+      producer(writer);
+      writer.endObject();
+      if (writer.ok() && stream->end() == ESP_OK)
+        return true;
+      bool sent = stream->sent();
+      stream->abort();
+      // nothing went out yet, the caller may still send the response whole
+      if (!sent)
+        return false;
+      LOGW(transport, "response %s to client %u was cut short, session closed",
+           name, (unsigned)cid);
+      return true;
+    }
+
+    void sendResponse(Transport* transport, uint32_t cid, const char* name,
+                      const char* source, int seq, JsonVariantConst data,
+                      bool error, bool partial, bool stream = true) {
+      // serialize large documents into the transport piece by piece rather
+      // than into a string that is copied once more for sending
+      if (stream &&
+          streamResponse(transport, cid, name, source, seq, error, partial,
+                         measureJson(data),
+                         [data](json::Writer& w) { w.value(data); }))
+        return;
+      std::string text =
+          makeResponse(name, source, seq, data, error, partial);
+      transport->sendTo(cid, text.c_str());
+    }
+
     class Rb : public Response {
      public:
       uint32_t clientId;
@@ -61,10 +109,14 @@ namespace esp32m {
      protected:
       void respondImpl(const char* source, const JsonVariantConst data,
                        bool error) override {
-        std::string text =
-            ui::makeResponse(name(), source, seq(), data, error, false);
-        _transport->sendTo(_clientId, text.c_str());
-        // free(text);
+        sendResponse(_transport, _clientId, name(), source, seq(), data, error,
+                     false);
+      }
+
+      bool respondStreamImpl(const char* source,
+                             const json::Producer& producer) override {
+        return streamResponse(_transport, _clientId, name(), source, seq(),
+                              false, false, 0, producer);
       }
 
       Response* makeResponseImpl() override {
@@ -205,6 +257,9 @@ namespace esp32m {
       return;
     }
     Response* r;
+    // responses may be published from any task; streaming blocks the sender
+    // until the client takes the fragments, so only the UI task does it
+    bool stream = xTaskGetCurrentTaskHandle() == _task;
     auto transports = transportsView();
     for (auto* transport : *transports)
       if (Response::is(ev, transport->name(), &r)) {
@@ -213,11 +268,8 @@ namespace esp32m {
         JsonDocument* doc = r->data();
         JsonVariantConst data =
             doc ? doc->as<JsonVariantConst>() : json::null<JsonVariantConst>();
-        std::string response =
-            ui::makeResponse(r->name(), r->source(), r->seq(), data,
-                             r->isError(), r->isPartial());
-        transport->sendTo(resp->clientId, response.c_str());
-        // free(response);
+        ui::sendResponse(transport, resp->clientId, r->name(), r->source(),
+                         r->seq(), data, r->isError(), r->isPartial(), stream);
       }
   }
 
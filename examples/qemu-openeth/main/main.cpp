@@ -12,6 +12,17 @@
 
 #include <dist/ui.hpp>
 
+#if CONFIG_QEMU_PERF
+#include <esp32m/bus/modbus.hpp>
+#include <esp32m/debug/events.hpp>
+#include <esp32m/debug/heap.hpp>
+#include <esp32m/debug/trace.hpp>
+#include <esp32m/dev/dds238.hpp>
+#include <esp32m/net/mqtt.hpp>
+
+#include "sim.hpp"
+#endif
+
 using namespace esp32m;
 
 extern "C" void app_main()
@@ -25,4 +36,18 @@ extern "C" void app_main()
   auto &ui = Ui::instance();
   ui.addTransport(ui::Httpd::instance());
   initUi(&ui);
+#if CONFIG_QEMU_PERF
+  // perf/run.py points MQTT at its broker stand-in via config-set
+  debug::useHeap();
+  debug::useEvents();
+  debug::useTrace();
+  net::useMqtt();
+  net::mqtt::StatePublisher::instance();
+#if CONFIG_QEMU_PERF_MODBUS
+  modbus::master::configureSerial(UART_NUM_1, 115200);
+  dev::useDds238(1);
+#endif
+  dev::useSimSensors(CONFIG_QEMU_PERF_SIM_SENSORS,
+                     CONFIG_QEMU_PERF_SIM_POLL_MS);
+#endif
 }
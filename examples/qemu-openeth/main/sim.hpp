@@ -0,0 +1,72 @@
+#pragma once
+
+#include <math.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <esp32m/base.hpp>
+#include <esp32m/device.hpp>
+#include <esp32m/json.hpp>
+
+namespace esp32m {
+  namespace dev {
+
+    /**
+     * Bus-less stand-in for I2C sensors: exercises the device poll, state
+     * change and emit paths with values that change on every poll
+     */
+    class SimSensors : public Device {
+     public:
+      SimSensors(int count, int pollMs) {
+        Device::init(Flags::HasSensors);
+        setSensorsPollInterval(pollMs);
+        for (int i = 0; i < count; i++) {
+          auto id = string_printf("t%d", i);
+          auto sensor = std::make_unique<Sensor>(this, "temperature",
+                                                 id.c_str());
+          sensor->unit = "°C";
+          sensor->precision = 2;
+          _sensors.push_back(std::move(sensor));
+        }
+      }
+      SimSensors(const SimSensors &) = delete;
+      const char *name() const override {
+        return "sim";
+      }
+
+     protected:
+      bool setConfig(RequestContext &ctx) override {
+        bool changed = false;
+        int interval = getSensorsPollInterval();
+        if (json::from(ctx.data["interval"], interval, &changed))
+          setSensorsPollInterval(interval);
+        return changed;
+      }
+      JsonDocument *getConfig(RequestContext &ctx) override {
+        JsonDocument *doc = new JsonDocument();
+        auto root = doc->to<JsonObject>();
+        root["interval"] = getSensorsPollInterval();
+        return doc;
+      }
+      bool initSensors() override {
+        return true;
+      }
+      bool pollSensors() override {
+        _tick++;
+        for (int i = 0; i < _sensors.size(); i++)
+          _sensors[i]->set(20 + 5 * sinf((_tick + i * 7) * 0.05f));
+        return true;
+      }
+
+     private:
+      std::vector<std::unique_ptr<Sensor> > _sensors;
+      uint32_t _tick = 0;
+    };
+
+    inline SimSensors *useSimSensors(int count, int pollMs) {
+      return new SimSensors(count, pollMs);
+    }
+
+  }  // namespace dev
+}  // namespace esp32m
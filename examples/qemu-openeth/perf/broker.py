@@ -0,0 +1,85 @@
+"""MQTT 3.1.1 broker stand-in.
+
+Accepts any client, acknowledges CONNECT/SUBSCRIBE/QoS1 PUBLISH/PINGREQ and
+counts what the device publishes. Messages are not routed between clients.
+"""
+
+import asyncio
+import time
+
+
+class Broker:
+    def __init__(self):
+        self.connected = asyncio.Event()
+        self.connected_at = None
+        self.messages = 0
+        self.bytes = 0
+        self.topics = {}
+
+    def reset_counters(self):
+        self.messages = 0
+        self.bytes = 0
+        self.topics = {}
+
+    async def start(self, host, port):
+        self._server = await asyncio.start_server(self._client, host, port)
+
+    def close(self):
+        self._server.close()
+
+    async def _read_packet(self, reader):
+        header = (await reader.readexactly(1))[0]
+        length, shift = 0, 0
+        while True:
+            b = (await reader.readexactly(1))[0]
+            length |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                break
+        return header, await reader.readexactly(length)
+
+    async def _client(self, reader, writer):
+        try:
+            while True:
+                header, body = await self._read_packet(reader)
+                kind = header >> 4
+                if kind == 1:  # CONNECT
+                    writer.write(bytes([0x20, 2, 0, 0]))
+                    self.connected_at = time.monotonic()
+                    self.connected.set()
+                elif kind == 3:  # PUBLISH
+                    qos = (header >> 1) & 3
+                    tl = int.from_bytes(body[0:2], "big")
+                    topic = body[2:2 + tl].decode(errors="replace")
+                    pos = 2 + tl
+                    if qos:
+                        pid = body[pos:pos + 2]
+                        pos += 2
+                        if qos == 1:
+                            writer.write(bytes([0x40, 2]) + pid)
+                        else:
+                            writer.write(bytes([0x50, 2]) + pid)
+                    self.messages += 1
+                    self.bytes += len(body) - pos
+                    self.topics[topic] = self.topics.get(topic, 0) + 1
+                elif kind == 6:  # PUBREL
+                    writer.write(bytes([0x70, 2]) + body[0:2])
+                elif kind == 8:  # SUBSCRIBE
+                    count = 0
+                    pos = 2
+                    while pos < len(body):
+                        pos += 2 + int.from_bytes(body[pos:pos + 2], "big") + 1
+                        count += 1
+                    writer.write(bytes([0x90, 2 + count]) + body[0:2] +
+                                 bytes(count))
+                elif kind == 10:  # UNSUBSCRIBE
+                    writer.write(bytes([0xB0, 2]) + body[0:2])
+                elif kind == 12:  # PINGREQ
+                    writer.write(bytes([0xD0, 0]))
+                elif kind == 14:  # DISCONNECT
+                    break
+                await writer.drain()
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            writer.close()
@@ -0,0 +1,102 @@
+"""Modbus RTU slave stand-in emulating a DDS238 energy meter.
+
+QEMU connects UART1 to this server as a raw byte stream; frames are told
+apart by their function code since there are no inter-frame gaps on TCP.
+"""
+
+import asyncio
+import math
+import struct
+import time
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0xA001 if crc & 1 else crc >> 1
+    return struct.pack("<H", crc)
+
+
+class Dds238:
+    REGISTERS = 0x18
+
+    def __init__(self, addr=1):
+        self.addr = addr
+        self.requests = 0
+        self.errors = 0
+        self._started = time.monotonic()
+
+    def registers(self):
+        t = time.monotonic() - self._started
+        reg = [0] * self.REGISTERS
+        energy = int(123456 + t * 10)
+        reg[0x0:0x2] = [energy >> 16, energy & 0xFFFF]
+        reg[0xA:0xC] = [energy >> 16, energy & 0xFFFF]
+        reg[0xC] = int(2300 + 20 * math.sin(t))  # 0.1 V
+        reg[0xD] = int(500 + 100 * math.sin(t / 3))  # 0.01 A
+        reg[0xE] = int(1100 + 200 * math.sin(t / 3)) & 0xFFFF  # W
+        reg[0xF] = 50
+        reg[0x10] = 980
+        reg[0x11] = 5000
+        return reg
+
+    def handle(self, frame):
+        addr, fn = frame[0], frame[1]
+        if addr != self.addr:
+            return None
+        self.requests += 1
+        if fn in (3, 4):
+            start, count = struct.unpack(">HH", frame[2:6])
+            reg = self.registers()
+            if start + count > len(reg):
+                return self._error(fn, 2)
+            payload = b"".join(struct.pack(">H", v)
+                               for v in reg[start:start + count])
+            return bytes([addr, fn, len(payload)]) + payload
+        if fn in (6, 16):
+            return bytes(frame[0:6])
+        return self._error(fn, 1)
+
+    def _error(self, fn, code):
+        self.errors += 1
+        return bytes([self.addr, fn | 0x80, code])
+
+
+class ModbusSim:
+    def __init__(self, device):
+        self.device = device
+
+    async def start(self, host, port):
+        self._server = await asyncio.start_server(self._client, host, port)
+
+    def close(self):
+        self._server.close()
+
+    async def _frame(self, reader):
+        head = await reader.readexactly(2)
+        fn = head[1] & 0x7F
+        if fn == 16:
+            rest = await reader.readexactly(5)
+            rest += await reader.readexactly(rest[4] + 2)
+        else:
+            rest = await reader.readexactly(6)
+        return head + rest
+
+    async def _client(self, reader, writer):
+        try:
+            while True:
+                frame = await self._frame(reader)
+                if crc16(frame[:-2]) != frame[-2:]:
+                    self.device.errors += 1
+                    # resynchronise on whatever arrives next
+                    continue
+                reply = self.device.handle(frame[:-2])
+                if reply:
+                    writer.write(reply + crc16(reply))
+                    await writer.drain()
+        except (asyncio.IncompleteReadError, ConnectionError):
+            pass
+        finally:
+            writer.close()
@@ -0,0 +1,318 @@
+#!/usr/bin/env python3
+"""End-to-end performance scenarios for the qemu-openeth example.
+
+Boots the firmware in Espressif QEMU with an open_eth NIC, attaches UART1 to
+a Modbus meter stand-in, runs an MQTT broker stand-in and drives the HTTP and
+WebSocket UI from the host. Every scenario appends one JSON line to the
+results file.
+"""
+
+import argparse
+import asyncio
+import json
+import os
+import statistics
+import subprocess
+import sys
+import time
+import urllib.request
+
+from broker import Broker
+from modbus_sim import Dds238, ModbusSim
+from wsclient import WebSocket
+
+HOST = "127.0.0.1"
+# address of the host as seen from the QEMU user-mode network
+GUEST_GATEWAY = "10.0.2.2"
+
+
+def percentiles(samples):
+    if not samples:
+        return {}
+    s = sorted(samples)
+    pick = lambda q: s[min(len(s) - 1, int(q * len(s)))]
+    return {
+        "n": len(s),
+        "p50_ms": round(pick(0.5) * 1000, 2),
+        "p95_ms": round(pick(0.95) * 1000, 2),
+        "max_ms": round(s[-1] * 1000, 2),
+        "mean_ms": round(statistics.fmean(s) * 1000, 2),
+    }
+
+
+class Results:
+    def __init__(self, path):
+        self._file = open(path, "w")
+
+    def report(self, scenario, **fields):
+        line = json.dumps({"scenario": scenario, **fields})
+        print("PERF", line, flush=True)
+        self._file.write(line + "\n")
+        self._file.flush()
+
+    def close(self):
+        self._file.close()
+
+
+class Ui:
+    """WebSocket UI session that matches responses to requests by seq."""
+
+    def __init__(self, ws):
+        self._ws = ws
+        self._seq = 0
+        self._pending = {}
+        self.broadcasts = 0
+        self.bytes = 0
+        self._reader = asyncio.create_task(self._read())
+
+    @classmethod
+    async def connect(cls, port):
+        return cls(await WebSocket.connect(HOST, port))
+
+    async def _read(self):
+        while True:
+            text = await self._ws.recv()
+            if text is None:
+                break
+            self.bytes += len(text)
+            msg = json.loads(text)
+            if msg.get("type") == "broadcast":
+                self.broadcasts += 1
+                continue
+            future = self._pending.pop(msg.get("seq"), None)
+            if future and not future.done():
+                future.set_result(msg)
+
+    async def request(self, name, target=None, data=None, timeout=30):
+        self._seq += 1
+        msg = {"type": "request", "name": name, "seq": self._seq}
+        if target:
+            msg["target"] = target
+        if data is not None:
+            msg["data"] = data
+        future = asyncio.get_running_loop().create_future()
+        self._pending[self._seq] = future
+        await self._ws.send(json.dumps(msg))
+        response = await asyncio.wait_for(future, timeout)
+        if "error" in response:
+            raise RuntimeError(f"{name} {target}: {response['error']}")
+        return response.get("data")
+
+    async def close(self):
+        self._reader.cancel()
+        await self._ws.close()
+
+
+def http_get(port, path):
+    with urllib.request.urlopen(f"http://{HOST}:{port}{path}",
+                                timeout=30) as r:
+        return r.read()
+
+
+async def wait_http(port, timeout):
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        try:
+            await asyncio.to_thread(http_get, port, "/")
+            return
+        except OSError:
+            await asyncio.sleep(1)
+    raise TimeoutError("firmware did not come up")
+
+
+async def scenario_http(args, results):
+    for path in ("/", "/debug/trace.json"):
+        samples, size = [], 0
+        for _ in range(args.requests // 10 or 1):
+            started = time.monotonic()
+            try:
+                size = len(await asyncio.to_thread(http_get, args.http_port,
+                                                   path))
+            except OSError as e:
+                results.report("http.get", path=path, error=str(e))
+                break
+            samples.append(time.monotonic() - started)
+        else:
+            results.report("http.get", path=path, bytes=size,
+                           **percentiles(samples))
+
+
+async def scenario_rtt(ui, args, results):
+    for target in ("app", "sim"):
+        samples = []
+        for _ in range(args.requests):
+            started = time.monotonic()
+            await ui.request("state-get", target)
+            samples.append(time.monotonic() - started)
+        results.report("ws.rtt", request="state-get", target=target,
+                       **percentiles(samples))
+
+
+async def scenario_throughput(ui, args, results):
+    done = 0
+    deadline = time.monotonic() + args.duration
+    bytes_before = ui.bytes
+
+    async def worker():
+        nonlocal done
+        while time.monotonic() < deadline:
+            await ui.request("state-get", "sim")
+            done += 1
+
+    started = time.monotonic()
+    await asyncio.gather(*(worker() for _ in range(args.window)))
+    elapsed = time.monotonic() - started
+    results.report("ws.throughput", window=args.window,
+                   responses_per_s=round(done / elapsed, 1),
+                   bytes_per_s=round((ui.bytes - bytes_before) / elapsed))
+
+
+async def scenario_broadcast(args, results):
+    """config-changed broadcasts fan out to every connected client"""
+    clients = [await Ui.connect(args.http_port) for _ in range(args.clients)]
+    driver = clients[0]
+    # an even count leaves the poll interval where it started
+    count = max(2, (args.requests // 2) & ~1)
+    started = time.monotonic()
+    for i in range(count):
+        # alternate so that every request is an actual change
+        interval = args.sim_poll_ms + 1 - (i & 1)
+        await driver.request("config-set", "sim", {"interval": interval})
+    # let the tail of the fan-out arrive
+    await asyncio.sleep(1)
+    elapsed = time.monotonic() - started
+    received = sum(c.broadcasts for c in clients)
+    results.report("ws.broadcast", clients=len(clients), sent=count,
+                   received=received,
+                   broadcasts_per_s=round(received / elapsed, 1))
+    for c in clients:
+        await c.close()
+
+
+async def scenario_config_save(ui, args, results):
+    # reset-hostname saves the whole configuration before responding
+    samples = []
+    for _ in range(args.requests // 10 or 1):
+        started = time.monotonic()
+        await ui.request("reset-hostname", "app")
+        samples.append(time.monotonic() - started)
+    results.report("config.save", **percentiles(samples))
+
+
+async def scenario_mqtt(ui, broker, args, results):
+    started = time.monotonic()
+    await ui.request("config-set", "mqtt", {
+        "enabled": True,
+        "uri": f"mqtt://{GUEST_GATEWAY}:{args.broker_port}"
+    })
+    try:
+        await asyncio.wait_for(broker.connected.wait(), 60)
+    except asyncio.TimeoutError:
+        results.report("mqtt.state", error="device did not connect")
+        return
+    connect_s = broker.connected_at - started
+    # skip the burst of retained/birth messages right after connecting
+    await asyncio.sleep(2)
+    broker.reset_counters()
+    await asyncio.sleep(args.duration)
+    results.report("mqtt.state", connect_ms=round(connect_s * 1000),
+                   messages_per_s=round(broker.messages / args.duration, 1),
+                   bytes_per_s=round(broker.bytes / args.duration),
+                   topics=len(broker.topics))
+
+
+async def scenario_modbus(meter, args, results):
+    before = meter.requests
+    await asyncio.sleep(args.duration)
+    results.report("modbus.poll", requests_per_s=round(
+        (meter.requests - before) / args.duration, 2), errors=meter.errors)
+
+
+async def heap(ui, results, phase):
+    state = await ui.request("state-get", "heap")
+    for cap, v in state.items():
+        if cap == "sites":
+            results.report("heap.sites", phase=phase,
+                           sites={s[0]: {"count": s[1], "bytes": s[2]}
+                                  for s in v})
+        else:
+            results.report("heap", phase=phase, caps=cap, size=v[0],
+                           free=v[1], min_free=v[2], largest=v[3],
+                           frag_pct=v[4])
+
+
+def start_qemu(args):
+    build = os.path.abspath(args.build_dir)
+    image = os.path.join(build, "merged.bin")
+    if not os.path.exists(image) or args.merge:
+        subprocess.run([
+            sys.executable, "-m", "esptool", "--chip", "esp32", "merge_bin",
+            "--fill-flash-size", "4MB", "-o", "merged.bin", "@flash_args"
+        ], cwd=build, check=True)
+    cmd = [
+        args.qemu, "-machine", "esp32", "-display", "none", "-monitor",
+        "none", "-serial", f"file:{args.serial_log}", "-serial",
+        f"tcp:{HOST}:{args.modbus_port}", "-drive",
+        f"file={image},if=mtd,format=raw", "-global",
+        "driver=timer.esp32.timg,property=wdt_disable,value=true", "-nic",
+        f"user,model=open_eth,hostfwd=tcp:{HOST}:{args.http_port}-:80"
+    ]
+    return subprocess.Popen(cmd, stdin=subprocess.DEVNULL)
+
+
+async def main(args):
+    results = Results(args.output)
+    broker = Broker()
+    await broker.start("0.0.0.0", args.broker_port)
+    meter = Dds238()
+    modbus = ModbusSim(meter)
+    await modbus.start(HOST, args.modbus_port)
+    qemu = start_qemu(args)
+    try:
+        booted = time.monotonic()
+        await wait_http(args.http_port, args.boot_timeout)
+        results.report("boot", ready_ms=round(
+            (time.monotonic() - booted) * 1000))
+        ui = await Ui.connect(args.http_port)
+        await heap(ui, results, "boot")
+        await scenario_http(args, results)
+        await scenario_rtt(ui, args, results)
+        await scenario_throughput(ui, args, results)
+        await scenario_broadcast(args, results)
+        await scenario_config_save(ui, args, results)
+        await scenario_mqtt(ui, broker, args, results)
+        await scenario_modbus(meter, args, results)
+        await heap(ui, results, "end")
+        await ui.close()
+    finally:
+        qemu.terminate()
+        qemu.wait()
+        broker.close()
+        modbus.close()
+        results.close()
+
+
+if __name__ == "__main__":
+    here = os.path.dirname(os.path.abspath(__file__))
+    p = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    p.add_argument("--build-dir", default=os.path.join(here, "..", "build"))
+    p.add_argument("--qemu", default="qemu-system-xtensa")
+    p.add_argument("--merge", action="store_true",
+                   help="re-create merged.bin even if it exists")
+    p.add_argument("--http-port", type=int, default=8888)
+    p.add_argument("--broker-port", type=int, default=1883)
+    p.add_argument("--modbus-port", type=int, default=5502)
+    p.add_argument("--requests", type=int, default=200,
+                   help="requests per latency scenario")
+    p.add_argument("--duration", type=float, default=20,
+                   help="seconds per throughput scenario")
+    p.add_argument("--window", type=int, default=4,
+                   help="outstanding requests in ws.throughput")
+    p.add_argument("--clients", type=int, default=3,
+                   help="WebSocket clients in ws.broadcast")
+    p.add_argument("--sim-poll-ms", type=int, default=100,
+                   help="CONFIG_QEMU_PERF_SIM_POLL_MS the image was built with")
+    p.add_argument("--boot-timeout", type=float, default=120)
+    p.add_argument("--serial-log", default="serial.log")
+    p.add_argument("--output", default="perf.jsonl")
+    asyncio.run(main(p.parse_args()))
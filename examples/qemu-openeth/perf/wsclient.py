@@ -0,0 +1,92 @@
+"""Minimal asyncio WebSocket client (RFC 6455), enough to talk to the esp32m UI."""
+
+import asyncio
+import base64
+import os
+import struct
+
+OP_TEXT = 0x1
+OP_CLOSE = 0x8
+OP_PING = 0x9
+OP_PONG = 0xA
+
+
+class WebSocket:
+    def __init__(self, reader, writer):
+        self._reader = reader
+        self._writer = writer
+
+    @classmethod
+    async def connect(cls, host, port, path="/ws", timeout=10):
+        reader, writer = await asyncio.wait_for(
+            asyncio.open_connection(host, port), timeout)
+        key = base64.b64encode(os.urandom(16)).decode()
+        writer.write((
+            f"GET {path} HTTP/1.1\r\n"
+            f"Host: {host}:{port}\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            f"Sec-WebSocket-Key: {key}\r\n"
+            "Sec-WebSocket-Version: 13\r\n\r\n").encode())
+        await writer.drain()
+        status = await asyncio.wait_for(reader.readline(), timeout)
+        if b" 101 " not in status:
+            writer.close()
+            raise ConnectionError(f"websocket handshake failed: {status!r}")
+        while (await reader.readline()) not in (b"\r\n", b""):
+            pass
+        return cls(reader, writer)
+
+    async def send(self, text):
+        payload = text.encode()
+        header = bytearray([0x80 | OP_TEXT])
+        n = len(payload)
+        if n < 126:
+            header.append(0x80 | n)
+        elif n < 65536:
+            header.append(0x80 | 126)
+            header += struct.pack(">H", n)
+        else:
+            header.append(0x80 | 127)
+            header += struct.pack(">Q", n)
+        mask = os.urandom(4)
+        header += mask
+        masked = bytes(b ^ mask[i & 3] for i, b in enumerate(payload))
+        self._writer.write(bytes(header) + masked)
+        await self._writer.drain()
+
+    async def recv(self):
+        """Returns the next text message, or None when the peer closes."""
+        message = bytearray()
+        while True:
+            b0, b1 = await self._reader.readexactly(2)
+            opcode = b0 & 0x0F
+            n = b1 & 0x7F
+            if n == 126:
+                (n,) = struct.unpack(">H", await self._reader.readexactly(2))
+            elif n == 127:
+                (n,) = struct.unpack(">Q", await self._reader.readexactly(8))
+            if b1 & 0x80:
+                mask = await self._reader.readexactly(4)
+                data = bytes(b ^ mask[i & 3] for i, b in
+                             enumerate(await self._reader.readexactly(n)))
+            else:
+                data = await self._reader.readexactly(n)
+            if opcode == OP_CLOSE:
+                return None
+            if opcode == OP_PING:
+                self._writer.write(bytes([0x80 | OP_PONG, 0x80]) + os.urandom(4))
+                continue
+            if opcode == OP_PONG:
+                continue
+            message += data
+            if b0 & 0x80:
+                return message.decode(errors="replace")
+
+    async def close(self):
+        try:
+            self._writer.write(bytes([0x80 | OP_CLOSE, 0x80]) + os.urandom(4))
+            await self._writer.drain()
+        except ConnectionError:
+            pass
+        self._writer.close()
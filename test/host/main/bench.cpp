@@ -0,0 +1,188 @@
+#include <malloc.h>
+#include <stdio.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esp32m/events.hpp"
+#include "esp32m/json.hpp"
+#include "harness.hpp"
+
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t n, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+}
+
+namespace {
+  std::atomic<size_t> _allocations = 0;
+}
+
+// Counting wrappers over glibc; operator new ends up here as well
+extern "C" void *malloc(size_t size) {
+  _allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size) {
+  _allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+  _allocations.fetch_add(1, std::memory_order_relaxed);
+  return __libc_realloc(ptr, size);
+}
+
+namespace esp32m {
+  namespace host {
+
+    size_t allocations() {
+      return _allocations.load(std::memory_order_relaxed);
+    }
+
+    namespace {
+
+      typedef std::chrono::steady_clock Clock;
+
+      class Reporter {
+       public:
+        Reporter(const char *path) : _file(fopen(path, "w")) {
+          if (!_file)
+            printf("cannot open %s, results go to stdout only\n", path);
+        }
+        ~Reporter() {
+          if (_file)
+            fclose(_file);
+        }
+        /**
+         * @brief Emits one result as a single JSON line, to stdout and to the
+         * results file
+         */
+        void report(JsonDocument &doc) {
+          std::string line;
+          serializeJson(doc, line);
+          printf("BENCH %s\n", line.c_str());
+          if (_file)
+            fprintf(_file, "%s\n", line.c_str());
+        }
+
+       private:
+        FILE *_file;
+      };
+
+      struct Sample {
+        double nsPerOp;
+        double allocsPerOp;
+      };
+
+      template <typename F>
+      Sample measure(int iterations, F f) {
+        for (int i = 0; i < iterations / 10; i++) f(i);  // warm up
+        auto allocs = allocations();
+        auto started = Clock::now();
+        for (int i = 0; i < iterations; i++) f(i);
+        auto elapsed = std::chrono::duration<double, std::nano>(
+            Clock::now() - started);
+        return {elapsed.count() / iterations,
+                (double)(allocations() - allocs) / iterations};
+      }
+
+      void eventsPublish(Reporter &r) {
+        const int iterations = 100000;
+        for (int n : {0, 1, 4, 16, 64}) {
+          std::vector<std::unique_ptr<Subscription> > subs;
+          volatile int hits = 0;
+          for (int i = 0; i < n; i++)
+            subs.emplace_back(EventManager::instance().subscribe(
+                [&hits](Event &ev) {
+                  if (ev.is("bench"))
+                    hits = hits + 1;
+                }));
+          Event ev("bench");
+          auto s = measure(iterations, [&](int) { ev.publish(); });
+          JsonDocument doc;
+          doc["bench"] = "events.publish";
+          doc["subscribers"] = n;
+          doc["ns_per_op"] = s.nsPerOp;
+          doc["allocs_per_op"] = s.allocsPerOp;
+          r.report(doc);
+        }
+      }
+
+      void logLine(Reporter &r) {
+        const int iterations = 20000;
+        CaptureAppender appender;
+        log::addAppender(&appender);
+        log::SimpleLoggable loggable("bench");
+        auto &logger = loggable.logger();
+        logger.setLevel(log::Level::Debug);
+        struct {
+          const char *name;
+          log::Level level;
+        } cases[] = {{"log.emit", log::Level::Info},
+                     {"log.filtered", log::Level::Verbose}};
+        for (auto &c : cases) {
+          auto s = measure(iterations, [&](int i) {
+            logger.logf(c.level, "counter %d, value %.2f", i, i * 0.5);
+            if (appender.lines.size() > 1024)
+              appender.clear();
+          });
+          JsonDocument doc;
+          doc["bench"] = c.name;
+          doc["ns_per_op"] = s.nsPerOp;
+          doc["allocs_per_op"] = s.allocsPerOp;
+          r.report(doc);
+        }
+        log::removeAppender(&appender);
+      }
+
+      // Shape is modelled after what a device with a few sensors reports
+      JsonDocument *sampleState(int i) {
+        auto doc = new JsonDocument();
+        auto root = doc->to<JsonObject>();
+        root["uptime"] = 1000 + i;
+        auto sensors = root["sensors"].to<JsonArray>();
+        for (int s = 0; s < 8; s++) {
+          auto e = sensors.add<JsonObject>();
+          e["name"] = "temperature";
+          e["value"] = 20.5 + s;
+          e["unit"] = "C";
+        }
+        return doc;
+      }
+
+      void stateEmit(Reporter &r) {
+        const int iterations = 5000;
+        size_t bytes = 0;
+        auto s = measure(iterations, [&](int i) {
+          json::ConcatToObject c;
+          c.add("app", sampleState(i));
+          c.add("net", json::parse("{\"ip\":\"192.168.1.2\",\"rssi\":-60}"));
+          std::unique_ptr<JsonDocument> doc(c.concat());
+          std::string out;
+          serializeJson(*doc, out);
+          bytes = out.size();
+        });
+        JsonDocument doc;
+        doc["bench"] = "state.emit";
+        doc["bytes"] = bytes;
+        doc["ns_per_op"] = s.nsPerOp;
+        doc["allocs_per_op"] = s.allocsPerOp;
+        r.report(doc);
+      }
+
+    }  // namespace
+
+    void runBenchmarks(const char *output) {
+      Reporter r(output);
+      eventsPublish(r);
+      logLine(r);
+      stateEmit(r);
+    }
+
+  }  // namespace host
+}  // namespace esp32m
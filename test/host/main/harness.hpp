@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "esp32m/logging.hpp"
+
+namespace esp32m {
+  namespace host {
+
+    /**
+     * @brief Number of malloc/calloc/realloc calls made by this process so far
+     */
+    size_t allocations();
+
+    /**
+     * @brief Log appender that keeps formatted messages in memory
+     */
+    class CaptureAppender : public log::LogAppender {
+     public:
+      std::vector<std::string> lines;
+      void clear() {
+        lines.clear();
+      }
+
+     protected:
+      bool append(const log::LogMessage *message) override {
+        if (message)
+          lines.emplace_back(message->message());
+        return true;
+      }
+    };
+
+    int runTests();
+    void runBenchmarks(const char *output);
+
+  }  // namespace host
+}  // namespace esp32m
@@ -0,0 +1,32 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <unity.h>
+
+#include "harness.hpp"
+
+// Results of the micro-benchmarks are written here as JSON lines, override
+// with ESP32M_BENCH_OUT
+static const char *DefaultBenchOutput = "bench.jsonl";
+
+namespace esp32m {
+  namespace host {
+
+    int runTests() {
+      UNITY_BEGIN();
+      unity_run_all_tests();
+      return UNITY_END();
+    }
+
+  }  // namespace host
+}  // namespace esp32m
+
+extern "C" void app_main() {
+  using namespace esp32m::host;
+  auto failures = runTests();
+  if (!failures) {
+    auto output = getenv("ESP32M_BENCH_OUT");
+    runBenchmarks(output ? output : DefaultBenchOutput);
+  }
+  fflush(stdout);
+  exit(failures ? 1 : 0);
+}
@@ -0,0 +1,100 @@
+#include <malloc.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "esp32m/net/ota.hpp"
+
+// Fallbacks for symbols the core sources reference but the linux target does
+// not implement. They are weak so that whatever IDF does provide wins.
+
+extern "C" {
+
+__attribute__((weak)) int64_t esp_timer_get_time(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+__attribute__((weak)) void *heap_caps_malloc(size_t size, uint32_t caps) {
+  return malloc(size);
+}
+
+__attribute__((weak)) size_t heap_caps_get_largest_free_block(uint32_t caps) {
+  return SIZE_MAX;
+}
+
+__attribute__((weak)) int esp_task_wdt_add(void *task_handle) {
+  return 0;
+}
+
+__attribute__((weak)) int esp_task_wdt_reset(void) {
+  return 0;
+}
+
+__attribute__((weak)) int ets_printf(const char *fmt, ...) {
+  va_list args;
+  va_start(args, fmt);
+  auto result = vprintf(fmt, args);
+  va_end(args);
+  return result;
+}
+
+__attribute__((weak)) void ets_install_putc1(void (*p)(char c)) {}
+
+__attribute__((weak)) void ets_install_uart_printf(void) {}
+
+__attribute__((weak)) void esp_rom_install_channel_putc(
+    int channel, void (*putc)(char c)) {}
+
+__attribute__((weak)) void esp_rom_output_putc(char c) {
+  putchar(c);
+}
+
+// same as the ROM implementation: reflected polynomial, the initial value and
+// the result are inverted
+__attribute__((weak)) uint32_t esp_rom_crc32_le(uint32_t crc,
+                                                const uint8_t *buf,
+                                                uint32_t len) {
+  crc = ~crc;
+  while (len--) {
+    crc ^= *buf++;
+    for (int i = 0; i < 8; i++) crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+  }
+  return ~crc;
+}
+
+__attribute__((weak)) int xPortCanYield(void) {
+  return 1;
+}
+
+// The harness never calls log::useQueue(), the ring buffer is therefore
+// never created
+__attribute__((weak)) void *xRingbufferCreate(size_t size, int type) {
+  return nullptr;
+}
+__attribute__((weak)) size_t xRingbufferGetMaxItemSize(void *rb) {
+  return 0;
+}
+__attribute__((weak)) int xRingbufferSend(void *rb, const void *item,
+                                          size_t size, uint32_t ticks) {
+  return 0;
+}
+__attribute__((weak)) void *xRingbufferReceive(void *rb, size_t *size,
+                                               uint32_t ticks) {
+  return nullptr;
+}
+__attribute__((weak)) void vRingbufferReturnItem(void *rb, void *item) {}
+__attribute__((weak)) void vRingbufferDelete(void *rb) {}
+}
+
+namespace esp32m {
+  namespace net {
+    namespace ota {
+      bool isRunning() {
+        return false;
+      }
+    }  // namespace ota
+  }  // namespace net
+}  // namespace esp32m
@@ -0,0 +1,53 @@
+#include <unity.h>
+
+#include "esp32m/base.hpp"
+
+using namespace esp32m;
+
+TEST_CASE("byte_swap reverses multi-byte values", "[base]") {
+  TEST_ASSERT_EQUAL_HEX16(0x3412,
+                          (byte_swap<Endian::Little, Endian::Big>(
+                              (uint16_t)0x1234)));
+  TEST_ASSERT_EQUAL_HEX32(0x78563412,
+                          (byte_swap<Endian::Big, Endian::Little>(
+                              (uint32_t)0x12345678)));
+  TEST_ASSERT_EQUAL_HEX64(0x0807060504030201ULL,
+                          (byte_swap<Endian::Little, Endian::Big>(
+                              (uint64_t)0x0102030405060708ULL)));
+  TEST_ASSERT_EQUAL_HEX8(0x12, (byte_swap<Endian::Little, Endian::Big>(
+                                   (uint8_t)0x12)));
+}
+
+TEST_CASE("byte_swap is identity for the same endianness", "[base]") {
+  TEST_ASSERT_EQUAL_HEX32(0x12345678,
+                          (byte_swap<Endian::Big, Endian::Big>(
+                              (uint32_t)0x12345678)));
+  TEST_ASSERT_EQUAL_HEX32(0x12345678,
+                          (byte_swap<Endian::Little, Endian::Little>(
+                              (uint32_t)0x12345678)));
+}
+
+TEST_CASE("fromEndian decodes wire buffers", "[base]") {
+  const uint8_t wire[] = {0x12, 0x34, 0x56, 0x78};
+  uint32_t raw;
+  memcpy(&raw, wire, sizeof(raw));
+  TEST_ASSERT_EQUAL_HEX32(0x12345678, fromEndian(Endian::Big, raw));
+  TEST_ASSERT_EQUAL_HEX32(0x78563412, fromEndian(Endian::Little, raw));
+}
+
+TEST_CASE("toEndian round-trips through fromEndian", "[base]") {
+  int16_t i16 = -12345;
+  TEST_ASSERT_EQUAL_INT16(i16,
+                          fromEndian(Endian::Big, toEndian(Endian::Big, i16)));
+  float f = 3.25f;
+  TEST_ASSERT_EQUAL_FLOAT(f,
+                          fromEndian(Endian::Big, toEndian(Endian::Big, f)));
+  double d = -1e-3;
+  TEST_ASSERT_EQUAL_DOUBLE(
+      d, fromEndian(Endian::Little, toEndian(Endian::Little, d)));
+}
+
+TEST_CASE("hex_encode emits lowercase pairs", "[base]") {
+  const uint8_t data[] = {0x00, 0xab, 0x7f};
+  TEST_ASSERT_EQUAL_STRING("00ab7f", hex_encode(data, sizeof(data)).c_str());
+}
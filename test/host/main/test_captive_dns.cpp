@@ -0,0 +1,161 @@
+#include <unity.h>
+
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "esp32m/net/dns_responder.hpp"
+
+using namespace esp32m::net;
+
+namespace {
+  const uint16_t TypeA = 1, TypeAAAA = 28, TypeTXT = 16, TypeHTTPS = 65;
+
+  std::vector<uint8_t> query(const char *name, uint16_t type,
+                             uint8_t flags = 0x01 /* RD */) {
+    std::vector<uint8_t> q = {0x12, 0x34, flags, 0, 0, 1, 0, 0, 0, 0, 0, 0};
+    while (*name) {
+      auto dot = strchr(name, '.');
+      size_t len = dot ? dot - name : strlen(name);
+      q.push_back(len);
+      q.insert(q.end(), name, name + len);
+      name += len + (dot ? 1 : 0);
+    }
+    q.push_back(0);
+    q.push_back(type >> 8);
+    q.push_back(type & 0xff);
+    q.push_back(0);
+    q.push_back(1);  // IN
+    return q;
+  }
+
+  uint16_t get16(const uint8_t *p) {
+    return (p[0] << 8) | p[1];
+  }
+
+  DnsResponder responder() {
+    esp_ip4_addr_t ip;
+    ip.addr = ESP_IP4TOADDR(192, 168, 4, 1);
+    return DnsResponder(ip, 60);
+  }
+}  // namespace
+
+TEST_CASE("A queries are answered with the portal address", "[dns]") {
+  auto r = responder();
+  auto q = query("connectivitycheck.gstatic.com", TypeA);
+  uint8_t reply[DnsResponder::MaxPacket];
+  auto len = r.respond(q.data(), q.size(), reply);
+  TEST_ASSERT_EQUAL(q.size() + 16, len);
+  TEST_ASSERT_EQUAL_HEX(0x1234, get16(reply));
+  TEST_ASSERT_EQUAL_HEX(0x85, reply[2]);  // QR, AA, RD copied
+  TEST_ASSERT_EQUAL(0, reply[3]);
+  TEST_ASSERT_EQUAL(1, get16(reply + 4));
+  TEST_ASSERT_EQUAL(1, get16(reply + 6));
+  TEST_ASSERT_EQUAL(0, memcmp(q.data() + 12, reply + 12, q.size() - 12));
+  auto answer = reply + q.size();
+  TEST_ASSERT_EQUAL_HEX(0xc00c, get16(answer));
+  TEST_ASSERT_EQUAL(TypeA, get16(answer + 2));
+  TEST_ASSERT_EQUAL(1, get16(answer + 4));
+  TEST_ASSERT_EQUAL(60, get16(answer + 8));
+  TEST_ASSERT_EQUAL(4, get16(answer + 10));
+  TEST_ASSERT_EQUAL(192, answer[12]);
+  TEST_ASSERT_EQUAL(168, answer[13]);
+  TEST_ASSERT_EQUAL(4, answer[14]);
+  TEST_ASSERT_EQUAL(1, answer[15]);
+}
+
+TEST_CASE("AAAA and HTTPS queries get NXDOMAIN", "[dns]") {
+  auto r = responder();
+  uint8_t reply[DnsResponder::MaxPacket];
+  for (auto type : {TypeAAAA, TypeHTTPS}) {
+    auto q = query("example.com", type);
+    auto len = r.respond(q.data(), q.size(), reply);
+    TEST_ASSERT_EQUAL(q.size(), len);
+    TEST_ASSERT_EQUAL(3, reply[3]);
+    TEST_ASSERT_EQUAL(0, get16(reply + 6));
+  }
+}
+
+TEST_CASE("other query types get an empty NOERROR", "[dns]") {
+  auto r = responder();
+  uint8_t reply[DnsResponder::MaxPacket];
+  auto q = query("example.com", TypeTXT);
+  TEST_ASSERT_EQUAL(q.size(), r.respond(q.data(), q.size(), reply));
+  TEST_ASSERT_EQUAL(0, reply[3]);
+  TEST_ASSERT_EQUAL(0, get16(reply + 6));
+}
+
+TEST_CASE("malformed queries are dropped", "[dns]") {
+  auto r = responder();
+  uint8_t reply[DnsResponder::MaxPacket];
+  // a reply
+  auto q = query("example.com", TypeA, 0x81);
+  TEST_ASSERT_EQUAL(0, r.respond(q.data(), q.size(), reply));
+  // not a standard query
+  q = query("example.com", TypeA, 0x11);
+  TEST_ASSERT_EQUAL(0, r.respond(q.data(), q.size(), reply));
+  // two questions
+  q = query("example.com", TypeA);
+  q[5] = 2;
+  TEST_ASSERT_EQUAL(0, r.respond(q.data(), q.size(), reply));
+  // compressed name
+  q = query("example.com", TypeA);
+  q[12] = 0xc0;
+  TEST_ASSERT_EQUAL(0, r.respond(q.data(), q.size(), reply));
+  // label running past the end of the packet
+  q = query("example.com", TypeA);
+  q[12] = 60;
+  TEST_ASSERT_EQUAL(0, r.respond(q.data(), q.size(), reply));
+  // name longer than 255 bytes
+  std::string name;
+  for (int i = 0; i < 5; i++) name += std::string(60, 'a') + ".";
+  name += "com";
+  q = query(name.c_str(), TypeA);
+  TEST_ASSERT_EQUAL(0, r.respond(q.data(), q.size(), reply));
+  // oversized packet
+  q = query("example.com", TypeA);
+  q.resize(DnsResponder::MaxPacket + 1);
+  TEST_ASSERT_EQUAL(0, r.respond(q.data(), q.size(), reply));
+}
+
+TEST_CASE("truncated queries are dropped", "[dns]") {
+  auto r = responder();
+  uint8_t reply[DnsResponder::MaxPacket];
+  auto q = query("example.com", TypeA);
+  // TC flag set
+  auto tc = query("example.com", TypeA, 0x03);
+  TEST_ASSERT_EQUAL(0, r.respond(tc.data(), tc.size(), reply));
+  // short header, cut in the name, cut in the type/class
+  for (size_t len : {(size_t)11, (size_t)16, q.size() - 1, q.size() - 3})
+    TEST_ASSERT_EQUAL(0, r.respond(q.data(), len, reply));
+  TEST_ASSERT_NOT_EQUAL(0, r.respond(q.data(), q.size(), reply));
+}
+
+TEST_CASE("rate limiter allows bursts and refills over time", "[dns]") {
+  DnsRateLimiter limiter(10, 3);
+  for (int i = 0; i < 3; i++) TEST_ASSERT_TRUE(limiter.allow(1, 1000));
+  TEST_ASSERT_FALSE(limiter.allow(1, 1000));
+  // other clients have their own buckets
+  TEST_ASSERT_TRUE(limiter.allow(2, 1000));
+  // 10 queries per second, one token every 100ms
+  TEST_ASSERT_FALSE(limiter.allow(1, 1050));
+  TEST_ASSERT_TRUE(limiter.allow(1, 1150));
+  TEST_ASSERT_FALSE(limiter.allow(1, 1150));
+  // a client that stayed quiet long enough gets the whole burst back
+  for (int i = 0; i < 3; i++) TEST_ASSERT_TRUE(limiter.allow(1, 5000));
+  TEST_ASSERT_FALSE(limiter.allow(1, 5000));
+}
+
+TEST_CASE("rate limiter recycles the least recently seen client",
+          "[dns]") {
+  DnsRateLimiter limiter(1, 1);
+  TEST_ASSERT_TRUE(limiter.allow(1, 0));
+  TEST_ASSERT_FALSE(limiter.allow(1, 0));
+  for (uint32_t c = 2; c <= DnsRateLimiter::MaxClients + 1; c++)
+    TEST_ASSERT_TRUE(limiter.allow(c, c));
+  // client 1 was evicted and starts with a full bucket
+  TEST_ASSERT_TRUE(limiter.allow(1, 100));
+  // client 3 is still tracked, its bucket is empty
+  TEST_ASSERT_FALSE(limiter.allow(3, 100));
+}
@@ -0,0 +1,157 @@
+#include <esp_rom_crc.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <unity.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "esp32m/config/vfs.hpp"
+
+using namespace esp32m;
+
+namespace {
+  const char *Path = "/tmp/esp32m-host-config";
+  const char *Backup = "/tmp/esp32m-host-config.bak";
+  const uint32_t Magic = 0xCFE32001;
+
+  struct Header {
+    uint32_t magic, fileSize, jsonSize, crc;
+  };
+
+  // exposes the protected Store interface
+  class TestStore : public config::Vfs {
+   public:
+    TestStore() : Vfs(Path) {}
+    using Vfs::read;
+    using Vfs::reset;
+    using Vfs::write;
+  };
+
+  void clean() {
+    unlink(Path);
+    unlink(Backup);
+  }
+
+  std::vector<uint8_t> readFile(const char *path) {
+    std::vector<uint8_t> result;
+    FILE *f = fopen(path, "r");
+    if (!f)
+      return result;
+    uint8_t buf[256];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+      result.insert(result.end(), buf, buf + n);
+    fclose(f);
+    return result;
+  }
+
+  void writeFile(const char *path, const void *data, size_t size) {
+    FILE *f = fopen(path, "w");
+    fwrite(data, 1, size, f);
+    fclose(f);
+  }
+
+  bool exists(const char *path) {
+    struct stat st;
+    return stat(path, &st) == 0;
+  }
+
+  int valueOf(JsonDocument *doc) {
+    int result = doc ? (*doc)["v"].as<int>() : -1;
+    delete doc;
+    return result;
+  }
+
+  void save(TestStore &store, int v) {
+    JsonDocument doc;
+    doc["v"] = v;
+    store.write(doc);
+  }
+}  // namespace
+
+TEST_CASE("config::Vfs writes a header with size and CRC", "[config]") {
+  clean();
+  TestStore store;
+  save(store, 1);
+  auto file = readFile(Path);
+  TEST_ASSERT_TRUE(file.size() > sizeof(Header));
+  Header header;
+  memcpy(&header, file.data(), sizeof(Header));
+  auto json = (const char *)file.data() + sizeof(Header);
+  auto len = file.size() - sizeof(Header);
+  TEST_ASSERT_EQUAL_HEX(Magic, header.magic);
+  TEST_ASSERT_EQUAL(file.size(), header.fileSize);
+  TEST_ASSERT_EQUAL(len, header.jsonSize);
+  TEST_ASSERT_EQUAL(0, strncmp("{\"v\":1}", json, len));
+  TEST_ASSERT_EQUAL_HEX(
+      esp_rom_crc32_le(header.jsonSize, (const uint8_t *)json, len),
+      header.crc);
+  TEST_ASSERT_EQUAL(1, valueOf(store.read()));
+  clean();
+}
+
+TEST_CASE("config::Vfs skips writing unchanged config", "[config]") {
+  clean();
+  TestStore store;
+  save(store, 1);
+  save(store, 1);
+  TEST_ASSERT_FALSE(exists(Backup));
+  save(store, 2);
+  TEST_ASSERT_TRUE(exists(Backup));
+  TEST_ASSERT_EQUAL(2, valueOf(store.read()));
+  clean();
+}
+
+TEST_CASE("config::Vfs falls back to the backup on CRC mismatch",
+          "[config]") {
+  clean();
+  TestStore store;
+  save(store, 1);
+  save(store, 2);
+  auto file = readFile(Path);
+  // {"v":2} -> {"v":3}, still valid JSON, but the CRC no longer matches
+  file[file.size() - 2] = '3';
+  writeFile(Path, file.data(), file.size());
+  TEST_ASSERT_EQUAL(1, valueOf(store.read()));
+  clean();
+}
+
+TEST_CASE("config::Vfs rejects a size mismatch", "[config]") {
+  clean();
+  TestStore store;
+  save(store, 1);
+  unlink(Backup);
+  auto file = readFile(Path);
+  file.push_back(' ');
+  writeFile(Path, file.data(), file.size());
+  TEST_ASSERT_NULL(store.read());
+  clean();
+}
+
+TEST_CASE("config::Vfs reads the headerless format", "[config]") {
+  clean();
+  const char json[] = "{\"v\":7}";
+  std::vector<uint8_t> file(4);
+  uint32_t size = sizeof(json) - 1;
+  memcpy(file.data(), &size, 4);
+  file.insert(file.end(), json, json + size);
+  writeFile(Path, file.data(), file.size());
+  TestStore store;
+  TEST_ASSERT_EQUAL(7, valueOf(store.read()));
+  clean();
+}
+
+TEST_CASE("config::Vfs reset removes the file and its backup", "[config]") {
+  clean();
+  TestStore store;
+  save(store, 1);
+  save(store, 2);
+  store.reset();
+  TEST_ASSERT_FALSE(exists(Path));
+  TEST_ASSERT_FALSE(exists(Backup));
+  TEST_ASSERT_NULL(store.read());
+}
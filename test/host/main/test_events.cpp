@@ -0,0 +1,90 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "esp32m/events.hpp"
+
+using namespace esp32m;
+
+TEST_CASE("Event::is compares the type string", "[events]") {
+  std::string type = "test-is";
+  Event ev("test-is");
+  TEST_ASSERT_TRUE(ev.is(type.c_str()));
+  TEST_ASSERT_FALSE(ev.is("test-is-not"));
+  TEST_ASSERT_FALSE(ev.is(nullptr));
+}
+
+TEST_CASE("publish reaches every subscriber in order", "[events]") {
+  std::vector<int> calls;
+  auto &em = EventManager::instance();
+  auto a = em.subscribe([&](Event &ev) {
+    if (ev.is("test-order"))
+      calls.push_back(1);
+  });
+  auto b = em.subscribe([&](Event &ev) {
+    if (ev.is("test-order"))
+      calls.push_back(2);
+  });
+  Event ev("test-order");
+  ev.publish();
+  em.publishBackwards(ev);
+  delete b;
+  delete a;
+  TEST_ASSERT_EQUAL(4, calls.size());
+  TEST_ASSERT_EQUAL(1, calls[0]);
+  TEST_ASSERT_EQUAL(2, calls[1]);
+  TEST_ASSERT_EQUAL(2, calls[2]);
+  TEST_ASSERT_EQUAL(1, calls[3]);
+}
+
+TEST_CASE("deleted subscriptions stop receiving events", "[events]") {
+  int count = 0;
+  auto &em = EventManager::instance();
+  auto sub = em.subscribe([&](Event &ev) {
+    if (ev.is("test-unsub"))
+      count++;
+  });
+  Event ev("test-unsub");
+  ev.publish();
+  delete sub;
+  ev.publish();
+  TEST_ASSERT_EQUAL(1, count);
+}
+
+TEST_CASE("vacated subscription slots are reused", "[events]") {
+  int count = 0;
+  auto &em = EventManager::instance();
+  auto first = em.subscribe([](Event &) {});
+  delete first;
+  auto second = em.subscribe([&](Event &ev) {
+    if (ev.is("test-reuse"))
+      count++;
+  });
+  Event ev("test-reuse");
+  ev.publish();
+  delete second;
+  TEST_ASSERT_EQUAL(1, count);
+}
+
+TEST_CASE("subscribers may unsubscribe others while dispatching",
+          "[events]") {
+  int count = 0;
+  auto &em = EventManager::instance();
+  Subscription *victim = nullptr;
+  auto killer = em.subscribe([&](Event &ev) {
+    if (ev.is("test-kill") && victim) {
+      delete victim;
+      victim = nullptr;
+    }
+  });
+  victim = em.subscribe([&](Event &ev) {
+    if (ev.is("test-kill"))
+      count++;
+  });
+  Event ev("test-kill");
+  ev.publish();
+  delete killer;
+  TEST_ASSERT_NULL(victim);
+  TEST_ASSERT_EQUAL(0, count);
+}
@@ -0,0 +1,23 @@
+#include <unity.h>
+
+#include <string>
+
+#include "esp32m/integrations/influx/line_protocol.hpp"
+
+using namespace esp32m::integrations::influx;
+
+TEST_CASE("line protocol escapes separators", "[influx]") {
+  TEST_ASSERT_EQUAL_STRING("plain", escapeLineProtocolValue("plain").c_str());
+  TEST_ASSERT_EQUAL_STRING("a\\ b", escapeLineProtocolValue("a b").c_str());
+  TEST_ASSERT_EQUAL_STRING("a\\,b\\=c",
+                           escapeLineProtocolValue("a,b=c").c_str());
+  TEST_ASSERT_EQUAL_STRING("c:\\\\dir",
+                           escapeLineProtocolValue("c:\\dir").c_str());
+  TEST_ASSERT_EQUAL_STRING("\"quoted\"",
+                           escapeLineProtocolValue("\"quoted\"").c_str());
+}
+
+TEST_CASE("line protocol escaping handles empty input", "[influx]") {
+  TEST_ASSERT_EQUAL_STRING("", escapeLineProtocolValue("").c_str());
+  TEST_ASSERT_EQUAL_STRING("", escapeLineProtocolValue(nullptr).c_str());
+}
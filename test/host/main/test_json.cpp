@@ -0,0 +1,132 @@
+#include <unity.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "esp32m/json.hpp"
+
+using namespace esp32m;
+
+TEST_CASE("json::parse accepts valid documents", "[json]") {
+  std::unique_ptr<JsonDocument> doc(json::parse("{\"a\":1,\"b\":[true,\"x\"]}"));
+  TEST_ASSERT_NOT_NULL(doc.get());
+  TEST_ASSERT_EQUAL(1, (*doc)["a"].as<int>());
+  TEST_ASSERT_TRUE((*doc)["b"][0].as<bool>());
+  TEST_ASSERT_EQUAL_STRING("x", (*doc)["b"][1].as<const char *>());
+}
+
+TEST_CASE("json::parse honours the explicit length", "[json]") {
+  const char *data = "[1,2]garbage";
+  std::unique_ptr<JsonDocument> doc(json::parse(data, 5));
+  TEST_ASSERT_NOT_NULL(doc.get());
+  TEST_ASSERT_EQUAL(2, doc->as<JsonArrayConst>().size());
+}
+
+TEST_CASE("json::parse reports errors", "[json]") {
+  DeserializationError error;
+  TEST_ASSERT_NULL(json::parse("{\"a\":", &error));
+  TEST_ASSERT_TRUE(error == DeserializationError::IncompleteInput);
+  TEST_ASSERT_NULL(json::parse("", &error));
+  TEST_ASSERT_TRUE(error == DeserializationError::EmptyInput);
+  TEST_ASSERT_NULL(json::parse(nullptr, &error));
+}
+
+TEST_CASE("ConcatToObject keys documents by name", "[json]") {
+  json::ConcatToObject c;
+  c.add("first", json::parse("{\"v\":1}"));
+  c.add("second", json::parse("[1,2,3]"));
+  std::unique_ptr<JsonDocument> doc(c.concat());
+  std::string out;
+  serializeJson(*doc, out);
+  TEST_ASSERT_EQUAL_STRING("{\"first\":{\"v\":1},\"second\":[1,2,3]}",
+                           out.c_str());
+}
+
+TEST_CASE("json::from reports changes only when the value differs",
+          "[json]") {
+  std::unique_ptr<JsonDocument> doc(json::parse("{\"n\":5,\"s\":\"abc\"}"));
+  auto root = doc->as<JsonObjectConst>();
+  int n = 5;
+  bool changed = false;
+  TEST_ASSERT_FALSE(json::from(root["n"], n, &changed));
+  TEST_ASSERT_FALSE(changed);
+  n = 1;
+  TEST_ASSERT_TRUE(json::from(root["n"], n, &changed));
+  TEST_ASSERT_TRUE(changed);
+  TEST_ASSERT_EQUAL(5, n);
+
+  int untouched = 7;
+  changed = false;
+  TEST_ASSERT_FALSE(json::from(root["missing"], untouched, &changed));
+  TEST_ASSERT_EQUAL(7, untouched);
+  TEST_ASSERT_FALSE(changed);
+
+  std::string s;
+  TEST_ASSERT_TRUE(json::from(root["s"], s, &changed));
+  TEST_ASSERT_EQUAL_STRING("abc", s.c_str());
+}
+
+TEST_CASE("json::checkEqual compares serialized forms", "[json]") {
+  std::unique_ptr<JsonDocument> a(json::parse("{\"x\":[1,2]}"));
+  std::unique_ptr<JsonDocument> b(json::parse("{ \"x\" : [ 1, 2 ] }"));
+  TEST_ASSERT_TRUE(json::checkEqual(a->as<JsonVariantConst>(),
+                                    b->as<JsonVariantConst>()));
+}
+
+namespace {
+  class StringSink : public stream::Writer {
+   public:
+    std::string text;
+    size_t limit = SIZE_MAX;
+    size_t write(const uint8_t *buf, size_t size) override {
+      size = std::min(size, limit - text.size());
+      text.append((const char *)buf, size);
+      return size;
+    }
+  };
+}  // namespace
+
+TEST_CASE("json::Writer produces what ArduinoJson would", "[json]") {
+  std::unique_ptr<JsonDocument> doc(json::parse("{\"v\":[1,{\"x\":null}]}"));
+  StringSink sink;
+  json::Writer w(sink);
+  w.beginObject();
+  w.member("s", "a\"b\\c\n\x01");
+  w.member("n", -5);
+  w.member("u", (uint32_t)4000000000);
+  w.member("b", true);
+  w.member("f", 1.5);
+  w.key("empty");
+  w.beginArray();
+  w.endArray();
+  w.key("list");
+  w.beginArray();
+  w.value(1);
+  w.value(nullptr);
+  w.beginObject();
+  w.endObject();
+  w.endArray();
+  w.member("doc", doc->as<JsonVariantConst>());
+  w.endObject();
+  TEST_ASSERT_TRUE(w.ok());
+  TEST_ASSERT_EQUAL_STRING(
+      "{\"s\":\"a\\\"b\\\\c\\n\\u0001\",\"n\":-5,\"u\":4000000000,\"b\":true,"
+      "\"f\":1.5,\"empty\":[],\"list\":[1,null,{}],"
+      "\"doc\":{\"v\":[1,{\"x\":null}]}}",
+      sink.text.c_str());
+  std::unique_ptr<JsonDocument> back(json::parse(sink.text.c_str()));
+  TEST_ASSERT_NOT_NULL(back.get());
+}
+
+TEST_CASE("json::Writer stops when the stream is full", "[json]") {
+  StringSink sink;
+  sink.limit = 4;
+  json::Writer w(sink);
+  w.beginArray();
+  w.value("abcdef");
+  TEST_ASSERT_FALSE(w.ok());
+  w.endArray();
+  TEST_ASSERT_EQUAL_STRING("[\"ab", sink.text.c_str());
+}
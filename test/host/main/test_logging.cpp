@@ -0,0 +1,84 @@
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "harness.hpp"
+
+using namespace esp32m;
+using esp32m::host::CaptureAppender;
+
+namespace {
+  class Capture {
+   public:
+    CaptureAppender appender;
+    Capture() {
+      log::addAppender(&appender);
+    }
+    ~Capture() {
+      log::removeAppender(&appender);
+    }
+  };
+}  // namespace
+
+TEST_CASE("LogMessage packs name, task and text", "[logging]") {
+  auto msg = log::LogMessage::alloc(log::Level::Warning, 1234, "unit",
+                                    "hello world");
+  TEST_ASSERT_NOT_NULL(msg);
+  TEST_ASSERT_EQUAL(log::Level::Warning, msg->level());
+  TEST_ASSERT_EQUAL_INT64(1234, msg->stamp());
+  TEST_ASSERT_EQUAL_STRING("unit", msg->name());
+  TEST_ASSERT_EQUAL(4, msg->namelen());
+  TEST_ASSERT_EQUAL_STRING("hello world", msg->message());
+  TEST_ASSERT_EQUAL(strlen("hello world") + 1, msg->messagelen());
+  TEST_ASSERT_EQUAL(strlen(msg->task()), msg->tasklen());
+  free(msg);
+}
+
+TEST_CASE("default formatter renders uptime stamps", "[logging]") {
+  auto msg = log::LogMessage::alloc(log::Level::Info, 90061001, "fmt", "text");
+  auto str = log::formatter()(msg);
+  TEST_ASSERT_NOT_NULL(str);
+  std::string s(str);
+  free(str);
+  free(msg);
+  TEST_ASSERT_EQUAL(0, s.find("1:01:01:01.001 I ["));
+  TEST_ASSERT_NOT_EQUAL(std::string::npos, s.find("] fmt  text"));
+}
+
+TEST_CASE("appenders receive formatted messages", "[logging]") {
+  Capture capture;
+  log::SimpleLoggable loggable("capture");
+  loggable.logger().setLevel(log::Level::Debug);
+  loggable.logger().logf(log::Level::Info, "value=%d", 42);
+  std::string longText(200, 'x');
+  loggable.logger().logf(log::Level::Info, "%s", longText.c_str());
+  TEST_ASSERT_EQUAL(2, capture.appender.lines.size());
+  TEST_ASSERT_EQUAL_STRING("value=42", capture.appender.lines[0].c_str());
+  TEST_ASSERT_EQUAL_STRING(longText.c_str(),
+                           capture.appender.lines[1].c_str());
+}
+
+TEST_CASE("logger level filters messages", "[logging]") {
+  Capture capture;
+  log::SimpleLoggable loggable("filter");
+  loggable.logger().setLevel(log::Level::Warning);
+  loggable.logger().log(log::Level::Info, "dropped");
+  loggable.logger().log(log::Level::Error, "kept");
+  loggable.logger().log(log::Level::Warning, "   ");
+  TEST_ASSERT_EQUAL(1, capture.appender.lines.size());
+  TEST_ASSERT_EQUAL_STRING("kept", capture.appender.lines[0].c_str());
+}
+
+TEST_CASE("removed appenders stop receiving messages", "[logging]") {
+  CaptureAppender appender;
+  log::SimpleLoggable loggable("remove");
+  loggable.logger().setLevel(log::Level::Debug);
+  log::addAppender(&appender);
+  log::addAppender(&appender);
+  loggable.logger().log(log::Level::Info, "one");
+  log::removeAppender(&appender);
+  loggable.logger().log(log::Level::Info, "two");
+  TEST_ASSERT_EQUAL(1, appender.lines.size());
+}
@@ -0,0 +1,30 @@
+#include <unity.h>
+
+#include <string>
+
+#include "esp32m/net/mqtt_topic.hpp"
+
+using esp32m::net::mqttTopicMatchesFilter;
+
+TEST_CASE("mqtt filters match literal topics", "[mqtt]") {
+  TEST_ASSERT_TRUE(mqttTopicMatchesFilter("a/b/c", "a/b/c"));
+  TEST_ASSERT_FALSE(mqttTopicMatchesFilter("a/b/c", "a/b/d"));
+  TEST_ASSERT_FALSE(mqttTopicMatchesFilter("a/b", "a/b/c"));
+  TEST_ASSERT_FALSE(mqttTopicMatchesFilter("a/b/c", "a/b"));
+}
+
+TEST_CASE("mqtt single-level wildcard", "[mqtt]") {
+  TEST_ASSERT_TRUE(mqttTopicMatchesFilter("a/+/c", "a/b/c"));
+  TEST_ASSERT_TRUE(mqttTopicMatchesFilter("+/b/c", "a/b/c"));
+  TEST_ASSERT_TRUE(mqttTopicMatchesFilter("a/b/+", "a/b/c"));
+  TEST_ASSERT_FALSE(mqttTopicMatchesFilter("a/+/c", "a/b/x/c"));
+  TEST_ASSERT_FALSE(mqttTopicMatchesFilter("a/+", "a/b/c"));
+}
+
+TEST_CASE("mqtt multi-level wildcard", "[mqtt]") {
+  TEST_ASSERT_TRUE(mqttTopicMatchesFilter("#", "a/b/c"));
+  TEST_ASSERT_TRUE(mqttTopicMatchesFilter("a/#", "a/b/c"));
+  TEST_ASSERT_TRUE(mqttTopicMatchesFilter("a/+/#", "a/b/c/d"));
+  TEST_ASSERT_FALSE(mqttTopicMatchesFilter("b/#", "a/b/c"));
+  TEST_ASSERT_FALSE(mqttTopicMatchesFilter("a/#/c", "a/b/c"));
+}
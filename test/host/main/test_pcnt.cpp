@@ -0,0 +1,48 @@
+#include <unity.h>
+
+#include <climits>
+
+#include "esp32m/io/pcnt_count.hpp"
+
+using namespace esp32m::io;
+
+namespace {
+  // what the driver reports with accum_count and both limits watched: the
+  // hardware counter restarts from 0 at a limit and the limit is added to
+  // the accumulator
+  struct Unit {
+    int hw = 0, accum = 0;
+    void pulse(int n) {
+      while (n--)
+        if (++hw == pcnt::HighLimit) {
+          accum += pcnt::HighLimit;
+          hw = 0;
+        }
+    }
+    int read() const {
+      return accum + hw;
+    }
+  };
+}  // namespace
+
+TEST_CASE("pcnt count delta crosses the hardware limit", "[pcnt]") {
+  Unit unit;
+  unit.pulse(pcnt::HighLimit - 10);
+  auto prev = unit.read();
+  unit.pulse(25);
+  TEST_ASSERT_EQUAL(25, pcnt::countDelta(prev, unit.read()));
+  prev = unit.read();
+  unit.pulse(3 * pcnt::HighLimit);
+  TEST_ASSERT_EQUAL(3 * pcnt::HighLimit, pcnt::countDelta(prev, unit.read()));
+}
+
+TEST_CASE("pcnt count delta keeps the direction", "[pcnt]") {
+  TEST_ASSERT_EQUAL(0, pcnt::countDelta(100, 100));
+  TEST_ASSERT_EQUAL(-10, pcnt::countDelta(5, -5));
+  TEST_ASSERT_EQUAL(10, pcnt::countDelta(-5, 5));
+}
+
+TEST_CASE("pcnt count delta survives the int wrap", "[pcnt]") {
+  TEST_ASSERT_EQUAL(6, pcnt::countDelta(INT_MAX - 2, INT_MIN + 3));
+  TEST_ASSERT_EQUAL(-6, pcnt::countDelta(INT_MIN + 3, INT_MAX - 2));
+}
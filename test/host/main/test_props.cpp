@@ -0,0 +1,63 @@
+#include <unity.h>
+
+#include <string>
+#include <vector>
+
+#include "esp32m/props.hpp"
+
+using namespace esp32m;
+
+TEST_CASE("Props stores and returns values", "[props]") {
+  Props props("test-props");
+  TEST_ASSERT_FALSE(props.has("a"));
+  TEST_ASSERT_EQUAL_STRING("", props.get("a").c_str());
+  props.set("a", "1");
+  props.set("b", "2");
+  TEST_ASSERT_TRUE(props.has("a"));
+  TEST_ASSERT_EQUAL_STRING("1", props.get("a").c_str());
+  auto all = props.get();
+  TEST_ASSERT_EQUAL(2, all.size());
+  TEST_ASSERT_EQUAL_STRING("2", all["b"].c_str());
+}
+
+TEST_CASE("Props publishes changes only", "[props]") {
+  struct Change {
+    std::string key, prev, next;
+  };
+  std::vector<Change> changes;
+  auto sub = EventManager::instance().subscribe([&](Event &ev) {
+    if (EventPropChanged::is(ev, "test-props-ev")) {
+      auto &e = (EventPropChanged &)ev;
+      changes.push_back({e.key(), e.prev(), e.next()});
+    }
+  });
+  Props props("test-props-ev");
+  Props other("test-props-other");
+  props.set("k", "v1");
+  props.set("k", "v1");
+  props.set("k", "v2");
+  other.set("k", "x");
+  delete sub;
+  TEST_ASSERT_EQUAL(2, changes.size());
+  TEST_ASSERT_EQUAL_STRING("k", changes[0].key.c_str());
+  TEST_ASSERT_EQUAL_STRING("", changes[0].prev.c_str());
+  TEST_ASSERT_EQUAL_STRING("v1", changes[0].next.c_str());
+  TEST_ASSERT_EQUAL_STRING("v1", changes[1].prev.c_str());
+  TEST_ASSERT_EQUAL_STRING("v2", changes[1].next.c_str());
+}
+
+TEST_CASE("EventPropChanged filters by name and key", "[props]") {
+  int all = 0, byKey = 0;
+  auto sub = EventManager::instance().subscribe([&](Event &ev) {
+    if (EventPropChanged::is(ev, "test-props-key"))
+      all++;
+    if (EventPropChanged::is(ev, "test-props-key", "wanted"))
+      byKey++;
+  });
+  Props props("test-props-key");
+  props.set("wanted", "1");
+  props.set("other", "1");
+  delete sub;
+  TEST_ASSERT_EQUAL(2, all);
+  TEST_ASSERT_EQUAL(1, byKey);
+}
@@ -0,0 +1,111 @@
+#include <unity.h>
+
+#include <string.h>
+#include <vector>
+
+#include "esp32m/bus/twai/router.hpp"
+
+using namespace esp32m;
+
+namespace {
+
+  // Stand-in for a TWAI node: keeps what it was given, or hands it straight
+  // back to a router as if it had been received
+  class Loopback : public twai::Node {
+   public:
+    std::vector<uint32_t> sent;
+    twai::Router *echo = nullptr;
+    int capacity = 64;
+    esp_err_t transmit(const twai_frame_t *frame) override {
+      if ((int)sent.size() >= capacity)
+        return ESP_ERR_TIMEOUT;
+      sent.push_back(frame->header.id);
+      if (echo)
+        echo->dispatch(*frame);
+      return ESP_OK;
+    }
+  };
+
+  twai_frame_t frame(uint32_t id, uint8_t *data = nullptr, size_t len = 0) {
+    twai_frame_t f = {};
+    f.header.id = id;
+    f.header.dlc = len;
+    f.buffer = data;
+    f.buffer_len = len;
+    return f;
+  }
+
+}  // namespace
+
+TEST_CASE("router dispatches by exact id and by mask", "[twai]") {
+  Loopback node;
+  twai::Router router(&node);
+  std::vector<int> calls;
+  router.on(0x523, [&](const twai_frame_t &) { calls.push_back(1); });
+  auto masked =
+      router.on(0x100, 0x700, [&](const twai_frame_t &) { calls.push_back(2); });
+  router.dispatch(frame(0x523));
+  router.dispatch(frame(0x1FF));
+  router.dispatch(frame(0x200));
+  router.off(masked);
+  router.dispatch(frame(0x1FF));
+  TEST_ASSERT_EQUAL(2, calls.size());
+  TEST_ASSERT_EQUAL(1, calls[0]);
+  TEST_ASSERT_EQUAL(2, calls[1]);
+  auto stats = router.stats();
+  TEST_ASSERT_EQUAL(4, stats.rx);
+  TEST_ASSERT_EQUAL(2, stats.unhandled);
+}
+
+TEST_CASE("router sends by priority and id and copies the payload",
+          "[twai]") {
+  Loopback node;
+  twai::Router router(&node);
+  node.echo = &router;
+  uint8_t received = 0;
+  router.on(0x10, [&](const twai_frame_t &f) { received = f.buffer[0]; });
+  uint8_t data = 42;
+  TEST_ASSERT_EQUAL(ESP_OK, router.send(frame(0x20), 1));
+  TEST_ASSERT_EQUAL(ESP_OK, router.send(frame(0x10, &data, 1), 1));
+  data = 0;
+  TEST_ASSERT_EQUAL(ESP_OK, router.send(frame(0x30), 0));
+  TEST_ASSERT_EQUAL(-1, router.pump(0));
+  TEST_ASSERT_EQUAL(3, node.sent.size());
+  TEST_ASSERT_EQUAL(0x30, node.sent[0]);
+  TEST_ASSERT_EQUAL(0x10, node.sent[1]);
+  TEST_ASSERT_EQUAL(0x20, node.sent[2]);
+  TEST_ASSERT_EQUAL(42, received);
+}
+
+TEST_CASE("router holds frames until the node has room", "[twai]") {
+  Loopback node;
+  twai::Router router(&node, 2, 1);
+  TEST_ASSERT_EQUAL(ESP_OK, router.send(frame(1)));
+  TEST_ASSERT_EQUAL(ESP_OK, router.send(frame(2)));
+  TEST_ASSERT_EQUAL(ESP_ERR_NO_MEM, router.send(frame(3)));
+  router.pump(0);
+  TEST_ASSERT_EQUAL(1, node.sent.size());
+  TEST_ASSERT_EQUAL(1, router.queued());
+  router.txDone();
+  router.pump(0);
+  TEST_ASSERT_EQUAL(2, node.sent.size());
+  TEST_ASSERT_EQUAL(1, router.stats().txDropped);
+}
+
+TEST_CASE("router spaces out rate limited ids", "[twai]") {
+  Loopback node;
+  twai::Router router(&node);
+  router.setRateLimit(0x42, 1000);
+  for (int i = 0; i < 3; i++)
+    router.send(frame(0x42));
+  router.send(frame(0x43));
+  TEST_ASSERT_EQUAL(1000, router.pump(0));
+  TEST_ASSERT_EQUAL(2, node.sent.size());
+  TEST_ASSERT_EQUAL(400, router.pump(600));
+  TEST_ASSERT_EQUAL(2, node.sent.size());
+  TEST_ASSERT_EQUAL(1000, router.pump(1000));
+  TEST_ASSERT_EQUAL(3, node.sent.size());
+  TEST_ASSERT_EQUAL(-1, router.pump(2000));
+  TEST_ASSERT_EQUAL(4, node.sent.size());
+  TEST_ASSERT_EQUAL(2, router.stats().txLimited);
+}
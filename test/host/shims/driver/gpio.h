@@ -0,0 +1,9 @@
+#pragma once
+
+// Host stand-in: only the pin type esp32m/base.hpp needs for lock tables
+
+typedef enum {
+  GPIO_NUM_NC = -1,
+  GPIO_NUM_0 = 0,
+  GPIO_NUM_MAX = 64,
+} gpio_num_t;
@@ -0,0 +1,3 @@
+#pragma once
+
+typedef struct esp_http_client *esp_http_client_handle_t;
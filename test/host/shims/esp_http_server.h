@@ -0,0 +1,3 @@
+#pragma once
+
+typedef struct httpd_req httpd_req_t;
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <arpa/inet.h>
+#include <stdint.h>
+
+#define ESP_ERR_ESP_NETIF_BASE 0x5000
+#define ESP_ERR_ESP_NETIF_DHCP_ALREADY_STARTED (ESP_ERR_ESP_NETIF_BASE + 0x04)
+#define ESP_ERR_ESP_NETIF_DHCP_ALREADY_STOPPED (ESP_ERR_ESP_NETIF_BASE + 0x05)
+
+typedef struct {
+  uint32_t addr;
+} esp_ip4_addr_t;
+
+#define esp_ip4_addr1(ipaddr) (((const uint8_t *)(ipaddr))[0])
+#define esp_ip4_addr2(ipaddr) (((const uint8_t *)(ipaddr))[1])
+#define esp_ip4_addr3(ipaddr) (((const uint8_t *)(ipaddr))[2])
+#define esp_ip4_addr4(ipaddr) (((const uint8_t *)(ipaddr))[3])
+#define ESP_IP4TOADDR(a, b, c, d) \
+  htonl(((uint32_t)(a) << 24) | ((b) << 16) | ((c) << 8) | (d))
@@ -0,0 +1,12 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void esp_rom_install_channel_putc(int channel, void (*putc)(char c));
+void esp_rom_output_putc(char c);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,25 @@
+#pragma once
+
+// Host stand-in: only the frame type the TWAI router works with
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TWAI_FRAME_MAX_LEN 64
+
+typedef struct {
+  uint32_t id;
+  uint16_t dlc;
+  uint16_t ide : 1;
+  uint16_t rtr : 1;
+  uint16_t fdf : 1;
+  uint16_t brs : 1;
+  uint16_t esi : 1;
+  uint64_t timestamp;
+} twai_frame_header_t;
+
+typedef struct {
+  twai_frame_header_t header;
+  uint8_t *buffer;
+  size_t buffer_len;
+} twai_frame_t;
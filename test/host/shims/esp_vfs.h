@@ -0,0 +1,3 @@
+#pragma once
+
+// config::Vfs only needs the POSIX file API, which the host provides
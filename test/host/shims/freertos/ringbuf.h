@@ -0,0 +1,33 @@
+#pragma once
+
+#include <freertos/FreeRTOS.h>
+
+// Host stand-in: the log queue is never started by the harness, so only the
+// declarations logging.cpp compiles against are provided
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *RingbufHandle_t;
+
+typedef enum {
+  RINGBUF_TYPE_NOSPLIT = 0,
+  RINGBUF_TYPE_ALLOWSPLIT,
+  RINGBUF_TYPE_BYTEBUF,
+  RINGBUF_TYPE_MAX,
+} RingbufferType_t;
+
+RingbufHandle_t xRingbufferCreate(size_t xBufferSize,
+                                  RingbufferType_t xBufferType);
+size_t xRingbufferGetMaxItemSize(RingbufHandle_t xRingbuffer);
+BaseType_t xRingbufferSend(RingbufHandle_t xRingbuffer, const void *pvItem,
+                           size_t xItemSize, TickType_t xTicksToWait);
+void *xRingbufferReceive(RingbufHandle_t xRingbuffer, size_t *pxItemSize,
+                         TickType_t xTicksToWait);
+void vRingbufferReturnItem(RingbufHandle_t xRingbuffer, void *pvItem);
+void vRingbufferDelete(RingbufHandle_t xRingbuffer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int ets_printf(const char *fmt, ...);
+void ets_install_putc1(void (*p)(char c));
+void ets_install_uart_printf(void);
+
+#ifdef __cplusplus
+}
+#endif